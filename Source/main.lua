@@ -3,14 +3,62 @@ import "CoreLibs/graphics"
 local pd <const> = playdate
 local gfx <const> = pd.graphics
 
-local playerX, playerY = 200, 120
-local playerRadius = 15
-local playerSpeed = 1.5
-
-function pd.update()
-    gfx.clear()
-    local crankAngle = math.rad(pd.getCrankPosition())
-    playerX += math.sin(crankAngle) * playerSpeed
-    playerY -= math.cos(crankAngle) * playerSpeed
-    gfx.fillCircleAtPoint(playerX, playerY, playerRadius)
-end
\ No newline at end of file
+if playsics then
+    -- Built with PLAYSICS_LUA: the C engine simulates and renders, Lua only
+    -- steers it, one bulk call per batch rather than per particle
+    local first, count = playsics.spawn(300, 40, 20, 100, 60)
+    local positions = {}
+    local inBucket = 0
+
+    -- Fills a reused flat table {x1, y1, x2, y2, ...} from one playsics.positions read
+    local function readPositions(t, from, n)
+        local bytes = playsics.positions(from, n)
+        local pos = 1
+        for i = 1, #bytes // 4, 2 do
+            t[i], t[i + 1], pos = string.unpack("ff", bytes, pos)
+        end
+        return #bytes // 8
+    end
+
+    function pd.update()
+        -- The crank swings an attractor around the middle of the screen
+        local crankAngle = math.rad(pd.getCrankPosition())
+        playsics.force(200 + math.sin(crankAngle) * 100, 120 - math.cos(crankAngle) * 100, 80, -600, first, count)
+
+        if pd.buttonJustPressed(pd.kButtonUp) then
+            local _, spawned = playsics.spawn(100, 150, 20, 100, 20)
+            count += spawned
+        end
+
+        playsics.update()
+
+        -- B reloads the saved snapshot during the update, which can change how many particles there are
+        if pd.buttonJustPressed(pd.kButtonB) then
+            count = math.max(playsics.count() - first, 0)
+        end
+
+        local n = readPositions(positions, first, count)
+        local bucket = 0
+        for i = 1, n * 2, 2 do
+            if positions[i] < 80 and positions[i + 1] > 200 then
+                bucket += 1
+            end
+        end
+        if bucket ~= inBucket then
+            inBucket = bucket
+            print(inBucket .. " particles in the bucket")
+        end
+    end
+else
+    local playerX, playerY = 200, 120
+    local playerRadius = 15
+    local playerSpeed = 1.5
+
+    function pd.update()
+        gfx.clear()
+        local crankAngle = math.rad(pd.getCrankPosition())
+        playerX += math.sin(crankAngle) * playerSpeed
+        playerY -= math.cos(crankAngle) * playerSpeed
+        gfx.fillCircleAtPoint(playerX, playerY, playerRadius)
+    end
+end
@@ -0,0 +1,47 @@
+#ifndef DEBUG_DRAW_H
+#define DEBUG_DRAW_H
+
+/*
+ * Physics visualization that any module can push to. Commands are recorded
+ * into a fixed buffer and rasterized in one pass when the renderer flushes.
+ * Without PLAYSICS_DEBUG_DRAW every DEBUG_DRAW_* macro expands to nothing
+ * and none of this is compiled.
+ */
+#ifdef PLAYSICS_DEBUG_DRAW
+
+void debug_draw_set_enabled(bool enabled);
+bool debug_draw_enabled(void);
+void debug_draw_begin(void);
+
+void debug_draw_line(float x0, float y0, float x1, float y1);
+void debug_draw_circle(float x, float y, float radius);
+void debug_draw_aabb(float min_x, float min_y, float max_x, float max_y);
+void debug_draw_point(float x, float y);
+void debug_draw_normal(float x, float y, float nx, float ny, float length);
+
+RasterRect debug_draw_bounds(void);
+void debug_draw_flush(RasterTarget* target);
+
+#define DEBUG_DRAW_BEGIN()                        debug_draw_begin()
+#define DEBUG_DRAW_LINE(x0, y0, x1, y1)           debug_draw_line(x0, y0, x1, y1)
+#define DEBUG_DRAW_CIRCLE(x, y, radius)           debug_draw_circle(x, y, radius)
+#define DEBUG_DRAW_AABB(min_x, min_y, max_x, max_y) debug_draw_aabb(min_x, min_y, max_x, max_y)
+#define DEBUG_DRAW_POINT(x, y)                    debug_draw_point(x, y)
+#define DEBUG_DRAW_NORMAL(x, y, nx, ny, length)   debug_draw_normal(x, y, nx, ny, length)
+
+/* A contact is its point plus a short normal */
+#define DEBUG_DRAW_CONTACT(x, y, nx, ny)          debug_draw_normal(x, y, nx, ny, 6.0f)
+
+#else
+
+#define DEBUG_DRAW_BEGIN()                        ((void)0)
+#define DEBUG_DRAW_LINE(x0, y0, x1, y1)           ((void)0)
+#define DEBUG_DRAW_CIRCLE(x, y, radius)           ((void)0)
+#define DEBUG_DRAW_AABB(min_x, min_y, max_x, max_y) ((void)0)
+#define DEBUG_DRAW_POINT(x, y)                    ((void)0)
+#define DEBUG_DRAW_NORMAL(x, y, nx, ny, length)   ((void)0)
+#define DEBUG_DRAW_CONTACT(x, y, nx, ny)          ((void)0)
+
+#endif // PLAYSICS_DEBUG_DRAW
+
+#endif // !DEBUG_DRAW_H
@@ -14,6 +14,90 @@
 #define SCREEN_HEIGHT 240
 
 #define FPS        30.0
-#define LOGIC_RATE (FPS / 1000)
+#define LOGIC_RATE (1.0 / FPS)
+
+/* Fixed-step scheduler limits */
+#define MAX_SUBSTEPS   4
+#define MAX_FRAME_TIME 0.25f
+
+/* Call sites the tracked allocator keeps separate statistics for */
+#define MEMORY_MAX_SITES 64
+
+/* Scratch memory for one frame, released when the next frame begins */
+#define FRAME_ARENA_SIZE (512 * 1024)
+
+#define MAX_PARTICLES   4096
+#define PARTICLE_RADIUS 2.0f
+
+/* Broadphase grid cells must be at least one particle diameter wide */
+#define BROADPHASE_CELL_SIZE 8.0f
+#define MAX_PARTICLE_PAIRS   (MAX_PARTICLES * 4)
+
+/* Starting room for the sweep's pair set and per-update changes (PLAYSICS_SWEEP_PRUNE); both grow when full */
+#define SWEEP_PAIRS_PER_PARTICLE 8
+#define SWEEP_CHANGES_PER_PARTICLE 2
+
+#define GRAVITY 160.0f
+
+/* Sprite cache for body shapes */
+#define SHAPE_CACHE_BUDGET      (96 * 1024)
+#define SHAPE_CACHE_MAX_ENTRIES 64
+#define SHAPE_SHADE_LEVELS      17
+#define SHAPE_ROTATION_STEPS    32
+
+/* Debug-draw commands recorded per step (PLAYSICS_DEBUG_DRAW builds only) */
+#define DEBUG_DRAW_MAX_COMMANDS 2048
+
+/* Profiler CSV dump, relative to the game's data folder */
+#define PROFILER_CSV_PATH "profile.csv"
+
+/* Position-based dynamics solver */
+#define PBD_ITERATIONS      8
+#define MAX_PBD_CONSTRAINTS (MAX_PARTICLES * 2)
+#define MAX_PBD_PINS        64
+
+/* Force generators */
+#define MAX_FORCE_FIELDS  16
+#define MAX_FORCE_SPRINGS 1024
+
+/* Attractors playsics.force can have in play during one playsics.update */
+#define LUA_FORCE_FIELDS 4
+
+/* Rigid bodies; lengths are in pixels */
+#define MAX_BODIES            256
+#define MAX_BODY_CONTACTS     (MAX_BODIES * 4)
+#define BODY_ITERATIONS       10
+#define BODY_CONTACT_MARGIN   1.0f
+#define BODY_LINEAR_SLOP      0.5f
+#define BODY_BAUMGARTE        0.2f
+#define BODY_BOUNCE_THRESHOLD 20.0f
+
+/* Resting bodies wider than this (a floor, a wall) are checked against every awake body */
+#define BODY_WIDE_EXTENT 64.0f
+
+/* An island sleeps once all its bodies moved slower than this for long enough */
+#define BODY_SLEEP_LINEAR   1.0f
+#define BODY_SLEEP_ANGULAR  0.035f
+#define BODY_TIME_TO_SLEEP  0.5f
+
+/* A cached manifold is reused while b moves less than this relative to a */
+#define CONTACT_CACHE_LINEAR_TOL  0.05f
+#define CONTACT_CACHE_ANGULAR_TOL 0.002f
+
+/* Rewind history: the last REWIND_SECONDS of steps within a fixed byte budget */
+#define REWIND_SECONDS       10
+#define REWIND_MAX_FRAMES    (int)(REWIND_SECONDS * FPS)
+#define REWIND_BUDGET        (512 * 1024)
+#define REWIND_CRANK_DEGREES 4.0f
+#define REWIND_BUTTON        kButtonDown
+
+/* World snapshot, relative to the game's data folder */
+#define SNAPSHOT_PATH "snapshot.bin"
+
+/* Input recording (PLAYSICS_RECORD_INPUT builds), relative to the game's data folder */
+#define INPUT_RECORD_PATH   "input.rec"
+#define INPUT_RECORD_BLOCK  256
+#define INPUT_CRANK_SCALE   16.0f
+#define INPUT_COMPILER_SIZE 64
 
 #endif // !DEFS_H
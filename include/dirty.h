@@ -0,0 +1,18 @@
+#ifndef DIRTY_H
+#define DIRTY_H
+
+void dirty_region_clear(DirtyRegion* region);
+void dirty_region_add(DirtyRegion* region, RasterRect rect);
+bool dirty_region_intersects(const DirtyRegion* region, RasterRect rect);
+
+static inline bool raster_rect_empty(RasterRect rect)
+{
+    return rect.left >= rect.right || rect.top >= rect.bottom;
+}
+
+static inline bool raster_rect_overlaps(RasterRect a, RasterRect b)
+{
+    return a.left < b.right && b.left < a.right && a.top < b.bottom && b.top < a.bottom;
+}
+
+#endif // !DIRTY_H
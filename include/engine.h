@@ -2,9 +2,11 @@
 #define ENGINE_H
 
 void engine_init(Engine* engine);
+void engine_begin_frame(Engine* engine);
 void engine_input(Engine* engine);
 void engine_update(Engine* engine);
-void engine_render(Engine* engine);
+void engine_end_frame(Engine* engine);
+bool engine_render(Engine* engine);
 void engine_destroy(Engine* engine);
 
 #endif /* ENGINE_H */
\ No newline at end of file
@@ -0,0 +1,14 @@
+#ifndef HUD_H
+#define HUD_H
+
+Hud* hud_create(LCDFont* font);
+void hud_destroy(Hud* hud);
+
+int hud_add(Hud* hud, int x, int y);
+void hud_set_text(Hud* hud, int slot, const char* text);
+void hud_printf(Hud* hud, int slot, const char* format, ...);
+
+void hud_collect_dirty(Hud* hud, DirtyRegion* region);
+void hud_draw(const Hud* hud, const DirtyRegion* region);
+
+#endif // !HUD_H
@@ -0,0 +1,15 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+void input_sample(InputFrame* frame);
+float input_crank_change(const InputFrame* frame);
+
+InputRecorder* input_recorder_create(const char* path, float step);
+bool input_recorder_write(InputRecorder* recorder, const InputFrame* frame);
+void input_recorder_destroy(InputRecorder* recorder, uint32_t state_hash);
+
+InputSession* input_session_load(const char* path);
+void input_session_destroy(InputSession* session);
+const char* input_session_mismatch(const InputSession* session);
+
+#endif // !INPUT_H
@@ -0,0 +1,6 @@
+#ifndef LUA_BRIDGE_H
+#define LUA_BRIDGE_H
+
+bool lua_bridge_register(Engine* engine, PDCallbackFunction* update);
+
+#endif // !LUA_BRIDGE_H
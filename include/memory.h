@@ -1,9 +1,86 @@
 #ifndef MEMORY_H
 #define MEMORY_H
 
+#include <stddef.h>
+
+/*
+ * With PLAYSICS_MEMORY_TRACKING every allocation carries a small header and
+ * is attributed to the file:line that made it, the allocation macros below
+ * standing in for the plain functions. Between MEMORY_FRAME_BEGIN and
+ * MEMORY_FRAME_END (the update callback) any allocation is reported, since
+ * steady-state frames are meant to be allocation-free.
+ */
+#ifdef PLAYSICS_MEMORY_TRACKING
+
+#define MEMORY_STRINGIFY_(x) #x
+#define MEMORY_STRINGIFY(x)  MEMORY_STRINGIFY_(x)
+#define MEMORY_TAG           __FILE__ ":" MEMORY_STRINGIFY(__LINE__)
+
+void* pd_realloc_tagged(void* ptr, size_t size, const char* tag);
+void* pd_malloc_tagged(size_t size, const char* tag);
+void* pd_calloc_tagged(size_t count, size_t size, const char* tag);
+
+#define pd_realloc(ptr, size)   pd_realloc_tagged((ptr), (size), MEMORY_TAG)
+#define pd_malloc(size)         pd_malloc_tagged((size), MEMORY_TAG)
+#define pd_calloc(count, size)  pd_calloc_tagged((count), (size), MEMORY_TAG)
+
+void memory_frame_begin(void);
+void memory_frame_end(void);
+const MemoryStats* memory_stats(void);
+void memory_report(void);
+
+#define MEMORY_FRAME_BEGIN() memory_frame_begin()
+#define MEMORY_FRAME_END()   memory_frame_end()
+
+#else
+
 void* pd_realloc(void* ptr, size_t size);
 void* pd_malloc(size_t size);
 void* pd_calloc(size_t count, size_t size);
+
+#define MEMORY_FRAME_BEGIN() ((void)0)
+#define MEMORY_FRAME_END()   ((void)0)
+
+#endif // PLAYSICS_MEMORY_TRACKING
+
 void pd_free(void* ptr);
 
+/* ========================================================================== */
+/* FRAME ARENA                                                                */
+/* ========================================================================== */
+
+/* Alignment of a type, without relying on C11 _Alignof */
+#define ALIGNOF(type) offsetof(struct { char c; type member; }, member)
+
+#define ARENA_ALLOC(arena, type, count) \
+    ((type*)arena_alloc((arena), sizeof(type) * (size_t)(count), ALIGNOF(type)))
+
+Arena* arena_create(size_t size);
+void arena_destroy(Arena* arena);
+
+void* arena_alloc(Arena* arena, size_t size, size_t alignment);
+void arena_reset(Arena* arena);
+
+ArenaScope arena_scope_begin(Arena* arena);
+void arena_scope_end(ArenaScope scope);
+
+void arena_report(const Arena* arena, const char* name);
+
+/* ========================================================================== */
+/* OBJECT POOL                                                                */
+/* ========================================================================== */
+
+#define POOL_CREATE(type, items_per_chunk, max_items) \
+    pool_create(sizeof(type), (items_per_chunk), (max_items))
+#define POOL_ALLOC(pool, type) ((type*)pool_alloc(pool))
+
+Pool* pool_create(size_t item_size, int items_per_chunk, int max_items);
+void pool_destroy(Pool* pool);
+
+bool pool_reserve(Pool* pool, int count);
+void* pool_alloc(Pool* pool);
+void pool_free(Pool* pool, void* item);
+
+void pool_report(const Pool* pool, const char* name);
+
 #endif /* MEMORY_H */
\ No newline at end of file
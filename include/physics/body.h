@@ -0,0 +1,42 @@
+#ifndef BODY_H
+#define BODY_H
+
+#define BODY_INVALID_HANDLE UINT32_MAX
+
+BodyWorld* body_world_create(int capacity, int max_contacts);
+void body_world_destroy(BodyWorld* world);
+void body_world_clear(BodyWorld* world);
+void body_world_set_iterations(BodyWorld* world, int iterations);
+
+BodyHandle body_world_add(BodyWorld* world, const Body* body);
+void body_world_remove(BodyWorld* world, BodyHandle handle);
+bool body_world_get(const BodyWorld* world, BodyHandle handle, Body* out);
+void body_world_apply_force(BodyWorld* world, BodyHandle handle, Vector2 force, Vector2 point);
+void body_world_wake(BodyWorld* world, BodyHandle handle);
+bool body_world_is_awake(const BodyWorld* world, BodyHandle handle);
+void body_world_set_state(BodyWorld* world, BodyHandle handle, Vector2 position, float angle,
+                          Vector2 velocity, float angular_velocity);
+bool body_world_reindex(BodyWorld* world, int count);
+
+void body_world_step(BodyWorld* world, float dt);
+
+int body_world_build_pyramid(BodyWorld* world, Vector2 base, int rows, float size, float density);
+
+BodyShape body_shape_circle(float radius);
+BodyShape body_shape_aabb(float width, float height);
+BodyShape body_shape_box(float width, float height);
+BodyShape body_shape_polygon(const Vector2* vertices, int count);
+bool body_shape_valid(const BodyShape* shape);
+
+/* Dense index of a live body, or -1 if the handle is stale */
+static inline int body_world_index(const BodyWorld* world, BodyHandle handle)
+{
+    if (handle >= (BodyHandle)world->capacity)
+    {
+        return -1;
+    }
+    uint32_t index = world->handle_to_index[handle];
+    return index == BODY_INVALID_HANDLE ? -1 : (int)index;
+}
+
+#endif // !BODY_H
@@ -0,0 +1,28 @@
+#ifndef BROADPHASE_H
+#define BROADPHASE_H
+
+BroadphaseGrid* broadphase_grid_create(float cell_size, int max_items);
+void broadphase_grid_destroy(BroadphaseGrid* grid);
+
+int broadphase_grid_build(BroadphaseGrid* grid, const float* x, const float* y, int count, float radius,
+                          BroadphasePair* pairs, int max_pairs);
+
+BroadphaseSap* broadphase_sap_create(int max_items, int max_changes);
+void broadphase_sap_destroy(BroadphaseSap* sap);
+void broadphase_sap_clear(BroadphaseSap* sap);
+
+void broadphase_sap_update(BroadphaseSap* sap, const float* min_x, const float* min_y, const float* max_x,
+                           const float* max_y, int count, uint32_t revision);
+
+BroadphasePairSet* broadphase_pair_set_create(int capacity);
+void broadphase_pair_set_destroy(BroadphasePairSet* set);
+void broadphase_pair_set_clear(BroadphasePairSet* set);
+bool broadphase_pair_set_add(BroadphasePairSet* set, uint32_t a, uint32_t b);
+void broadphase_pair_set_remove(BroadphasePairSet* set, uint32_t a, uint32_t b);
+bool broadphase_pair_set_apply(BroadphasePairSet* set, const BroadphaseSap* sap);
+
+#ifdef PLAYSICS_DEBUG_DRAW
+void broadphase_grid_debug_draw(const BroadphaseGrid* grid);
+#endif
+
+#endif // !BROADPHASE_H
@@ -0,0 +1,8 @@
+#ifndef COLLIDE_H
+#define COLLIDE_H
+
+int collide_shapes(const BodyShape* shape_a, const BodyPose* pose_a,
+                   const BodyShape* shape_b, const BodyPose* pose_b,
+                   float margin, ContactManifold* manifold);
+
+#endif // !COLLIDE_H
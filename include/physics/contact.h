@@ -0,0 +1,8 @@
+#ifndef CONTACT_H
+#define CONTACT_H
+
+void contact_prepare(ContactManifold* manifolds, int count, const BodyVelocity* velocity, float dt);
+void contact_warm_start(const ContactManifold* manifolds, int count, BodyVelocity* velocity);
+void contact_solve(ContactManifold* manifolds, int count, BodyVelocity* velocity);
+
+#endif // !CONTACT_H
@@ -0,0 +1,17 @@
+#ifndef CONTACT_CACHE_H
+#define CONTACT_CACHE_H
+
+ContactCache* contact_cache_create(int max_pairs, int max_bodies);
+void contact_cache_destroy(ContactCache* cache);
+void contact_cache_clear(ContactCache* cache);
+
+void contact_cache_begin(ContactCache* cache);
+ContactCacheEntry* contact_cache_acquire(ContactCache* cache, uint32_t key, bool* created);
+bool contact_cache_reuse(ContactCacheEntry* entry, const BodyPose* pose_a, const BodyPose* pose_b);
+void contact_cache_update(ContactCacheEntry* entry, const ContactManifold* manifold,
+                          const BodyPose* pose_a, const BodyPose* pose_b);
+void contact_cache_store_impulses(const ContactManifold* manifolds, ContactCacheEntry* const* entries, int count);
+void contact_cache_evict(ContactCache* cache, uint32_t handle);
+void contact_cache_forget(ContactCache* cache, uint32_t handle);
+
+#endif // !CONTACT_CACHE_H
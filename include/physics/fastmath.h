@@ -0,0 +1,95 @@
+#ifndef FASTMATH_H
+#define FASTMATH_H
+
+/*
+ * Approximate replacements for the libm calls on the vector hot paths. They
+ * are always available; building with PLAYSICS_FAST_MATH makes vector.h use
+ * them in place of sqrtf, sinf/cosf and atan2f. Error bounds below are the
+ * worst cases measured by playsics_bench against double precision libm.
+ */
+
+#define FAST_SIN_TABLE_BITS 8
+#define FAST_SIN_TABLE_SIZE (1 << FAST_SIN_TABLE_BITS)
+
+/* sin(2 * pi * i / FAST_SIN_TABLE_SIZE), with one extra entry to interpolate into */
+extern const float FAST_SIN_TABLE[FAST_SIN_TABLE_SIZE + 1];
+
+static const float FAST_PI = 3.14159265f;
+static const float FAST_HALF_PI = 1.57079633f;
+
+/*
+ * 1 / sqrt(x) for x > 0: bit-level initial guess plus one Newton-Raphson step.
+ * Max relative error 1.8e-3. x == 0 yields a large finite value, so
+ * x * fast_rsqrt(x) is still 0.
+ */
+static inline float fast_rsqrt(float x)
+{
+    union { float f; uint32_t i; } bits = { x };
+    bits.i = 0x5f375a86u - (bits.i >> 1);
+    float y = bits.f;
+    return y * (1.5f - 0.5f * x * y * y);
+}
+
+/* sqrt(x) for x >= 0 through fast_rsqrt. Max relative error 1.8e-3 */
+static inline float fast_sqrt(float x)
+{
+    return x * fast_rsqrt(x);
+}
+
+/*
+ * Table-driven sine and cosine with linear interpolation between the 256
+ * entries. Max absolute error 7.6e-5 for |angle| up to a few thousand radians.
+ */
+static inline void fast_sincos(float angle, float* out_sin, float* out_cos)
+{
+    float t = angle * ((float)FAST_SIN_TABLE_SIZE / (2.0f * FAST_PI));
+    float whole = floorf(t);
+    float frac = t - whole;
+
+    // Wraps negative angles too, through two's complement masking
+    uint32_t s = (uint32_t)(int32_t)whole & (FAST_SIN_TABLE_SIZE - 1);
+    uint32_t c = (s + FAST_SIN_TABLE_SIZE / 4) & (FAST_SIN_TABLE_SIZE - 1);
+
+    *out_sin = FAST_SIN_TABLE[s] + (FAST_SIN_TABLE[s + 1] - FAST_SIN_TABLE[s]) * frac;
+    *out_cos = FAST_SIN_TABLE[c] + (FAST_SIN_TABLE[c + 1] - FAST_SIN_TABLE[c]) * frac;
+}
+
+static inline float fast_sinf(float angle)
+{
+    float s, c;
+    fast_sincos(angle, &s, &c);
+    return s;
+}
+
+static inline float fast_cosf(float angle)
+{
+    float s, c;
+    fast_sincos(angle, &s, &c);
+    return c;
+}
+
+/*
+ * atan2 from an odd polynomial for atan on [0, 1] (Abramowitz & Stegun
+ * 4.4.49) folded out to all octants. Max absolute error 1.2e-5 radians.
+ */
+static inline float fast_atan2(float y, float x)
+{
+    float ax = fabsf(x);
+    float ay = fabsf(y);
+    float hi = MAX(ax, ay);
+    if (hi == 0.0f)
+    {
+        return 0.0f;
+    }
+
+    float z = MIN(ax, ay) / hi;
+    float z2 = z * z;
+    float r = z * (0.9998660f + z2 * (-0.3302995f + z2 * (0.1801410f + z2 * (-0.0851330f + z2 * 0.0208351f))));
+
+    if (ay > ax) r = FAST_HALF_PI - r;
+    if (x < 0.0f) r = FAST_PI - r;
+    if (y < 0.0f) r = -r;
+    return r;
+}
+
+#endif // !FASTMATH_H
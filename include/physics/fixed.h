@@ -0,0 +1,331 @@
+#ifndef FIXED_H
+#define FIXED_H
+
+/*
+ * Q16.16 fixed-point math with the same operation set as vector.h. Every
+ * operation is pure integer arithmetic, so results are bit-identical on the
+ * simulator and the device regardless of compiler or FPU behaviour. Values
+ * range over [-32768, 32768) with a resolution of 1/65536; products such as
+ * dot, cross and length_squared overflow once their result leaves that range.
+ */
+
+#define FIXED_FRAC_BITS 16
+#define FIXED_ONE       ((Fixed)1 << FIXED_FRAC_BITS)
+#define FIXED_HALF      (FIXED_ONE >> 1)
+#define FIXED_PI        ((Fixed)205887)
+#define FIXED_HALF_PI   ((Fixed)102944)
+
+/* Smallest non-zero magnitude, the fixed-point counterpart of VECTOR_EPSILON */
+#define FIXED_EPSILON   ((Fixed)1)
+
+#define FIXED_SIN_TABLE_SIZE 256
+
+/* sin(2 * pi * i / FIXED_SIN_TABLE_SIZE) in Q16.16, plus one wrap-around entry */
+extern const Fixed FIXED_SIN_TABLE[FIXED_SIN_TABLE_SIZE + 1];
+
+static const FixedVector2 FXVEC2_ZERO = { 0, 0 };
+static const FixedVector2 FXVEC2_ONE = { FIXED_ONE, FIXED_ONE };
+
+/* ========================================================================== */
+/* SCALAR OPERATIONS                                                          */
+/* ========================================================================== */
+
+static inline Fixed fixed_from_int(int value)
+{
+    return (Fixed)value * FIXED_ONE;
+}
+
+/*
+ * Truncates toward zero; exact and deterministic on any IEEE 754 target.
+ * Converting an out-of-range float to an integer is undefined (x86 gives
+ * INT32_MIN, ARM saturates), so values beyond the Q16.16 range saturate
+ * here explicitly and NaN becomes 0.
+ */
+static inline Fixed fixed_from_float(float value)
+{
+    float scaled = value * (float)FIXED_ONE;
+    if (scaled >= 2147483648.0f)
+    {
+        return INT32_MAX;
+    }
+    if (scaled <= -2147483648.0f)
+    {
+        return INT32_MIN;
+    }
+    if (scaled != scaled)
+    {
+        return 0;
+    }
+    return (Fixed)scaled;
+}
+
+static inline float fixed_to_float(Fixed value)
+{
+    return (float)value * (1.0f / (float)FIXED_ONE);
+}
+
+static inline int fixed_to_int(Fixed value)
+{
+    return (int)(value >> FIXED_FRAC_BITS);
+}
+
+static inline Fixed fixed_abs(Fixed value)
+{
+    return value < 0 ? -value : value;
+}
+
+static inline Fixed fixed_mul(Fixed a, Fixed b)
+{
+    return (Fixed)(((int64_t)a * b) >> FIXED_FRAC_BITS);
+}
+
+/* Divides with zero-check, returning 0 like vec2_divide */
+static inline Fixed fixed_div(Fixed a, Fixed b)
+{
+    VECTOR_ASSERT(b != 0, "Division by zero in fixed_div");
+    if (b == 0)
+    {
+        return 0;
+    }
+    return (Fixed)(((int64_t)a << FIXED_FRAC_BITS) / b);
+}
+
+static inline Fixed fixed_clamp(Fixed value, Fixed min, Fixed max)
+{
+    if (value < min) return min;
+    if (value > max) return max;
+    return value;
+}
+
+static inline Fixed fixed_lerp(Fixed a, Fixed b, Fixed t)
+{
+    return a + fixed_mul(t, b - a);
+}
+
+/* Integer square root of a 64-bit value, one result bit per iteration */
+static inline uint32_t fixed_isqrt64(uint64_t value)
+{
+    uint64_t result = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+
+    while (bit > value)
+    {
+        bit >>= 2;
+    }
+    while (bit != 0)
+    {
+        if (value >= result + bit)
+        {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else
+        {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)result;
+}
+
+static inline Fixed fixed_sqrt(Fixed value)
+{
+    if (value <= 0)
+    {
+        return 0;
+    }
+    return (Fixed)fixed_isqrt64((uint64_t)value << FIXED_FRAC_BITS);
+}
+
+/* Table-driven sine and cosine of an angle in radians, linearly interpolated */
+static inline void fixed_sincos(Fixed angle, Fixed* out_sin, Fixed* out_cos)
+{
+    // 256 / (2 * pi) in Q16.16 maps radians onto table entries
+    int64_t t = ((int64_t)angle * 2670177) >> FIXED_FRAC_BITS;
+    uint32_t s = (uint32_t)(t >> FIXED_FRAC_BITS) & (FIXED_SIN_TABLE_SIZE - 1);
+    uint32_t c = (s + FIXED_SIN_TABLE_SIZE / 4) & (FIXED_SIN_TABLE_SIZE - 1);
+    Fixed frac = (Fixed)(t & (FIXED_ONE - 1));
+
+    *out_sin = FIXED_SIN_TABLE[s] + fixed_mul(FIXED_SIN_TABLE[s + 1] - FIXED_SIN_TABLE[s], frac);
+    *out_cos = FIXED_SIN_TABLE[c] + fixed_mul(FIXED_SIN_TABLE[c + 1] - FIXED_SIN_TABLE[c], frac);
+}
+
+/* atan2 with the polynomial used by fast_atan2, evaluated in Q16.16 */
+static inline Fixed fixed_atan2(Fixed y, Fixed x)
+{
+    Fixed ax = fixed_abs(x);
+    Fixed ay = fixed_abs(y);
+    Fixed hi = MAX(ax, ay);
+    if (hi == 0)
+    {
+        return 0;
+    }
+
+    Fixed z = fixed_div(MIN(ax, ay), hi);
+    Fixed z2 = fixed_mul(z, z);
+    Fixed r = fixed_mul(z, 65527 + fixed_mul(z2, -21647 + fixed_mul(z2, 11806 + fixed_mul(z2, -5579 + fixed_mul(z2, 1365)))));
+
+    if (ay > ax) r = FIXED_HALF_PI - r;
+    if (x < 0) r = FIXED_PI - r;
+    if (y < 0) r = -r;
+    return r;
+}
+
+/* ========================================================================== */
+/* FXVEC2 BASIC OPERATIONS                                                    */
+/* ========================================================================== */
+
+static inline FixedVector2 fxvec2_new(Fixed x, Fixed y)
+{
+    return (FixedVector2) { x, y };
+}
+
+static inline FixedVector2 fxvec2_from_vec2(Vector2 v)
+{
+    return (FixedVector2) { fixed_from_float(v.x), fixed_from_float(v.y) };
+}
+
+static inline Vector2 fxvec2_to_vec2(FixedVector2 v)
+{
+    return (Vector2) { fixed_to_float(v.x), fixed_to_float(v.y) };
+}
+
+static inline FixedVector2 fxvec2_add(FixedVector2 a, FixedVector2 b)
+{
+    return (FixedVector2) { a.x + b.x, a.y + b.y };
+}
+
+static inline FixedVector2 fxvec2_sub(FixedVector2 a, FixedVector2 b)
+{
+    return (FixedVector2) { a.x - b.x, a.y - b.y };
+}
+
+static inline FixedVector2 fxvec2_scale(FixedVector2 v, Fixed scalar)
+{
+    return (FixedVector2) { fixed_mul(v.x, scalar), fixed_mul(v.y, scalar) };
+}
+
+static inline FixedVector2 fxvec2_multiply(FixedVector2 a, FixedVector2 b)
+{
+    return (FixedVector2) { fixed_mul(a.x, b.x), fixed_mul(a.y, b.y) };
+}
+
+static inline FixedVector2 fxvec2_divide(FixedVector2 v, Fixed scalar)
+{
+    VECTOR_ASSERT(scalar != 0, "Division by zero in fxvec2_divide");
+    if (scalar == 0)
+    {
+        return FXVEC2_ZERO;
+    }
+    return (FixedVector2) { fixed_div(v.x, scalar), fixed_div(v.y, scalar) };
+}
+
+static inline FixedVector2 fxvec2_negate(FixedVector2 v)
+{
+    return (FixedVector2) { -v.x, -v.y };
+}
+
+/* ========================================================================== */
+/* FXVEC2 ADVANCED OPERATIONS                                                 */
+/* ========================================================================== */
+
+static inline Fixed fxvec2_dot(FixedVector2 a, FixedVector2 b)
+{
+    return (Fixed)(((int64_t)a.x * b.x + (int64_t)a.y * b.y) >> FIXED_FRAC_BITS);
+}
+
+static inline Fixed fxvec2_cross(FixedVector2 a, FixedVector2 b)
+{
+    return (Fixed)(((int64_t)a.x * b.y - (int64_t)a.y * b.x) >> FIXED_FRAC_BITS);
+}
+
+static inline Fixed fxvec2_length_squared(FixedVector2 v)
+{
+    return fxvec2_dot(v, v);
+}
+
+/*
+ * Computed from the full 64-bit square, so the square itself never
+ * overflows; a length beyond the Q16.16 range (up to sqrt(2) * 32768 for a
+ * diagonal vector) saturates to INT32_MAX.
+ */
+static inline Fixed fxvec2_length(FixedVector2 v)
+{
+    uint64_t length_sq = (uint64_t)((int64_t)v.x * v.x + (int64_t)v.y * v.y);
+    uint32_t length = fixed_isqrt64(length_sq);
+    return length > (uint32_t)INT32_MAX ? INT32_MAX : (Fixed)length;
+}
+
+static inline FixedVector2 fxvec2_normalize(FixedVector2 v)
+{
+    Fixed len = fxvec2_length(v);
+    VECTOR_ASSERT(len > 0, "Cannot normalize zero-length vector in fxvec2_normalize");
+    if (len == 0)
+    {
+        return FXVEC2_ZERO;
+    }
+    return (FixedVector2) { fixed_div(v.x, len), fixed_div(v.y, len) };
+}
+
+static inline Fixed fxvec2_distance(FixedVector2 a, FixedVector2 b)
+{
+    return fxvec2_length(fxvec2_sub(b, a));
+}
+
+static inline Fixed fxvec2_distance_squared(FixedVector2 a, FixedVector2 b)
+{
+    return fxvec2_length_squared(fxvec2_sub(b, a));
+}
+
+static inline FixedVector2 fxvec2_lerp(FixedVector2 a, FixedVector2 b, Fixed t)
+{
+    t = fixed_clamp(t, 0, FIXED_ONE);
+    return (FixedVector2) { fixed_lerp(a.x, b.x, t), fixed_lerp(a.y, b.y, t) };
+}
+
+static inline FixedVector2 fxvec2_rotate(FixedVector2 v, Fixed angle_rad)
+{
+    Fixed sin_a, cos_a;
+    fixed_sincos(angle_rad, &sin_a, &cos_a);
+    return (FixedVector2) { fixed_mul(v.x, cos_a) - fixed_mul(v.y, sin_a),
+                            fixed_mul(v.x, sin_a) + fixed_mul(v.y, cos_a) };
+}
+
+static inline Fixed fxvec2_angle(FixedVector2 v)
+{
+    return fixed_atan2(v.y, v.x);
+}
+
+static inline FixedVector2 fxvec2_reflect(FixedVector2 incident, FixedVector2 normal)
+{
+    Fixed dot_product = fxvec2_dot(incident, normal);
+    return fxvec2_sub(incident, fxvec2_scale(normal, 2 * dot_product));
+}
+
+static inline FixedVector2 fxvec2_project(FixedVector2 a, FixedVector2 b)
+{
+    Fixed b_length_squared = fxvec2_length_squared(b);
+    VECTOR_ASSERT(b_length_squared > 0, "Cannot project onto zero-length vector in fxvec2_project");
+    if (b_length_squared == 0)
+    {
+        return FXVEC2_ZERO;
+    }
+    return fxvec2_scale(b, fixed_div(fxvec2_dot(a, b), b_length_squared));
+}
+
+/* ========================================================================== */
+/* FXVEC2 COMPARISON OPERATIONS                                               */
+/* ========================================================================== */
+
+/* Exact: fixed-point values need no epsilon */
+static inline bool fxvec2_equals(FixedVector2 a, FixedVector2 b)
+{
+    return a.x == b.x && a.y == b.y;
+}
+
+static inline bool fxvec2_is_zero(FixedVector2 v)
+{
+    return v.x == 0 && v.y == 0;
+}
+
+#endif // !FIXED_H
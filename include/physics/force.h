@@ -0,0 +1,22 @@
+#ifndef FORCE_H
+#define FORCE_H
+
+ForceRegistry* force_registry_create(int max_particles, int max_fields, int max_springs);
+void force_registry_destroy(ForceRegistry* registry);
+void force_registry_clear(ForceRegistry* registry);
+
+ForceField force_gravity(Vector2 acceleration);
+ForceField force_drag(float linear, float quadratic);
+ForceField force_wind(Vector2 velocity, float coefficient);
+ForceField force_attractor(Vector2 center, float radius, float strength, ForceFalloff falloff);
+
+int force_add_field(ForceRegistry* registry, const ForceField* field);
+void force_remove_field(ForceRegistry* registry, int field);
+ForceField* force_get_field(ForceRegistry* registry, int field);
+
+int force_add_spring(ForceRegistry* registry, const ParticleWorld* world, ParticleHandle a, ParticleHandle b,
+                     float stiffness, float damping);
+
+void force_registry_apply(ForceRegistry* registry, ParticleWorld* world);
+
+#endif // !FORCE_H
@@ -1,6 +1,34 @@
 #ifndef PARTICLE_H
 #define PARTICLE_H
 
+#define PARTICLE_INVALID_HANDLE UINT32_MAX
 
-#endif // !PARTICLE_H
+ParticleWorld* particle_world_create(int capacity);
+void particle_world_destroy(ParticleWorld* world);
+
+ParticleHandle particle_world_add(ParticleWorld* world, const Particle* particle);
+void particle_world_remove(ParticleWorld* world, ParticleHandle handle);
+void particle_world_clear(ParticleWorld* world);
+bool particle_world_reindex(ParticleWorld* world, int count);
+
+uint32_t particle_world_hash(const ParticleWorld* world);
+
+bool particle_world_get(const ParticleWorld* world, ParticleHandle handle, Particle* out);
+void particle_world_apply_force(ParticleWorld* world, ParticleHandle handle, Vector2 force);
 
+void particle_world_integrate(ParticleWorld* world, float dt);
+void particle_world_integrate_fixed(ParticleWorld* world, float dt);
+void particle_world_collide(ParticleWorld* world, const BroadphasePair* pairs, int pair_count, float radius);
+
+/* Dense index of a live particle, or -1 if the handle is stale */
+static inline int particle_world_index(const ParticleWorld* world, ParticleHandle handle)
+{
+    if (handle >= (ParticleHandle)world->capacity)
+    {
+        return -1;
+    }
+    uint32_t index = world->handle_to_index[handle];
+    return index == PARTICLE_INVALID_HANDLE ? -1 : (int)index;
+}
+
+#endif // !PARTICLE_H
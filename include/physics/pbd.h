@@ -0,0 +1,21 @@
+#ifndef PBD_H
+#define PBD_H
+
+PbdSolver* pbd_solver_create(int max_particles, int max_distance, int max_pins);
+void pbd_solver_destroy(PbdSolver* solver);
+void pbd_solver_clear(PbdSolver* solver);
+void pbd_solver_set_iterations(PbdSolver* solver, int iterations);
+
+int pbd_add_distance(PbdSolver* solver, const ParticleWorld* world, ParticleHandle a, ParticleHandle b, float stiffness);
+int pbd_add_pin(PbdSolver* solver, const ParticleWorld* world, ParticleHandle handle);
+void pbd_set_pin_position(PbdSolver* solver, int pin, Vector2 position);
+void pbd_set_bounds(PbdSolver* solver, Vector2 min, Vector2 max, float radius);
+
+void pbd_solver_solve(PbdSolver* solver, ParticleWorld* world, float dt);
+
+ParticleHandle pbd_build_rope(PbdSolver* solver, ParticleWorld* world, Vector2 start, Vector2 end,
+                              int segments, float mass, float stiffness);
+ParticleHandle pbd_build_cloth(PbdSolver* solver, ParticleWorld* world, Vector2 origin,
+                               int columns, int rows, float spacing, float mass, float stiffness);
+
+#endif // !PBD_H
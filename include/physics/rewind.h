@@ -0,0 +1,11 @@
+#ifndef REWIND_H
+#define REWIND_H
+
+RewindBuffer* rewind_create(uint32_t budget, int max_frames, int particle_capacity, int body_capacity);
+void rewind_destroy(RewindBuffer* buffer);
+void rewind_reset(RewindBuffer* buffer);
+
+void rewind_record(RewindBuffer* buffer, const ParticleWorld* particles, const BodyWorld* bodies);
+bool rewind_step_back(RewindBuffer* buffer, ParticleWorld* particles, BodyWorld* bodies);
+
+#endif // !REWIND_H
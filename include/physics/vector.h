@@ -9,6 +9,27 @@
 #define VECTOR_ASSERT(condition, message) ((void)0)
 #endif
 
+#include "physics/fastmath.h"
+
+/* Transcendentals used below, approximated when PLAYSICS_FAST_MATH is set */
+#ifdef PLAYSICS_FAST_MATH
+#define VECTOR_SQRTF(x) fast_sqrt(x)
+#define VECTOR_RSQRTF(x) fast_rsqrt(x)
+#define VECTOR_SINCOSF(angle, out_sin, out_cos) fast_sincos((angle), (out_sin), (out_cos))
+#define VECTOR_ATAN2F(y, x) fast_atan2((y), (x))
+#elif defined(PLAYSICS_FIXED_POINT)
+/* sqrtf is correctly rounded everywhere, but libm's trig is not, so the table stands in for it */
+#define VECTOR_SQRTF(x) sqrtf(x)
+#define VECTOR_RSQRTF(x) (1.0f / sqrtf(x))
+#define VECTOR_SINCOSF(angle, out_sin, out_cos) fast_sincos((angle), (out_sin), (out_cos))
+#define VECTOR_ATAN2F(y, x) fast_atan2((y), (x))
+#else
+#define VECTOR_SQRTF(x) sqrtf(x)
+#define VECTOR_RSQRTF(x) (1.0f / sqrtf(x))
+#define VECTOR_SINCOSF(angle, out_sin, out_cos) (*(out_sin) = sinf(angle), *(out_cos) = cosf(angle))
+#define VECTOR_ATAN2F(y, x) atan2f((y), (x))
+#endif
+
 /* ========================================================================== */
 /* CONSTANTS                                                                  */
 /* ========================================================================== */
@@ -112,7 +133,7 @@ static inline float vec2_cross(Vector2 a, Vector2 b)
 /* Length (magnitude) of a Vector2 vector */
 static inline float vec2_length(Vector2 v)
 {
-    return sqrtf(v.x * v.x + v.y * v.y);
+    return VECTOR_SQRTF(v.x * v.x + v.y * v.y);
 }
 
 /* Squared length of a Vector2 vector */
@@ -124,13 +145,13 @@ static inline float vec2_length_squared(Vector2 v)
 /* Normalizes a Vector2 vector */
 static inline Vector2 vec2_normalize(Vector2 v)
 {
-    float len = vec2_length(v);
-    VECTOR_ASSERT(len > VECTOR_EPSILON, "Cannot normalize zero-length vector in vec2_normalize");
-    if (len < VECTOR_EPSILON) 
+    float len_sq = vec2_length_squared(v);
+    VECTOR_ASSERT(len_sq > VECTOR_EPSILON * VECTOR_EPSILON, "Cannot normalize zero-length vector in vec2_normalize");
+    if (len_sq < VECTOR_EPSILON * VECTOR_EPSILON) 
     {
         return VEC2_ZERO;
     }
-    return vec2_divide(v, len);
+    return vec2_scale(v, VECTOR_RSQRTF(len_sq));
 }
 
 /* Distance between two Vector2 vectors */
@@ -155,15 +176,15 @@ static inline Vector2 vec2_lerp(Vector2 a, Vector2 b, float t)
 /* Rotate a Vector2 by an angle in radians */
 static inline Vector2 vec2_rotate(Vector2 v, float angle_rad)
 {
-    float cos_a = cosf(angle_rad);
-    float sin_a = sinf(angle_rad);
+    float cos_a, sin_a;
+    VECTOR_SINCOSF(angle_rad, &sin_a, &cos_a);
     return (Vector2) { v.x * cos_a - v.y * sin_a, v.x * sin_a + v.y * cos_a };
 }
 
 /* Angle of a Vector2 in radians from the positive x-axis */
 static inline float vec2_angle(Vector2 v) 
 {
-	return atan2f(v.y, v.x);
+	return VECTOR_ATAN2F(v.y, v.x);
 }
 
 /* Reflects a vector off a surface with given normal */
@@ -202,6 +223,47 @@ static inline bool vec2_is_zero(Vector2 v)
     return vec2_length_squared(v) < (VECTOR_EPSILON * VECTOR_EPSILON);
 }
 
+/* ========================================================================== */
+/* VEC2 BATCH OPERATIONS                                                      */
+/* ========================================================================== */
+
+/*
+ * Batch variants over structure-of-arrays data: x and y components live in
+ * separate float arrays of n elements. Accumulating kernels update their first
+ * array pair in place; no two array arguments may overlap. Each has a scalar
+ * *_ref twin built on the vec2_* functions above, used to validate them.
+ */
+
+/* x += bx, y += by */
+void vec2_add_n(float* restrict x, float* restrict y,
+                const float* restrict bx, const float* restrict by, int n);
+
+/* x *= scalar, y *= scalar */
+void vec2_scale_n(float* restrict x, float* restrict y, float scalar, int n);
+
+/* x += ax * scalar, y += ay * scalar (axpy) */
+void vec2_scale_add_n(float* restrict x, float* restrict y,
+                      const float* restrict ax, const float* restrict ay, float scalar, int n);
+
+/* x += ax * weight[i] * scalar, y += ay * weight[i] * scalar */
+void vec2_weighted_add_n(float* restrict x, float* restrict y,
+                         const float* restrict ax, const float* restrict ay,
+                         const float* restrict weight, float scalar, int n);
+
+/* out[i] = |(x[i], y[i])| */
+void vec2_length_n(float* restrict out, const float* restrict x, const float* restrict y, int n);
+
+/* Normalizes in place; zero-length vectors become zero like vec2_normalize */
+void vec2_normalize_n(float* restrict x, float* restrict y, int n);
+
+void vec2_add_n_ref(float* x, float* y, const float* bx, const float* by, int n);
+void vec2_scale_n_ref(float* x, float* y, float scalar, int n);
+void vec2_scale_add_n_ref(float* x, float* y, const float* ax, const float* ay, float scalar, int n);
+void vec2_weighted_add_n_ref(float* x, float* y, const float* ax, const float* ay,
+                             const float* weight, float scalar, int n);
+void vec2_length_n_ref(float* out, const float* x, const float* y, int n);
+void vec2_normalize_n_ref(float* x, float* y, int n);
+
 /* ========================================================================== */
 /* CONVENIENCE MACROS                                                         */
 /* ========================================================================== */
@@ -0,0 +1,40 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+/*
+ * Scoped frame timers. PROFILE_BEGIN/PROFILE_END pairs must nest; the name is
+ * a string literal identifying the scope. Without PLAYSICS_PROFILER every
+ * macro expands to nothing.
+ */
+#ifdef PLAYSICS_PROFILER
+
+void profiler_begin_frame(void);
+void profiler_end_frame(void);
+void profiler_begin(const char* name);
+void profiler_end(void);
+
+int profiler_find(const char* name);
+float profiler_last(int scope);
+bool profiler_stats(int scope, ProfileStats* out);
+bool profiler_frame_stats(ProfileStats* out);
+
+void profiler_set_overlay(bool enabled);
+bool profiler_overlay_enabled(void);
+void profiler_draw_overlay(RasterTarget* target, RasterRect area);
+bool profiler_dump_csv(const char* path);
+
+#define PROFILE_FRAME_BEGIN() profiler_begin_frame()
+#define PROFILE_FRAME_END()   profiler_end_frame()
+#define PROFILE_BEGIN(name)   profiler_begin(name)
+#define PROFILE_END()         profiler_end()
+
+#else
+
+#define PROFILE_FRAME_BEGIN() ((void)0)
+#define PROFILE_FRAME_END()   ((void)0)
+#define PROFILE_BEGIN(name)   ((void)0)
+#define PROFILE_END()         ((void)0)
+
+#endif // PLAYSICS_PROFILER
+
+#endif // !PROFILER_H
@@ -0,0 +1,21 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+/* Largest square a point may be drawn as; one point row then spans at most two words */
+#define RASTER_MAX_POINT_SIZE 32
+
+void raster_target_init(RasterTarget* target, uint8_t* pixels, int rowbytes, int width, int height);
+void raster_target_begin(RasterTarget* target);
+bool raster_target_dirty(const RasterTarget* target);
+void raster_target_set_clip(RasterTarget* target, RasterRect clip);
+
+void raster_clear_rows(RasterTarget* target, int top, int bottom);
+void raster_clear_rect(RasterTarget* target, RasterRect rect);
+void raster_fill_rect(RasterTarget* target, RasterRect rect, const uint8_t pattern[4]);
+void raster_fill_points(RasterTarget* target, const float* prev_x, const float* prev_y,
+                        const float* x, const float* y, float alpha, int count, int size);
+void raster_fill_squares(RasterTarget* target, const int16_t* left, const int16_t* top, int count, int size);
+void raster_draw_line(RasterTarget* target, int x0, int y0, int x1, int y1);
+void raster_draw_circle(RasterTarget* target, int cx, int cy, int radius);
+
+#endif // !RASTER_H
@@ -3,7 +3,7 @@
 
 Renderer* renderer_create(void);
 void renderer_init(Renderer* renderer);
-void renderer_draw(Renderer* renderer);
+bool renderer_draw(Renderer* renderer, const ParticleWorld* particles, const BodyWorld* bodies, float alpha);
 void renderer_destroy(Renderer* renderer);
 
 #endif // !RENDERER_H
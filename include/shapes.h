@@ -0,0 +1,16 @@
+#ifndef SHAPES_H
+#define SHAPES_H
+
+ShapeCache* shape_cache_create(size_t budget);
+void shape_cache_destroy(ShapeCache* cache);
+void shape_cache_begin_frame(ShapeCache* cache);
+
+const ShapeCacheEntry* shape_cache_get(ShapeCache* cache, ShapeKind kind, int width, int height,
+                                       int shade, float angle);
+RasterRect shape_cache_rect(const ShapeCacheEntry* entry, float x, float y);
+RasterRect shape_cache_draw(ShapeCache* cache, ShapeKind kind, int width, int height,
+                            int shade, float angle, float x, float y);
+
+void shape_cache_report(const ShapeCache* cache);
+
+#endif // !SHAPES_H
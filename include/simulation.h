@@ -0,0 +1,10 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+bool simulation_init(Engine* engine);
+void simulation_input(Engine* engine, const InputFrame* input);
+void simulation_step(Engine* engine);
+uint32_t simulation_hash(const Engine* engine);
+void simulation_destroy(Engine* engine);
+
+#endif // !SIMULATION_H
@@ -0,0 +1,7 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+bool snapshot_save(const char* path, const ParticleWorld* particles, const BodyWorld* bodies);
+bool snapshot_load(const char* path, ParticleWorld* particles, BodyWorld* bodies);
+
+#endif // !SNAPSHOT_H
@@ -3,18 +3,332 @@
 
 typedef struct Engine Engine;
 typedef struct Renderer Renderer;
+typedef struct ParticleWorld ParticleWorld;
+typedef struct BroadphaseGrid BroadphaseGrid;
+typedef struct BroadphaseSap BroadphaseSap;
+typedef struct BroadphasePairSet BroadphasePairSet;
+typedef struct PbdSolver PbdSolver;
+typedef struct ForceRegistry ForceRegistry;
+typedef struct BodyWorld BodyWorld;
+typedef struct ContactCacheEntry ContactCacheEntry;
+typedef struct RewindBuffer RewindBuffer;
+typedef struct InputRecorder InputRecorder;
+
+/*
+ * Bump-pointer allocator over one block taken from pd_malloc up front.
+ * Everything in it is released at once by arena_reset, or back to a saved
+ * point by closing an ArenaScope.
+ */
+typedef struct
+{
+	uint8_t* base;
+	size_t size;
+	size_t offset;
+	size_t high_water;
+	int scope_depth;
+} Arena;
+
+typedef struct
+{
+	Arena* arena;
+	size_t offset;
+} ArenaScope;
+
+/*
+ * Fixed-size object pool. Items are carved from chunks that are only returned
+ * to the system at pool_destroy; free items are threaded through an intrusive
+ * free list stored in their own first word.
+ */
+typedef struct
+{
+	size_t item_size;
+	int items_per_chunk;
+	int max_items;
+
+	void* free_list;
+	void* chunks;
+	int chunk_count;
+
+	/* Usage counters */
+	int capacity;
+	int used;
+	int peak;
+	uint32_t total_allocs;
+	uint32_t total_frees;
+} Pool;
+
+/* Heap counters kept by the tracked pd_malloc layer (PLAYSICS_MEMORY_TRACKING) */
+typedef struct
+{
+	size_t live_bytes;
+	size_t peak_bytes;
+	int live_allocs;
+	uint32_t total_allocs;
+	uint32_t total_frees;
+
+	/* Since the current frame began */
+	int frame_allocs;
+	size_t frame_bytes;
+	uint32_t frames_with_allocs;
+} MemoryStats;
+
+/* Allocations attributed to one call site */
+typedef struct
+{
+	const char* tag;
+	int live_allocs;
+	size_t live_bytes;
+	uint32_t total_allocs;
+	bool flagged;
+} MemorySite;
+
+/*
+ * Fixed-step scheduler state. Real frame time is banked in the accumulator and
+ * drained in whole steps; the remainder becomes the render interpolation alpha.
+ */
+typedef struct
+{
+	float step;
+	float accumulator;
+	float alpha;
+	int max_substeps;
+} Timestep;
+
+/*
+ * Everything the simulation reads from the player in one frame, quantized at
+ * sampling time so a recorded session replays exactly what was acted on:
+ * PDButtons masks, the crank change in 1/INPUT_CRANK_SCALE degrees (0 while
+ * docked), and how many fixed steps the frame ran.
+ */
+typedef struct
+{
+	int16_t crank;
+	uint8_t buttons;
+	uint8_t pushed;
+	uint8_t released;
+	uint8_t steps;
+} InputFrame;
+
+/* A recorded session loaded whole for replay, with the build that recorded it */
+typedef struct
+{
+	float step;
+	bool finished;
+	uint32_t build;
+	char compiler[INPUT_COMPILER_SIZE];
+	uint32_t state_hash;
+	int frame_count;
+	InputFrame* frames;
+} InputSession;
 
 struct Engine
 {
 	bool debug;
 
+	Timestep timestep;
+	Arena* frame_arena;
 	Renderer* renderer;
+	ParticleWorld* particles;
+	/* Particle broadphase: the grid, or the sweep and the pairs it keeps when built with PLAYSICS_SWEEP_PRUNE */
+	BroadphaseGrid* grid;
+	BroadphaseSap* sap;
+	BroadphasePairSet* sap_pairs;
+	PbdSolver* solver;
+	ForceRegistry* forces;
+	BodyWorld* bodies;
+
+	/* Crank rewind: degrees turned back not yet spent on a frame, and whether this frame rewound */
+	RewindBuffer* rewind;
+	float rewind_crank;
+	bool rewinding;
+
+	/* This frame's input, and where it is streamed to when recording */
+	InputFrame input;
+	InputRecorder* recorder;
 };
 
+/* Pixel rectangle, right and bottom exclusive */
+typedef struct
+{
+	int left;
+	int top;
+	int right;
+	int bottom;
+} RasterRect;
+
+/*
+ * A 1-bit frame buffer as laid out by the Playdate: rows of rowbytes bytes,
+ * most significant bit leftmost, set bits white. Drawing is clipped to clip,
+ * and rows written since the last raster_target_begin are tracked as one
+ * inclusive span.
+ */
+typedef struct
+{
+	uint8_t* pixels;
+	int rowbytes;
+	int width;
+	int height;
+	RasterRect clip;
+
+	int dirty_top;
+	int dirty_bottom;
+} RasterTarget;
+
+#define DIRTY_MAX_RECTS 8
+
+/*
+ * Screen area that changed this frame, kept as a few disjoint-ish rectangles.
+ * Rectangles that overlap, or whose union wastes little area, are merged as
+ * they are added; when the set is full the cheapest pair is merged.
+ */
+typedef struct
+{
+	RasterRect rects[DIRTY_MAX_RECTS];
+	int count;
+} DirtyRegion;
+
+typedef enum
+{
+	SHAPE_CIRCLE,
+	SHAPE_CAPSULE,
+	SHAPE_BOX,
+} ShapeKind;
+
+/* One pre-rasterized sprite; key packs kind, size, shade and rotation step */
+typedef struct
+{
+	uint32_t key;
+	LCDBitmap* bitmap;
+	int width;
+	int height;
+	size_t bytes;
+	uint32_t last_used;
+} ShapeCacheEntry;
+
+/*
+ * Lazily built sprites for the shapes bodies are drawn with, so drawing one
+ * is a single blit. Entries are evicted least recently used first once their
+ * bitmaps exceed the byte budget.
+ */
+typedef struct
+{
+	ShapeCacheEntry entries[SHAPE_CACHE_MAX_ENTRIES];
+	int count;
+	size_t bytes;
+	size_t budget;
+	uint32_t frame;
+
+	/* Usage counters */
+	uint32_t hits;
+	uint32_t misses;
+	uint32_t evictions;
+} ShapeCache;
+
+#define PROFILER_MAX_SCOPES 16
+#define PROFILER_MAX_DEPTH  8
+#define PROFILER_HISTORY    128
+
+/* A named timer; its time per frame is summed over every time it was opened */
+typedef struct
+{
+	const char* name;
+	int parent;
+	int depth;
+
+	float opened;
+	float frame_ms;
+	float history[PROFILER_HISTORY];
+} ProfileScope;
+
+/* Rolling statistics over the frames in the history ring */
+typedef struct
+{
+	float min;
+	float mean;
+	float max;
+	float p99;
+} ProfileStats;
+
+/*
+ * Frame profiler timed with getElapsedTime, which update() resets at the top
+ * of every frame. Scopes nest; each frame's totals go into a ring buffer.
+ */
+typedef struct
+{
+	ProfileScope scopes[PROFILER_MAX_SCOPES];
+	int scope_count;
+	int stack[PROFILER_MAX_DEPTH];
+	int depth;
+
+	float frame_history[PROFILER_HISTORY];
+	int cursor;
+	int frames;
+	bool overlay;
+} Profiler;
+
+#define HUD_MAX_SLOTS 8
+#define HUD_TEXT_MAX  48
+
+/* One line of HUD text and the bitmap it was last rendered into */
+typedef struct
+{
+	char text[HUD_TEXT_MAX];
+	LCDBitmap* bitmap;
+	int capacity;
+	int x;
+	int y;
+	int width;
+
+	/* Screen area the previous text occupied, repainted with the new text */
+	RasterRect stale;
+	bool changed;
+} HudSlot;
+
+/*
+ * Text overlay whose strings are rendered off screen only when they change;
+ * drawing the HUD is then one blit per slot.
+ */
+typedef struct
+{
+	LCDFont* font;
+	int line_height;
+	HudSlot slots[HUD_MAX_SLOTS];
+	int count;
+} Hud;
+
 struct Renderer
 {
 	LCDFont* font;
 	bool initialized;
+
+	/* Top-left pixel of each particle as last drawn */
+	int16_t* drawn_x;
+	int16_t* drawn_y;
+	int drawn_count;
+	uint32_t drawn_revision;
+	bool full_redraw;
+
+	/* Screen box and sprite key of each body as last drawn, and whether it was asleep then */
+	RasterRect* body_rects;
+	uint32_t* body_keys;
+	bool* body_asleep;
+	int body_count;
+	uint32_t body_revision;
+
+	DirtyRegion dirty;
+	ShapeCache* shapes;
+
+	/* Area the debug and profiler overlays covered last frame */
+	RasterRect debug_bounds;
+	RasterRect profile_bounds;
+
+	Hud* hud;
+	int hud_title;
+	int hud_fps;
+	int hud_particles;
+	int hud_profile;
+	int fps_frames;
+	unsigned int fps_start;
 };
 
 typedef struct
@@ -30,6 +344,15 @@ typedef struct
 	float z;
 } Vector3;
 
+/* Q16.16 fixed-point scalar: 16 integer bits, 16 fractional bits */
+typedef int32_t Fixed;
+
+typedef struct
+{
+	Fixed x;
+	Fixed y;
+} FixedVector2;
+
 typedef struct 
 {
 	Vector2 position;
@@ -39,4 +362,571 @@ typedef struct
 	float mass;
 } Particle;
 
+/* Stable identifier for a particle, valid until the particle is removed */
+typedef uint32_t ParticleHandle;
+
+/*
+ * Structure-of-arrays particle storage. Live particles are densely packed in
+ * [0, count) so the integrator streams through each array linearly; removal
+ * swaps the last particle into the hole and patches the handle tables.
+ */
+struct ParticleWorld
+{
+	/* Hot per-particle state, one contiguous array per component */
+	float* x;
+	float* y;
+	float* prev_x;
+	float* prev_y;
+	float* vx;
+	float* vy;
+	float* fx;
+	float* fy;
+	float* inv_mass;
+
+	/* Handle bookkeeping: handle -> dense index, dense index -> handle */
+	uint32_t* handle_to_index;
+	ParticleHandle* index_to_handle;
+	ParticleHandle* free_handles;
+	int free_count;
+
+	int count;
+	int capacity;
+
+	/* Bumped whenever dense indices may have moved (add, remove, clear) */
+	uint32_t revision;
+};
+
+/* Candidate collision pair, as dense indices into the source arrays */
+typedef struct
+{
+	uint32_t a;
+	uint32_t b;
+} BroadphasePair;
+
+/*
+ * Uniform grid over the screen, rebuilt from scratch every step. Items are
+ * bucketed by cell with a counting sort into flat arrays, so a rebuild is two
+ * linear passes and never touches the allocator.
+ */
+struct BroadphaseGrid
+{
+	float cell_size;
+	float inv_cell_size;
+	int columns;
+	int rows;
+
+	/* cell_start[c]..cell_start[c + 1] indexes the items of cell c in sorted */
+	uint32_t* cell_start;
+	uint32_t* cell_of;
+	uint32_t* sorted;
+	int max_items;
+
+	/* Caller-provided output of the current build, usually frame arena memory */
+	BroadphasePair* pairs;
+	int pair_count;
+	int max_pairs;
+	bool overflowed;
+	/* Set once an overflow has been logged, so a saturated scene warns only once */
+	bool overflow_reported;
+};
+
+/* Marks an unused BroadphasePairSet table slot; real keys always have a < b */
+#define BROADPHASE_PAIR_EMPTY UINT32_MAX
+
+/* One end of an item's extent along a sweep axis: item index << 1, low bit set for a max */
+typedef struct
+{
+	float value;
+	uint32_t item;
+} BroadphaseEndpoint;
+
+/*
+ * Incremental sweep and prune over axis-aligned boxes. The endpoints on both
+ * axes stay sorted from one update to the next, so re-sorting after small
+ * motions is an insertion sort that does little more than one pass. Every
+ * swap of a min past a max starts or ends an overlap on that axis, and the
+ * update turns those swaps into the pairs whose boxes started and stopped
+ * overlapping. It keeps no pair set of its own; a BroadphasePairSet does.
+ */
+struct BroadphaseSap
+{
+	/* Endpoints of every item along x and y, each axis in sorted order */
+	BroadphaseEndpoint* endpoints[2];
+	int item_count;
+	int max_items;
+
+	/* Indices the endpoints refer to; a different count or revision rebuilds */
+	bool built;
+	uint32_t revision;
+
+	/* The boxes as of the last update (min x, min y, max x, max y, max_items each), to tell which overlaps a swap ends */
+	float* bounds;
+
+	/* What the last update changed; after a reset, added is every overlapping pair and the rest is stale */
+	BroadphasePair* added;
+	int added_count;
+	BroadphasePair* removed;
+	int removed_count;
+	int max_changes;
+	bool reset;
+	/* Set when the changes outgrew memory and were cut short; the next update rebuilds */
+	bool overflowed;
+	bool overflow_reported;
+
+	/* Items scanned while opening a rebuild's sweep */
+	uint32_t* open;
+};
+
+/*
+ * Pairs kept from one step to the next: dense for iterating, with an
+ * open-addressing index from pair key to slot so a pair is found and
+ * swap-removed in constant time. Fed by the sweep's changes; capacity
+ * doubles whenever it fills.
+ */
+struct BroadphasePairSet
+{
+	BroadphasePair* pairs;
+	int count;
+	int capacity;
+
+	uint32_t* table_key;
+	uint32_t* table_slot;
+	uint32_t mask;
+	int shift;
+	bool overflow_reported;
+};
+
+/* Upper bound on colour batches; constraints beyond it share one serial batch */
+#define PBD_MAX_COLORS 32
+
+/*
+ * Position-based dynamics constraints over a ParticleWorld. Constraints are
+ * recorded by particle handle; pbd_solver_solve resolves them to dense
+ * indices and greedily colours them so that no two constraints in a batch
+ * share a particle. Each batch is then one independent linear pass.
+ */
+struct PbdSolver
+{
+	int iterations;
+
+	/* Distance constraints as added */
+	ParticleHandle* distance_a;
+	ParticleHandle* distance_b;
+	float* distance_rest;
+	float* distance_stiffness;
+	uint8_t* distance_color;
+	int distance_count;
+	int max_distance;
+
+	/* Solver-ready distance constraints, sorted by colour batch */
+	uint32_t* batch_a;
+	uint32_t* batch_b;
+	float* batch_rest;
+	float* batch_stiffness;
+	int batch_start[PBD_MAX_COLORS + 2];
+	int batch_count;
+	uint32_t* color_mask;
+	int max_particles;
+
+	/* Pins hold a particle at a target position */
+	ParticleHandle* pin_handle;
+	uint32_t* pin_index;
+	float* pin_x;
+	float* pin_y;
+	int pin_count;
+	int max_pins;
+
+	/* Axis-aligned box every particle is kept inside */
+	bool bounded;
+	Vector2 bounds_min;
+	Vector2 bounds_max;
+	float radius;
+
+	/* Batches are rebuilt when constraints or world indices change */
+	bool dirty;
+	uint32_t world_revision;
+};
+
+typedef enum
+{
+	FORCE_GRAVITY,
+	FORCE_DRAG,
+	FORCE_WIND,
+	FORCE_ATTRACTOR,
+} ForceKind;
+
+/* How an attractor's pull fades from its centre out to its radius */
+typedef enum
+{
+	FORCE_FALLOFF_NONE,
+	FORCE_FALLOFF_LINEAR,
+	FORCE_FALLOFF_QUADRATIC,
+} ForceFalloff;
+
+/*
+ * One global force generator. Which fields are read depends on the kind:
+ *   gravity:   vector is an acceleration
+ *   drag:      linear and quadratic are coefficients on speed and speed squared
+ *   wind:      vector is the air's velocity, linear how hard it drags particles along
+ *   attractor: vector is the centre, strength the acceleration there (negative
+ *              repels), fading by falloff to nothing at radius; it acts on the
+ *              dense indices [first, first + count), or all of them when count < 0
+ */
+typedef struct
+{
+	ForceKind kind;
+	Vector2 vector;
+	float linear;
+	float quadratic;
+	float strength;
+	float radius;
+	ForceFalloff falloff;
+	int first;
+	int count;
+} ForceField;
+
+/*
+ * Force generators over a ParticleWorld, applied as whole-array passes:
+ * gravity, drag and wind are summed into one fused pass however many are
+ * registered, each attractor is one more pass, and springs are flat index
+ * arrays resolved from handles the way PbdSolver resolves its constraints.
+ */
+struct ForceRegistry
+{
+	/* Global fields; a slot is reused once its field is removed */
+	ForceField* fields;
+	bool* field_active;
+	int field_count;
+	int max_fields;
+
+	/* Damped springs, recorded by handle */
+	ParticleHandle* spring_a;
+	ParticleHandle* spring_b;
+	float* spring_rest;
+	float* spring_stiffness;
+	float* spring_damping;
+	int spring_count;
+	int max_springs;
+
+	/* Dense indices and this step's force per spring, for the current world layout */
+	uint32_t* spring_index_a;
+	uint32_t* spring_index_b;
+	float* spring_fx;
+	float* spring_fy;
+
+	/* Per-particle mass, written by the uniform pass for the passes after it */
+	float* mass;
+	int max_particles;
+
+	/* Springs are re-resolved when they or the world's indices change */
+	bool dirty;
+	uint32_t world_revision;
+};
+
+#define BODY_MAX_VERTICES 8
+
+typedef enum
+{
+	BODY_SHAPE_CIRCLE,
+	BODY_SHAPE_AABB,
+	BODY_SHAPE_BOX,
+	BODY_SHAPE_POLYGON,
+} BodyShapeType;
+
+/*
+ * Collision shape in body space, centred on the centre of mass. Boxes and
+ * AABBs are four-vertex polygons that also keep their half extents; an AABB
+ * body never rotates. Polygon vertices wind so that (edge.y, -edge.x) points
+ * outwards.
+ */
+typedef struct
+{
+	BodyShapeType type;
+	float radius;
+	Vector2 extent;
+	int count;
+	Vector2 vertices[BODY_MAX_VERTICES];
+	Vector2 normals[BODY_MAX_VERTICES];
+} BodyShape;
+
+/* Everything needed to create a body; a zero density makes it static */
+typedef struct
+{
+	Vector2 position;
+	float angle;
+	Vector2 velocity;
+	float angular_velocity;
+
+	float density;
+	float friction;
+	float restitution;
+	BodyShape shape;
+} Body;
+
+/* Stable identifier for a body, valid until the body is removed */
+typedef uint32_t BodyHandle;
+
+/* The only per-body data a solver iteration reads or writes */
+typedef struct
+{
+	float vx;
+	float vy;
+	float w;
+	float inv_mass;
+	float inv_inertia;
+} BodyVelocity;
+
+/* Position and orientation, with the rotation's cosine and sine cached */
+typedef struct
+{
+	float x;
+	float y;
+	float angle;
+	float c;
+	float s;
+} BodyPose;
+
+typedef struct
+{
+	float min_x;
+	float min_y;
+	float max_x;
+	float max_y;
+} BodyBounds;
+
+/* One contact point, anchored relative to both body centres */
+typedef struct
+{
+	float rax;
+	float ray;
+	float rbx;
+	float rby;
+	float separation;
+	uint32_t id;
+
+	/* Solver terms, filled in by contact_prepare */
+	float normal_mass;
+	float tangent_mass;
+	float bias;
+
+	/* Accumulated impulses, carried over to the next step for warm starting */
+	float normal_impulse;
+	float tangent_impulse;
+} ContactPoint;
+
+/* Up to two contact points between a pair; the normal points from a to b */
+typedef struct
+{
+	uint32_t key;
+	uint32_t a;
+	uint32_t b;
+	float nx;
+	float ny;
+	float friction;
+	float restitution;
+	int point_count;
+	ContactPoint points[2];
+
+	/*
+	 * Two-point normal mass matrix K and its inverse, filled in by
+	 * contact_prepare; block is cleared when K is too ill-conditioned to
+	 * solve both points together
+	 */
+	float k11;
+	float k12;
+	float k22;
+	float inv11;
+	float inv12;
+	float inv22;
+	bool block;
+} ContactManifold;
+
+/* Marks an unused ContactCache slot; real keys always have a < b */
+#define CONTACT_CACHE_EMPTY UINT32_MAX
+
+/*
+ * A body pair's manifold as last computed, with the pose of b relative to a
+ * at that time. key packs the two handles, lower first. A pair that found no
+ * contact is cached too, with no points, so it can be skipped just the same.
+ */
+struct ContactCacheEntry
+{
+	uint32_t key;
+	uint32_t stamp;
+	Vector2 relative;
+	float relative_angle;
+	float angle_a;
+	ContactManifold manifold;
+
+	/* Links in the entry lists of the lower ([0]) and higher ([1]) handle */
+	ContactCacheEntry* next[2];
+	ContactCacheEntry* prev[2];
+};
+
+/* One ContactCache table slot; the entry itself comes from the cache's pool */
+typedef struct
+{
+	uint32_t key;
+	ContactCacheEntry* entry;
+} ContactCacheSlot;
+
+/*
+ * Open-addressing hash table with linear probing, persistent across steps.
+ * The table only holds keys and pointers, so keeping it half empty is cheap,
+ * and entries come and go through a Pool as pairs start and stop touching.
+ * Each body handle also heads a list of its entries, so stale entries are
+ * evicted body by body, for awake bodies only, rather than by walking the
+ * table. Deletion shifts later slots back, so no tombstones build up.
+ */
+typedef struct
+{
+	ContactCacheSlot* slots;
+	Pool* entries;
+	ContactCacheEntry** body_entries;
+	int max_bodies;
+	uint32_t mask;
+	int shift;
+	int count;
+	int max_count;
+	uint32_t stamp;
+
+	/* Usage counters */
+	uint32_t lookups;
+	uint32_t reused;
+	uint32_t evictions;
+} ContactCache;
+
+/*
+ * Rigid bodies with a hot/cold split: velocities and inverse mass are packed
+ * together so the sequential-impulse iterations stream through nothing else,
+ * poses are read by integration and the narrowphase, and the rest (forces,
+ * materials, shapes, handles) is only touched once per step. Live bodies
+ * are dense in [0, count) like ParticleWorld.
+ */
+struct BodyWorld
+{
+	/* Hot */
+	BodyVelocity* velocity;
+
+	/* Warm */
+	BodyPose* pose;
+	BodyBounds* bounds;
+
+	/* Cold */
+	BodyPose* prev_pose;
+	float* fx;
+	float* fy;
+	float* torque;
+	float* density;
+	float* friction;
+	float* restitution;
+	BodyShape* shapes;
+
+	/*
+	 * Sleeping. awake is false for static and sleeping bodies alike; the
+	 * awake dynamic ones are also listed in active, which is all that
+	 * integration and bounds updates walk. A sleeping island is a circular
+	 * list through island_next, so waking it touches only its own bodies.
+	 */
+	bool* awake;
+	float* sleep_time;
+	uint32_t* island_next;
+	uint32_t* active;
+	uint32_t* active_slot;
+	int active_count;
+
+	/* Union-find scratch for this step's islands, indexed by body */
+	uint32_t* island_parent;
+	float* island_sleep;
+
+	uint32_t* handle_to_index;
+	BodyHandle* index_to_handle;
+	BodyHandle* free_handles;
+	int free_count;
+
+	int count;
+	int capacity;
+	uint32_t revision;
+
+	/*
+	 * Broadphase. The awake bodies are swept against each other in sweep,
+	 * sorted by bounds.min_x and kept between steps so re-sorting is nearly
+	 * linear. Static and sleeping bodies don't move, so they are sorted into
+	 * rest only when the awake set changes (awake_revision); each awake body
+	 * then looks up the few it can reach there, rest_reach being the widest
+	 * of them. Wide ones such as a floor would stretch every lookup, so they
+	 * sit in wide and are tested directly.
+	 */
+	uint32_t* sweep;
+	int sweep_count;
+	uint32_t sweep_revision;
+	uint32_t* rest;
+	int rest_count;
+	float rest_reach;
+	uint32_t* wide;
+	int wide_count;
+	uint32_t rest_revision;
+	uint32_t awake_revision;
+
+	/* This step's touching pairs, copied out of the cache so the solver walks them densely */
+	ContactManifold* manifolds;
+	ContactCacheEntry** manifold_entries;
+	int manifold_count;
+	int max_manifolds;
+	ContactCache* cache;
+
+	Vector2 gravity;
+	int iterations;
+};
+
+/*
+ * Rewind history. The newest recorded frame is kept in full as quantized
+ * state; every frame in the ring stores only the objects that changed since
+ * the frame before it, as the deltas back to it. Stepping back applies the
+ * newest frame's deltas and drops it, so neither recording nor rewinding
+ * ever copies the whole world. Frames are variable-length records in one
+ * byte ring, and the oldest are dropped to make room.
+ */
+struct RewindBuffer
+{
+	uint8_t* data;
+	uint32_t size;
+
+	/* Ring of frame records, oldest first */
+	uint32_t* frame_offset;
+	uint32_t* frame_size;
+	int max_frames;
+	int first_frame;
+	int frame_count;
+
+	/* Quantized newest frame: x, y, vx, vy per particle; x, y, angle, vx, vy, w per body */
+	int32_t* particle_state;
+	int32_t* body_state;
+	int particle_capacity;
+	int body_capacity;
+
+	/* What the state was taken from; any add or remove since invalidates the history */
+	bool has_base;
+	int particle_count;
+	int body_count;
+	uint32_t particle_revision;
+	uint32_t body_revision;
+
+	/* A frame is encoded here before it is known how much of the ring it needs */
+	uint8_t* scratch;
+	uint32_t scratch_size;
+};
+
+/*
+ * Streams InputFrames to a file in blocks of INPUT_RECORD_BLOCK, so the
+ * device only touches the filesystem every few seconds.
+ */
+struct InputRecorder
+{
+	SDFile* file;
+	InputFrame frames[INPUT_RECORD_BLOCK];
+	int buffered;
+	int frame_count;
+};
+
 #endif // !STRUCTS_H
@@ -0,0 +1,7 @@
+#ifndef TIMESTEP_H
+#define TIMESTEP_H
+
+void timestep_init(Timestep* timestep, float step, int max_substeps);
+int timestep_advance(Timestep* timestep, float elapsed);
+
+#endif /* TIMESTEP_H */
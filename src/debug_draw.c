@@ -0,0 +1,152 @@
+#include "common.h"
+#include "debug_draw.h"
+#include "raster.h"
+
+#ifdef PLAYSICS_DEBUG_DRAW
+
+typedef enum
+{
+    DEBUG_COMMAND_LINE,
+    DEBUG_COMMAND_CIRCLE,
+    DEBUG_COMMAND_POINT,
+} DebugCommandKind;
+
+typedef struct
+{
+    DebugCommandKind kind;
+    float x0;
+    float y0;
+    float x1;
+    float y1;
+} DebugCommand;
+
+/* Preallocated so pushing a command never touches the allocator */
+static DebugCommand debug_commands[DEBUG_DRAW_MAX_COMMANDS];
+static int debug_count = 0;
+static int debug_dropped = 0;
+static bool debug_enabled = false;
+static RasterRect debug_bounds = { 0, 0, 0, 0 };
+
+void debug_draw_set_enabled(bool enabled)
+{
+    debug_enabled = enabled;
+    if (!enabled)
+    {
+        debug_draw_begin();
+    }
+}
+
+bool debug_draw_enabled(void)
+{
+    return debug_enabled;
+}
+
+/* Drops the previous step's commands */
+void debug_draw_begin(void)
+{
+    debug_count = 0;
+    debug_dropped = 0;
+    debug_bounds = (RasterRect){ 0, 0, 0, 0 };
+}
+
+static void debug_draw_push(DebugCommandKind kind, float x0, float y0, float x1, float y1,
+                            float min_x, float min_y, float max_x, float max_y)
+{
+    if (!debug_enabled)
+    {
+        return;
+    }
+    if (debug_count == DEBUG_DRAW_MAX_COMMANDS)
+    {
+        debug_dropped++;
+        return;
+    }
+
+    debug_commands[debug_count++] = (DebugCommand){ kind, x0, y0, x1, y1 };
+
+    // Grow the covered area, with a pixel of slack for rounding
+    RasterRect rect = { (int)floorf(min_x) - 1, (int)floorf(min_y) - 1, (int)ceilf(max_x) + 2, (int)ceilf(max_y) + 2 };
+    if (debug_bounds.left >= debug_bounds.right)
+    {
+        debug_bounds = rect;
+    }
+    else
+    {
+        debug_bounds.left = MIN(debug_bounds.left, rect.left);
+        debug_bounds.top = MIN(debug_bounds.top, rect.top);
+        debug_bounds.right = MAX(debug_bounds.right, rect.right);
+        debug_bounds.bottom = MAX(debug_bounds.bottom, rect.bottom);
+    }
+}
+
+void debug_draw_line(float x0, float y0, float x1, float y1)
+{
+    debug_draw_push(DEBUG_COMMAND_LINE, x0, y0, x1, y1, fminf(x0, x1), fminf(y0, y1), fmaxf(x0, x1), fmaxf(y0, y1));
+}
+
+void debug_draw_circle(float x, float y, float radius)
+{
+    debug_draw_push(DEBUG_COMMAND_CIRCLE, x, y, radius, 0.0f, x - radius, y - radius, x + radius, y + radius);
+}
+
+void debug_draw_aabb(float min_x, float min_y, float max_x, float max_y)
+{
+    debug_draw_line(min_x, min_y, max_x, min_y);
+    debug_draw_line(max_x, min_y, max_x, max_y);
+    debug_draw_line(max_x, max_y, min_x, max_y);
+    debug_draw_line(min_x, max_y, min_x, min_y);
+}
+
+void debug_draw_point(float x, float y)
+{
+    debug_draw_push(DEBUG_COMMAND_POINT, x, y, 0.0f, 0.0f, x - 1.0f, y - 1.0f, x + 1.0f, y + 1.0f);
+}
+
+void debug_draw_normal(float x, float y, float nx, float ny, float length)
+{
+    debug_draw_point(x, y);
+    debug_draw_line(x, y, x + nx * length, y + ny * length);
+}
+
+/* Screen area the current commands cover, empty if there are none */
+RasterRect debug_draw_bounds(void)
+{
+    return debug_bounds;
+}
+
+/* Rasterizes every recorded command into the target; the buffer is kept until the next step */
+void debug_draw_flush(RasterTarget* target)
+{
+    for (int i = 0; i < debug_count; ++i)
+    {
+        const DebugCommand* command = &debug_commands[i];
+        switch (command->kind)
+        {
+            case DEBUG_COMMAND_LINE:
+                raster_draw_line(target, (int)floorf(command->x0), (int)floorf(command->y0),
+                                 (int)floorf(command->x1), (int)floorf(command->y1));
+                break;
+
+            case DEBUG_COMMAND_CIRCLE:
+                raster_draw_circle(target, (int)floorf(command->x0), (int)floorf(command->y0),
+                                   (int)(command->x1 + 0.5f));
+                break;
+
+            case DEBUG_COMMAND_POINT:
+            {
+                int16_t x = (int16_t)((int)floorf(command->x0) - 1);
+                int16_t y = (int16_t)((int)floorf(command->y0) - 1);
+                raster_fill_squares(target, &x, &y, 1, 3);
+                break;
+            }
+        }
+    }
+
+    if (debug_dropped > 0)
+    {
+        pd->system->logToConsole("debug draw: %d commands dropped (capacity: %d)", debug_dropped, DEBUG_DRAW_MAX_COMMANDS);
+        debug_dropped = 0;
+    }
+}
+
+#endif // PLAYSICS_DEBUG_DRAW
@@ -0,0 +1,80 @@
+#include "common.h"
+#include "dirty.h"
+
+static inline RasterRect dirty_rect_union(RasterRect a, RasterRect b)
+{
+    return (RasterRect){ MIN(a.left, b.left), MIN(a.top, b.top), MAX(a.right, b.right), MAX(a.bottom, b.bottom) };
+}
+
+static inline int dirty_rect_area(RasterRect rect)
+{
+    return (rect.right - rect.left) * (rect.bottom - rect.top);
+}
+
+/* Pixels a merge would redraw that neither rectangle needed */
+static inline int dirty_merge_waste(RasterRect a, RasterRect b)
+{
+    return dirty_rect_area(dirty_rect_union(a, b)) - dirty_rect_area(a) - dirty_rect_area(b);
+}
+
+void dirty_region_clear(DirtyRegion* region)
+{
+    region->count = 0;
+}
+
+void dirty_region_add(DirtyRegion* region, RasterRect rect)
+{
+    if (raster_rect_empty(rect))
+    {
+        return;
+    }
+
+    // Fold in every rectangle that touches the new one or is nearly free to
+    // merge; the grown rectangle may now reach others, so rescan after each
+    for (int i = 0; i < region->count; )
+    {
+        RasterRect other = region->rects[i];
+        if (raster_rect_overlaps(rect, other) || dirty_merge_waste(rect, other) <= 0)
+        {
+            rect = dirty_rect_union(rect, other);
+            region->rects[i] = region->rects[--region->count];
+            i = 0;
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    if (region->count == DIRTY_MAX_RECTS)
+    {
+        // Full: merge with whichever rectangle wastes the least
+        int best = 0;
+        int best_waste = dirty_merge_waste(rect, region->rects[0]);
+        for (int i = 1; i < region->count; ++i)
+        {
+            int waste = dirty_merge_waste(rect, region->rects[i]);
+            if (waste < best_waste)
+            {
+                best = i;
+                best_waste = waste;
+            }
+        }
+        rect = dirty_rect_union(rect, region->rects[best]);
+        region->rects[best] = region->rects[--region->count];
+    }
+
+    region->rects[region->count++] = rect;
+}
+
+bool dirty_region_intersects(const DirtyRegion* region, RasterRect rect)
+{
+    for (int i = 0; i < region->count; ++i)
+    {
+        if (raster_rect_overlaps(region->rects[i], rect))
+        {
+            return true;
+        }
+    }
+    return false;
+}
@@ -2,6 +2,35 @@
 #include "engine.h"
 #include "logging.h"
 #include "renderer.h"
+#include "memory.h"
+#include "timestep.h"
+#include "simulation.h"
+#include "input.h"
+#include "snapshot.h"
+#include "debug_draw.h"
+#include "profiler.h"
+
+static PDMenuItem* engine_debug_item = NULL;
+
+/* System menu checkmark that switches the debug overlays on and off */
+static void engine_toggle_debug(void* userdata)
+{
+	Engine* engine = (Engine*)userdata;
+	engine->debug = pd->system->getMenuItemValue(engine_debug_item) != 0;
+#ifdef PLAYSICS_DEBUG_DRAW
+	debug_draw_set_enabled(engine->debug);
+#endif
+#ifdef PLAYSICS_PROFILER
+	profiler_set_overlay(engine->debug);
+#endif
+}
+
+#ifdef PLAYSICS_PROFILER
+static void engine_dump_profile(void* userdata)
+{
+	profiler_dump_csv(PROFILER_CSV_PATH);
+}
+#endif
 
 void engine_init(Engine* engine)
 {
@@ -12,6 +41,19 @@ void engine_init(Engine* engine)
 	}
 
 	engine->debug = false;
+	engine_debug_item = pd->system->addCheckmarkMenuItem("Debug", 0, engine_toggle_debug, engine);
+#ifdef PLAYSICS_PROFILER
+	pd->system->addMenuItem("Dump profile", engine_dump_profile, engine);
+#endif
+	timestep_init(&engine->timestep, (float)LOGIC_RATE, MAX_SUBSTEPS);
+
+	engine->frame_arena = arena_create(FRAME_ARENA_SIZE);
+	if (engine->frame_arena == NULL)
+	{
+		LOG_ERROR("engine:init: Failed to create frame arena");
+		return;
+	}
+
 	engine->renderer = renderer_create();
 	if (engine->renderer == NULL)
 	{
@@ -19,29 +61,114 @@ void engine_init(Engine* engine)
 		return;
 	}
 	renderer_init(engine->renderer);
+
+	if (!simulation_init(engine))
+	{
+		LOG_ERROR("engine:init: Failed to create the simulation");
+		return;
+	}
+
+#if defined(PLAYSICS_RECORD_INPUT) && defined(PLAYSICS_LUA)
+	// playsics.* calls change the worlds outside the recorded input, so no replay could follow them
+	LOG_WARNING("input recording is off while the Lua bridge drives the engine");
+#elif defined(PLAYSICS_RECORD_INPUT)
+	// Every session is recorded from the first frame, for playsics_replay on the host
+	engine->recorder = input_recorder_create(INPUT_RECORD_PATH, engine->timestep.step);
+#endif
+}
+
+void engine_begin_frame(Engine* engine)
+{
+	// Everything allocated from the frame arena last frame is dead now
+	if (engine != NULL && engine->frame_arena != NULL)
+	{
+		arena_reset(engine->frame_arena);
+	}
 }
 
 void engine_input(Engine* engine)
 {
+	if (engine == NULL || engine->particles == NULL || engine->bodies == NULL)
+	{
+		return;
+	}
+
+	input_sample(&engine->input);
+
+	// A saves the world, B puts it back; loading restarts the rewind history,
+	// and ends any input recording, since a replay can't reproduce the file
+	if (engine->input.pushed & kButtonA)
+	{
+		snapshot_save(SNAPSHOT_PATH, engine->particles, engine->bodies);
+	}
+	if (engine->input.pushed & kButtonB)
+	{
+		if (engine->recorder != NULL)
+		{
+			input_recorder_destroy(engine->recorder, simulation_hash(engine));
+			engine->recorder = NULL;
+		}
+		snapshot_load(SNAPSHOT_PATH, engine->particles, engine->bodies);
+	}
+
+	simulation_input(engine, &engine->input);
 }
 
 void engine_update(Engine* engine)
 {
+	if (engine == NULL)
+	{
+		return;
+	}
+
+	simulation_step(engine);
+	engine->input.steps++;
 }
 
-void engine_render(Engine* engine)
+/* Called once the frame's steps have run; the frame is complete and can be recorded */
+void engine_end_frame(Engine* engine)
 {
-	if (engine != NULL && engine->renderer != NULL)
+	if (engine != NULL && engine->recorder != NULL)
 	{
-		renderer_draw(engine->renderer);
+		input_recorder_write(engine->recorder, &engine->input);
 	}
 }
 
+/* Returns whether anything on screen changed */
+bool engine_render(Engine* engine)
+{
+	if (engine == NULL || engine->renderer == NULL)
+	{
+		return false;
+	}
+	return renderer_draw(engine->renderer, engine->particles, engine->bodies, engine->timestep.alpha);
+}
+
 void engine_destroy(Engine* engine)
 {
+	if (engine->frame_arena != NULL)
+	{
+		arena_report(engine->frame_arena, "frame arena");
+		arena_destroy(engine->frame_arena);
+		engine->frame_arena = NULL;
+	}
+
+	if (engine->recorder != NULL)
+	{
+		input_recorder_destroy(engine->recorder, simulation_hash(engine));
+		engine->recorder = NULL;
+	}
+
+	simulation_destroy(engine);
+
 	if (engine->renderer != NULL)
 	{
 		renderer_destroy(engine->renderer);
 		engine->renderer = NULL;
 	}
+
+#ifdef PLAYSICS_MEMORY_TRACKING
+	// Every engine allocation is released by now; whatever is still live leaked
+	memory_report();
+#endif
 }
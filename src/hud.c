@@ -0,0 +1,168 @@
+#include <stdarg.h>
+
+#include "common.h"
+#include "hud.h"
+#include "dirty.h"
+#include "logging.h"
+#include "memory.h"
+
+/* Bitmaps grow in steps of this many pixels so a ticking counter keeps its bitmap */
+#define HUD_WIDTH_GRANULE 16
+
+Hud* hud_create(LCDFont* font)
+{
+    if (font == NULL)
+    {
+        LOG_ERROR("hud:create: Invalid parameters");
+        return NULL;
+    }
+
+    Hud* hud = (Hud*)pd_malloc(sizeof(Hud));
+    if (hud == NULL)
+    {
+        LOG_ERROR("hud:create: Memory allocation failed");
+        return NULL;
+    }
+
+    hud->font = font;
+    hud->line_height = pd->graphics->getFontHeight(font);
+    hud->count = 0;
+
+    return hud;
+}
+
+void hud_destroy(Hud* hud)
+{
+    if (hud != NULL)
+    {
+        for (int i = 0; i < hud->count; ++i)
+        {
+            if (hud->slots[i].bitmap != NULL)
+            {
+                pd->graphics->freeBitmap(hud->slots[i].bitmap);
+            }
+        }
+        pd_free(hud);
+    }
+}
+
+/* Adds an empty line of text at (x, y); returns its slot or -1 when full */
+int hud_add(Hud* hud, int x, int y)
+{
+    if (hud->count == HUD_MAX_SLOTS)
+    {
+        LOG_WARNING("HUD slots full (capacity: %d)", HUD_MAX_SLOTS);
+        return -1;
+    }
+
+    HudSlot* slot = &hud->slots[hud->count];
+    slot->text[0] = '\0';
+    slot->bitmap = NULL;
+    slot->capacity = 0;
+    slot->x = x;
+    slot->y = y;
+    slot->width = 0;
+    slot->stale = (RasterRect){ 0, 0, 0, 0 };
+    slot->changed = false;
+
+    return hud->count++;
+}
+
+static RasterRect hud_slot_rect(const Hud* hud, const HudSlot* slot)
+{
+    return (RasterRect){ slot->x, slot->y, slot->x + slot->width, slot->y + hud->line_height };
+}
+
+/* Re-renders a slot's bitmap, but only if its text actually changed */
+void hud_set_text(Hud* hud, int index, const char* text)
+{
+    if (index < 0 || index >= hud->count)
+    {
+        return;
+    }
+
+    HudSlot* slot = &hud->slots[index];
+    if (strncmp(slot->text, text, HUD_TEXT_MAX - 1) == 0)
+    {
+        return;
+    }
+
+    // The old text's area must be repainted even if the new text is shorter
+    if (!slot->changed)
+    {
+        slot->stale = hud_slot_rect(hud, slot);
+        slot->changed = true;
+    }
+
+    STRCPY(slot->text, text);
+    size_t length = strlen(slot->text);
+    slot->width = pd->graphics->getTextWidth(hud->font, slot->text, length, kASCIIEncoding, 0);
+
+    if (slot->width > slot->capacity || slot->bitmap == NULL)
+    {
+        if (slot->bitmap != NULL)
+        {
+            pd->graphics->freeBitmap(slot->bitmap);
+        }
+        slot->capacity = (slot->width + HUD_WIDTH_GRANULE) & ~(HUD_WIDTH_GRANULE - 1);
+        slot->bitmap = pd->graphics->newBitmap(slot->capacity, hud->line_height, kColorClear);
+        if (slot->bitmap == NULL)
+        {
+            LOG_ERROR("hud:set_text: Failed to create %dx%d bitmap", slot->capacity, hud->line_height);
+            slot->capacity = 0;
+            slot->width = 0;
+            return;
+        }
+    }
+    else
+    {
+        pd->graphics->clearBitmap(slot->bitmap, kColorClear);
+    }
+
+    pd->graphics->pushContext(slot->bitmap);
+    pd->graphics->setFont(hud->font);
+    pd->graphics->drawText(slot->text, length, kASCIIEncoding, 0, 0);
+    pd->graphics->popContext();
+}
+
+void hud_printf(Hud* hud, int slot, const char* format, ...)
+{
+    char text[HUD_TEXT_MAX];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+
+    hud_set_text(hud, slot, text);
+}
+
+/* Adds the old and new area of every slot whose text changed since the last call */
+void hud_collect_dirty(Hud* hud, DirtyRegion* region)
+{
+    for (int i = 0; i < hud->count; ++i)
+    {
+        HudSlot* slot = &hud->slots[i];
+        if (slot->changed)
+        {
+            dirty_region_add(region, slot->stale);
+            dirty_region_add(region, hud_slot_rect(hud, slot));
+            slot->changed = false;
+        }
+    }
+}
+
+/*
+ * Blits the slots that overlap the region. Text has a transparent background,
+ * so redrawing a slot over its own unchanged pixels is harmless.
+ */
+void hud_draw(const Hud* hud, const DirtyRegion* region)
+{
+    for (int i = 0; i < hud->count; ++i)
+    {
+        const HudSlot* slot = &hud->slots[i];
+        if (slot->bitmap != NULL && slot->width > 0 && dirty_region_intersects(region, hud_slot_rect(hud, slot)))
+        {
+            pd->graphics->drawBitmap(slot->bitmap, slot->x, slot->y, kBitmapUnflipped);
+        }
+    }
+}
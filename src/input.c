@@ -0,0 +1,299 @@
+#include "common.h"
+#include "input.h"
+#include "logging.h"
+#include "memory.h"
+
+/*
+ * Recording layout, native byte order:
+ *
+ *   InputHeader, then one InputFrame per frame in the order they ran
+ *
+ * The header is written with frame_count INPUT_UNFINISHED and patched with
+ * the real count and the final state hash when the recorder is destroyed.
+ * A session cut short (the game crashed, the battery died) still replays up
+ * to its last whole block; there is just no hash to check it against.
+ *
+ * The hash is over raw float bits, so it only means something for a build
+ * that rounds every float the same way. The header names the compiler and
+ * the options that change the arithmetic, and input_session_mismatch says
+ * whether this build can reproduce it.
+ */
+
+#define INPUT_MAGIC      0x504E4950u // "PINP"
+#define INPUT_VERSION    4u // 2: the crank only rewinds with REWIND_BUTTON held; 3: platform; 4: build and compiler
+#define INPUT_UNFINISHED (-1)
+
+/* Options that pick different arithmetic; a session only replays exactly under the same ones */
+#define INPUT_BUILD_FIXED_POINT 0x01u
+#define INPUT_BUILD_FAST_MATH   0x02u
+#define INPUT_BUILD_SWEEP_PRUNE 0x04u
+#define INPUT_BUILD_OPTIONS     0x07u
+
+/* How the compiler targeted the build, which only matters where it can round differently */
+#define INPUT_BUILD_DEVICE      0x10u
+#define INPUT_BUILD_FMA         0x20u
+#define INPUT_BUILD_OPTIMIZED   0x40u
+
+static const uint32_t INPUT_BUILD = 0u
+#ifdef PLAYSICS_FIXED_POINT
+    | INPUT_BUILD_FIXED_POINT
+#endif
+#ifdef PLAYSICS_FAST_MATH
+    | INPUT_BUILD_FAST_MATH
+#endif
+#ifdef PLAYSICS_SWEEP_PRUNE
+    | INPUT_BUILD_SWEEP_PRUNE
+#endif
+#ifdef TARGET_PLAYDATE
+    | INPUT_BUILD_DEVICE
+#endif
+#ifdef __FP_FAST_FMAF
+    | INPUT_BUILD_FMA
+#endif
+#ifdef __OPTIMIZE__
+    | INPUT_BUILD_OPTIMIZED
+#endif
+    ;
+
+#define INPUT_STRINGIFY_VALUE(x) #x
+#define INPUT_STRINGIFY(x) INPUT_STRINGIFY_VALUE(x)
+
+#if defined(__clang__)
+#define INPUT_COMPILER "clang " __clang_version__
+#elif defined(__GNUC__)
+#define INPUT_COMPILER "gcc " __VERSION__
+#elif defined(_MSC_VER)
+#define INPUT_COMPILER "msvc " INPUT_STRINGIFY(_MSC_FULL_VER)
+#else
+#define INPUT_COMPILER "unknown"
+#endif
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    float step;
+    int32_t frame_count;
+    uint32_t state_hash;
+    uint32_t build;
+    char compiler[INPUT_COMPILER_SIZE];
+} InputHeader;
+
+/* === SAMPLING === */
+
+void input_sample(InputFrame* frame)
+{
+    PDButtons current, pushed, released;
+    pd->system->getButtonState(&current, &pushed, &released);
+
+    float change = pd->system->isCrankDocked() ? 0.0f : pd->system->getCrankChange();
+    float crank = float_clamp(change * INPUT_CRANK_SCALE, (float)INT16_MIN, (float)INT16_MAX);
+
+    frame->crank = (int16_t)(crank >= 0.0f ? crank + 0.5f : crank - 0.5f);
+    frame->buttons = (uint8_t)current;
+    frame->pushed = (uint8_t)pushed;
+    frame->released = (uint8_t)released;
+    frame->steps = 0;
+}
+
+/* Degrees the crank turned this frame, as the simulation sees it */
+float input_crank_change(const InputFrame* frame)
+{
+    return (float)frame->crank / INPUT_CRANK_SCALE;
+}
+
+/* === RECORDING === */
+
+InputRecorder* input_recorder_create(const char* path, float step)
+{
+    InputRecorder* recorder = (InputRecorder*)pd_calloc(1, sizeof(InputRecorder));
+    if (recorder == NULL)
+    {
+        LOG_ERROR("input:recorder_create: Memory allocation failed");
+        return NULL;
+    }
+
+    recorder->file = pd->file->open(path, kFileWrite);
+    if (recorder->file == NULL)
+    {
+        LOG_ERROR("input:recorder_create: Couldn't open %s: %s", path, pd->file->geterr());
+        pd_free(recorder);
+        return NULL;
+    }
+
+    InputHeader header = { INPUT_MAGIC, INPUT_VERSION, step, INPUT_UNFINISHED, 0, INPUT_BUILD, "" };
+    strncpy(header.compiler, INPUT_COMPILER, sizeof(header.compiler) - 1);
+    if (pd->file->write(recorder->file, &header, sizeof(header)) != (int)sizeof(header))
+    {
+        LOG_ERROR("input:recorder_create: Couldn't write %s: %s", path, pd->file->geterr());
+        pd->file->close(recorder->file);
+        pd_free(recorder);
+        return NULL;
+    }
+    return recorder;
+}
+
+/* Writes out the buffered block; on failure the recording stops where it is */
+static bool input_recorder_flush(InputRecorder* recorder)
+{
+    if (recorder->file == NULL || recorder->buffered == 0)
+    {
+        return recorder->file != NULL;
+    }
+
+    int size = (int)sizeof(InputFrame) * recorder->buffered;
+    recorder->buffered = 0;
+    if (pd->file->write(recorder->file, recorder->frames, (unsigned int)size) != size)
+    {
+        LOG_WARNING("input recording stopped: %s", pd->file->geterr());
+        pd->file->close(recorder->file);
+        recorder->file = NULL;
+        return false;
+    }
+    return true;
+}
+
+bool input_recorder_write(InputRecorder* recorder, const InputFrame* frame)
+{
+    if (recorder == NULL || recorder->file == NULL)
+    {
+        return false;
+    }
+
+    recorder->frames[recorder->buffered++] = *frame;
+    recorder->frame_count++;
+    if (recorder->buffered == INPUT_RECORD_BLOCK)
+    {
+        return input_recorder_flush(recorder);
+    }
+    return true;
+}
+
+/* Flushes what is left and seals the recording with the state the last frame ended in */
+void input_recorder_destroy(InputRecorder* recorder, uint32_t state_hash)
+{
+    if (recorder == NULL)
+    {
+        return;
+    }
+
+    if (input_recorder_flush(recorder))
+    {
+        // Patch the count and hash into the header's tail
+        int32_t tail[2] = { recorder->frame_count, (int32_t)state_hash };
+        if (pd->file->seek(recorder->file, (int)offsetof(InputHeader, frame_count), SEEK_SET) != 0 ||
+            pd->file->write(recorder->file, tail, sizeof(tail)) != (int)sizeof(tail))
+        {
+            LOG_WARNING("couldn't finish the input recording: %s", pd->file->geterr());
+        }
+        pd->file->close(recorder->file);
+        pd->system->logToConsole("input: recorded %d frames, state hash %08x", recorder->frame_count,
+                                 (unsigned)state_hash);
+    }
+    pd_free(recorder);
+}
+
+/* === REPLAY === */
+
+InputSession* input_session_load(const char* path)
+{
+    SDFile* file = pd->file->open(path, kFileReadData);
+    if (file == NULL)
+    {
+        LOG_ERROR("input:session_load: Couldn't open %s: %s", path, pd->file->geterr());
+        return NULL;
+    }
+
+    InputHeader header;
+    int end = -1;
+    if (pd->file->read(file, &header, sizeof(header)) != (int)sizeof(header) || header.magic != INPUT_MAGIC ||
+        header.version != INPUT_VERSION || !(header.step > 0.0f) || pd->file->seek(file, 0, SEEK_END) != 0 ||
+        (end = pd->file->tell(file)) < (int)sizeof(header) ||
+        pd->file->seek(file, (int)sizeof(header), SEEK_SET) != 0)
+    {
+        LOG_ERROR("input:session_load: %s is not an input recording", path);
+        pd->file->close(file);
+        return NULL;
+    }
+
+    // An unfinished recording holds however many whole frames made it to the file
+    int stored = (end - (int)sizeof(header)) / (int)sizeof(InputFrame);
+    bool finished = header.frame_count != INPUT_UNFINISHED;
+    if (finished && (header.frame_count < 0 || header.frame_count > stored))
+    {
+        LOG_ERROR("input:session_load: %s is truncated", path);
+        pd->file->close(file);
+        return NULL;
+    }
+    int count = finished ? header.frame_count : stored;
+
+    InputSession* session = (InputSession*)pd_calloc(1, sizeof(InputSession));
+    InputFrame* frames = (InputFrame*)pd_malloc(sizeof(InputFrame) * (size_t)MAX(count, 1));
+    if (session == NULL || frames == NULL)
+    {
+        LOG_ERROR("input:session_load: Memory allocation failed");
+        pd_free(session);
+        pd_free(frames);
+        pd->file->close(file);
+        return NULL;
+    }
+
+    int size = (int)sizeof(InputFrame) * count;
+    bool ok = pd->file->read(file, frames, (unsigned int)size) == size;
+    pd->file->close(file);
+    if (!ok)
+    {
+        LOG_ERROR("input:session_load: Couldn't read %s", path);
+        pd_free(frames);
+        pd_free(session);
+        return NULL;
+    }
+
+    session->step = header.step;
+    session->finished = finished;
+    session->build = header.build;
+    memcpy(session->compiler, header.compiler, sizeof(session->compiler));
+    session->compiler[sizeof(session->compiler) - 1] = '\0';
+    session->state_hash = header.state_hash;
+    session->frame_count = count;
+    session->frames = frames;
+    return session;
+}
+
+void input_session_destroy(InputSession* session)
+{
+    if (session == NULL)
+    {
+        return;
+    }
+    pd_free(session->frames);
+    pd_free(session);
+}
+
+/*
+ * Why this build can't reproduce the session's state hash, or NULL if it
+ * can. Fixed-point builds turn off contraction and keep libm's trig out of
+ * the step, leaving only IEEE arithmetic that rounds the same on every
+ * target, so they agree across compilers and with the device. Any other
+ * build only agrees with the same compiler targeting the same hardware.
+ */
+const char* input_session_mismatch(const InputSession* session)
+{
+    if ((session->build & INPUT_BUILD_OPTIONS) != (INPUT_BUILD & INPUT_BUILD_OPTIONS))
+    {
+        return "recorded with other PLAYSICS_FIXED_POINT, PLAYSICS_FAST_MATH or PLAYSICS_SWEEP_PRUNE settings";
+    }
+    if (INPUT_BUILD & INPUT_BUILD_FIXED_POINT)
+    {
+        return NULL;
+    }
+    if ((session->build & INPUT_BUILD_DEVICE) != (INPUT_BUILD & INPUT_BUILD_DEVICE))
+    {
+        return (session->build & INPUT_BUILD_DEVICE) ? "recorded on the device" : "recorded off the device";
+    }
+    if (session->build != INPUT_BUILD || strcmp(session->compiler, INPUT_COMPILER) != 0)
+    {
+        return "recorded by another compiler or with other optimization settings";
+    }
+    return NULL;
+}
@@ -0,0 +1,309 @@
+#include "common.h"
+#include "lua_bridge.h"
+#include "logging.h"
+#include "memory.h"
+#include "raster.h"
+#include "physics/particle.h"
+#include "physics/force.h"
+
+/*
+ * Lua bindings for the C worlds, all of them bulk calls: one Lua-to-C
+ * transition spawns, pushes or reads back a whole range of objects, never a
+ * single one. Ranges are dense indices, which stay put as long as nothing is
+ * removed. The C Lua API cannot write into tables, so read-backs return a
+ * string of packed native floats for string.unpack (or draw straight into a
+ * bitmap) and Lua keeps its own reused table. Registered as the global table
+ * playsics:
+ *
+ *   playsics.update()                                  -> changed
+ *   playsics.count()                                   -> particles, bodies
+ *   playsics.spawn(n, x, y, w, h [, vx, vy])           -> first, spawned
+ *   playsics.force(x, y, radius, strength [, first, n])
+ *   playsics.positions([first, n])                     -> "ff" per particle
+ *   playsics.bodies([first, n])                        -> "fff" per body
+ *   playsics.draw(bitmap [, size, first, n])
+ */
+
+static Engine* lua_bridge_engine = NULL;
+static PDCallbackFunction* lua_bridge_update_callback = NULL;
+
+/* Registry attractors lent to playsics.force, and how many it has used since the last update */
+static int lua_bridge_forces[LUA_FORCE_FIELDS];
+static int lua_bridge_force_count = 0;
+
+/* Optional argument at pos, or fallback when it is nil or missing */
+static int lua_bridge_opt_int(int pos, int fallback)
+{
+    return pd->lua->getArgCount() < pos || pd->lua->argIsNil(pos) ? fallback : pd->lua->getArgInt(pos);
+}
+
+static float lua_bridge_opt_float(int pos, float fallback)
+{
+    return pd->lua->getArgCount() < pos || pd->lua->argIsNil(pos) ? fallback : pd->lua->getArgFloat(pos);
+}
+
+/* Reads an optional (first, count) pair at pos and clips it to [0, total) */
+static void lua_bridge_range(int pos, int total, int* first, int* count)
+{
+    int start = MAX(lua_bridge_opt_int(pos, 0), 0);
+    int end = MIN(start + lua_bridge_opt_int(pos + 1, total), total);
+    *first = MIN(start, total);
+    *count = MAX(end - start, 0);
+}
+
+/* Returns floats to Lua as one string of native floats; Lua takes its own copy */
+static void lua_bridge_push_floats(const float* values, int count)
+{
+    pd->lua->pushBytes((const char*)values, sizeof(float) * (size_t)count);
+}
+
+/* ========================================================================== */
+/* FUNCTIONS                                                                  */
+/* ========================================================================== */
+
+/* Runs one frame of the C game loop: input, fixed steps and render */
+static int lua_bridge_update(lua_State* L)
+{
+    (void)L;
+    pd->lua->pushBool(lua_bridge_update_callback(NULL));
+
+    // Forces last one update; the attractors stay registered, idle at zero strength
+    for (int i = 0; i < lua_bridge_force_count; ++i)
+    {
+        force_get_field(lua_bridge_engine->forces, lua_bridge_forces[i])->strength = 0.0f;
+    }
+    lua_bridge_force_count = 0;
+    return 1;
+}
+
+static int lua_bridge_count(lua_State* L)
+{
+    (void)L;
+    pd->lua->pushInt(lua_bridge_engine->particles->count);
+    pd->lua->pushInt(lua_bridge_engine->bodies->count);
+    return 2;
+}
+
+/*
+ * Fills the w x h rectangle at (x, y) with up to n particles on an even
+ * grid, all starting with the same velocity. Returns the index of the first
+ * one and how many fitted in the world.
+ */
+static int lua_bridge_spawn(lua_State* L)
+{
+    (void)L;
+    ParticleWorld* particles = lua_bridge_engine->particles;
+    int n = pd->lua->getArgInt(1);
+    float x = pd->lua->getArgFloat(2);
+    float y = pd->lua->getArgFloat(3);
+    float w = pd->lua->getArgFloat(4);
+    float h = pd->lua->getArgFloat(5);
+
+    Particle particle;
+    memset(&particle, 0, sizeof(particle));
+    particle.velocity = vec2_new(lua_bridge_opt_float(6, 0.0f), lua_bridge_opt_float(7, 0.0f));
+    particle.mass = 1.0f;
+
+    // Square-ish cells: columns / rows matches the rectangle's aspect
+    int columns = n > 0 ? MAX(1, (int)ceilf(VECTOR_SQRTF((float)n * w / MAX(h, 1.0f)))) : 1;
+    int rows = (n + columns - 1) / columns;
+    float step_x = columns > 1 ? w / (float)(columns - 1) : 0.0f;
+    float step_y = rows > 1 ? h / (float)(rows - 1) : 0.0f;
+
+    int first = particles->count;
+    int spawned = 0;
+    for (; spawned < n; ++spawned)
+    {
+        particle.position = vec2_new(x + step_x * (float)(spawned % columns), y + step_y * (float)(spawned / columns));
+        if (particle_world_add(particles, &particle) == PARTICLE_INVALID_HANDLE)
+        {
+            break;
+        }
+    }
+
+    pd->lua->pushInt(first);
+    pd->lua->pushInt(spawned);
+    return 2;
+}
+
+/*
+ * Radial push (or pull, for a negative strength) on a range of particles,
+ * falling linearly to nothing at radius, through every step of the next
+ * playsics.update. Each call arms one of the bridge's registry attractors.
+ */
+static int lua_bridge_force(lua_State* L)
+{
+    (void)L;
+    if (lua_bridge_force_count == LUA_FORCE_FIELDS)
+    {
+        LOG_WARNING("playsics.force: only %d forces per update", LUA_FORCE_FIELDS);
+        return 0;
+    }
+
+    ForceField* field = force_get_field(lua_bridge_engine->forces, lua_bridge_forces[lua_bridge_force_count++]);
+    field->vector = vec2_new(pd->lua->getArgFloat(1), pd->lua->getArgFloat(2));
+    field->radius = pd->lua->getArgFloat(3);
+    // Attractors pull for a positive strength, playsics.force pushes
+    field->strength = -pd->lua->getArgFloat(4);
+    lua_bridge_range(5, lua_bridge_engine->particles->count, &field->first, &field->count);
+    return 0;
+}
+
+/* x, y of each particle in the range */
+static int lua_bridge_positions(lua_State* L)
+{
+    (void)L;
+    const ParticleWorld* particles = lua_bridge_engine->particles;
+    int first;
+    int count;
+    lua_bridge_range(1, particles->count, &first, &count);
+
+    ArenaScope scratch = arena_scope_begin(lua_bridge_engine->frame_arena);
+    float* out = ARENA_ALLOC(lua_bridge_engine->frame_arena, float, count * 2);
+    if (out == NULL)
+    {
+        arena_scope_end(scratch);
+        pd->lua->pushNil();
+        return 1;
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+        out[2 * i] = particles->x[first + i];
+        out[2 * i + 1] = particles->y[first + i];
+    }
+    lua_bridge_push_floats(out, count * 2);
+    arena_scope_end(scratch);
+    return 1;
+}
+
+/* x, y, angle of each body in the range */
+static int lua_bridge_bodies(lua_State* L)
+{
+    (void)L;
+    const BodyWorld* bodies = lua_bridge_engine->bodies;
+    int first;
+    int count;
+    lua_bridge_range(1, bodies->count, &first, &count);
+
+    ArenaScope scratch = arena_scope_begin(lua_bridge_engine->frame_arena);
+    float* out = ARENA_ALLOC(lua_bridge_engine->frame_arena, float, count * 3);
+    if (out == NULL)
+    {
+        arena_scope_end(scratch);
+        pd->lua->pushNil();
+        return 1;
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+        const BodyPose* pose = &bodies->pose[first + i];
+        out[3 * i] = pose->x;
+        out[3 * i + 1] = pose->y;
+        out[3 * i + 2] = pose->angle;
+    }
+    lua_bridge_push_floats(out, count * 3);
+    arena_scope_end(scratch);
+    return 1;
+}
+
+/*
+ * Clears a bitmap and plots a range of particles into it as size x size
+ * squares, interpolated like the main renderer, so Lua can draw the whole
+ * set with one drawBitmap.
+ */
+static int lua_bridge_draw(lua_State* L)
+{
+    (void)L;
+    const ParticleWorld* particles = lua_bridge_engine->particles;
+    LCDBitmap* bitmap = pd->lua->getBitmap(1);
+    if (bitmap == NULL)
+    {
+        LOG_WARNING("playsics.draw needs a bitmap");
+        return 0;
+    }
+
+    int width;
+    int height;
+    int rowbytes;
+    uint8_t* mask;
+    uint8_t* data;
+    pd->graphics->getBitmapData(bitmap, &width, &height, &rowbytes, &mask, &data);
+    if (rowbytes % 4 != 0 || ((uintptr_t)data & 3u) != 0)
+    {
+        LOG_WARNING("playsics.draw needs a word-aligned bitmap");
+        return 0;
+    }
+
+    int size = lua_bridge_opt_int(2, (int)(2.0f * PARTICLE_RADIUS));
+    int first;
+    int count;
+    lua_bridge_range(3, particles->count, &first, &count);
+
+    RasterTarget target;
+    raster_target_init(&target, data, rowbytes, width, height);
+    raster_clear_rows(&target, 0, height - 1);
+    raster_fill_points(&target, particles->prev_x + first, particles->prev_y + first,
+                       particles->x + first, particles->y + first,
+                       lua_bridge_engine->timestep.alpha, count, size);
+    return 0;
+}
+
+/* ========================================================================== */
+/* REGISTRATION                                                               */
+/* ========================================================================== */
+
+/*
+ * Publishes the functions above to Lua. Call on kEventInitLua, after the
+ * engine is up; update is the callback that runs one frame, which main.lua
+ * then calls from playdate.update instead of the system calling it.
+ */
+bool lua_bridge_register(Engine* engine, PDCallbackFunction* update)
+{
+    if (engine == NULL || engine->particles == NULL || engine->bodies == NULL || engine->forces == NULL ||
+        engine->frame_arena == NULL)
+    {
+        LOG_ERROR("lua_bridge:register: Engine is not initialized");
+        return false;
+    }
+
+    lua_bridge_engine = engine;
+    lua_bridge_update_callback = update;
+
+    for (int i = 0; i < LUA_FORCE_FIELDS; ++i)
+    {
+        ForceField idle = force_attractor(VEC2_ZERO, 1.0f, 0.0f, FORCE_FALLOFF_LINEAR);
+        lua_bridge_forces[i] = force_add_field(engine->forces, &idle);
+        if (lua_bridge_forces[i] < 0)
+        {
+            LOG_ERROR("lua_bridge:register: No room for playsics.force attractors");
+            return false;
+        }
+    }
+    lua_bridge_force_count = 0;
+
+    static const struct
+    {
+        lua_CFunction function;
+        const char* name;
+    } functions[] = {
+        { lua_bridge_update, "playsics.update" },
+        { lua_bridge_count, "playsics.count" },
+        { lua_bridge_spawn, "playsics.spawn" },
+        { lua_bridge_force, "playsics.force" },
+        { lua_bridge_positions, "playsics.positions" },
+        { lua_bridge_bodies, "playsics.bodies" },
+        { lua_bridge_draw, "playsics.draw" },
+    };
+
+    for (size_t i = 0; i < sizeof(functions) / sizeof(functions[0]); ++i)
+    {
+        const char* err = NULL;
+        if (!pd->lua->addFunction(functions[i].function, functions[i].name, &err))
+        {
+            LOG_ERROR("lua_bridge:register: %s: %s", functions[i].name, err != NULL ? err : "unknown error");
+            return false;
+        }
+    }
+    return true;
+}
@@ -1,5 +1,11 @@
 #include "common.h"
 #include "engine.h"
+#include "timestep.h"
+#include "profiler.h"
+#include "memory.h"
+#ifdef PLAYSICS_LUA
+#include "lua_bridge.h"
+#endif
 
 /* Playdate API instance */
 PlaydateAPI* pd = NULL;
@@ -8,16 +14,40 @@ Engine engine;
 /* Function prototypes */
 static int update(void* userdata) 
 {
-    // Handle input
-    engine_input(&engine);
+    // Measure the real time since the previous callback
+    float elapsed = pd->system->getElapsedTime();
+    pd->system->resetElapsedTime();
 
-    // Update game logic
-    engine_update(&engine);
+    PROFILE_FRAME_BEGIN();
+    MEMORY_FRAME_BEGIN();
 
-    // Render the frame
-    engine_render(&engine);
+    // Release last frame's scratch memory
+    engine_begin_frame(&engine);
 
-    return 1; // Continue the update loop
+    // Handle input
+    PROFILE_BEGIN("input");
+    engine_input(&engine);
+    PROFILE_END();
+
+    // Update game logic in fixed steps
+    PROFILE_BEGIN("update");
+    int steps = timestep_advance(&engine.timestep, elapsed);
+    for (int i = 0; i < steps; ++i)
+    {
+        engine_update(&engine);
+    }
+    engine_end_frame(&engine);
+    PROFILE_END();
+
+    // Render the frame, interpolated between the last two steps; a frame
+    // where nothing changed skips the display update entirely
+    PROFILE_BEGIN("render");
+    bool changed = engine_render(&engine);
+    PROFILE_END();
+
+    MEMORY_FRAME_END();
+    PROFILE_FRAME_END();
+    return changed ? 1 : 0;
 }
 
 /* Main Playdate event handler */
@@ -34,11 +64,24 @@ int eventHandler(PlaydateAPI* playdate, PDSystemEvent event, uint32_t arg)
             // Store the API pointer globally
             pd = playdate;
 
-            // Set the update callback
+#ifndef PLAYSICS_LUA
+            // Set the update callback; with the Lua bridge, main.lua's
+            // playdate.update runs each frame through playsics.update instead
             pd->system->setUpdateCallback(update, NULL);
+#endif
 
             // Initialize the engine
             engine_init(&engine);
+
+            // Start timing the first frame from here
+            pd->system->resetElapsedTime();
+            break;
+
+        case kEventInitLua:
+#ifdef PLAYSICS_LUA
+            // Expose the engine to main.lua
+            lua_bridge_register(&engine, update);
+#endif
             break;
 
         case kEventTerminate:
@@ -2,6 +2,208 @@
 #include "memory.h"
 #include "logging.h"
 
+#ifdef PLAYSICS_MEMORY_TRACKING
+
+/* Precedes every tracked block; padded so the user pointer stays 16-byte aligned */
+typedef struct
+{
+    size_t size;
+    MemorySite* site;
+    uint32_t magic;
+} MemoryHeader;
+
+#define MEMORY_MAGIC       0x9D3A11C5u
+#define MEMORY_HEADER_SIZE ((sizeof(MemoryHeader) + 15) & ~(size_t)15)
+
+static MemoryStats memory;
+static MemorySite memory_sites[MEMORY_MAX_SITES];
+static int memory_site_count = 0;
+static bool memory_in_frame = false;
+
+/* Site records by tag; tags are literals, so equal tags are usually the same pointer */
+static MemorySite* memory_site(const char* tag)
+{
+    for (int i = 0; i < memory_site_count; ++i)
+    {
+        if (memory_sites[i].tag == tag || strcmp(memory_sites[i].tag, tag) == 0)
+        {
+            return &memory_sites[i];
+        }
+    }
+
+    // Overflowing sites share the last slot
+    if (memory_site_count == MEMORY_MAX_SITES)
+    {
+        MemorySite* shared = &memory_sites[MEMORY_MAX_SITES - 1];
+        shared->tag = "(other)";
+        return shared;
+    }
+
+    MemorySite* site = &memory_sites[memory_site_count++];
+    memset(site, 0, sizeof(MemorySite));
+    site->tag = tag;
+    return site;
+}
+
+static void memory_track_free(MemorySite* site, size_t size)
+{
+    site->live_allocs--;
+    site->live_bytes -= size;
+    memory.live_allocs--;
+    memory.live_bytes -= size;
+    memory.total_frees++;
+}
+
+static void memory_track_alloc(MemoryHeader* header, size_t size, const char* tag)
+{
+    MemorySite* site = memory_site(tag);
+    header->size = size;
+    header->site = site;
+    header->magic = MEMORY_MAGIC;
+
+    site->live_allocs++;
+    site->live_bytes += size;
+    site->total_allocs++;
+    memory.live_allocs++;
+    memory.live_bytes += size;
+    memory.total_allocs++;
+    memory.peak_bytes = MAX(memory.peak_bytes, memory.live_bytes);
+
+    if (memory_in_frame)
+    {
+        memory.frame_allocs++;
+        memory.frame_bytes += size;
+
+        // Report each offending site once rather than every frame
+        if (!site->flagged)
+        {
+            site->flagged = true;
+            LOG_WARNING("%zu byte allocation during a frame at %s", size, tag);
+        }
+    }
+}
+
+static MemoryHeader* memory_header(void* ptr)
+{
+    MemoryHeader* header = (MemoryHeader*)((uint8_t*)ptr - MEMORY_HEADER_SIZE);
+    if (header->magic != MEMORY_MAGIC)
+    {
+        LOG_ERROR("memory: %p was not allocated by the tracked allocator", ptr);
+        return NULL;
+    }
+    return header;
+}
+
+void* pd_realloc_tagged(void* ptr, size_t size, const char* tag)
+{
+    MemoryHeader* header = NULL;
+    if (ptr != NULL)
+    {
+        header = memory_header(ptr);
+        if (header == NULL)
+        {
+            return NULL;
+        }
+    }
+
+    if (size == 0)
+    {
+        if (header != NULL)
+        {
+            memory_track_free(header->site, header->size);
+            header->magic = 0;
+            pd->system->realloc(header, 0);
+        }
+        return NULL;
+    }
+
+    // Read before the block can move; on failure the old block stays live and tracked
+    MemorySite* old_site = header != NULL ? header->site : NULL;
+    size_t old_size = header != NULL ? header->size : 0;
+
+    MemoryHeader* block = (MemoryHeader*)pd->system->realloc(header, MEMORY_HEADER_SIZE + size);
+    if (block == NULL)
+    {
+        LOG_ERROR("pd_realloc: Failed to reallocate memory (size: %zu, at %s)", size, tag);
+        return NULL;
+    }
+
+    if (old_site != NULL)
+    {
+        memory_track_free(old_site, old_size);
+    }
+    memory_track_alloc(block, size, tag);
+    return (uint8_t*)block + MEMORY_HEADER_SIZE;
+}
+
+void* pd_malloc_tagged(size_t size, const char* tag)
+{
+    return pd_realloc_tagged(NULL, size, tag);
+}
+
+void* pd_calloc_tagged(size_t count, size_t size, const char* tag)
+{
+    void* ptr = pd_realloc_tagged(NULL, count * size, tag);
+    if (ptr != NULL)
+    {
+        memset(ptr, 0, count * size);
+    }
+    return ptr;
+}
+
+void pd_free(void* ptr)
+{
+    if (ptr != NULL)
+    {
+        pd_realloc_tagged(ptr, 0, NULL);
+    }
+}
+
+/* Opens the span in which allocations are reported; update() wraps its whole body */
+void memory_frame_begin(void)
+{
+    memory_in_frame = true;
+    memory.frame_allocs = 0;
+    memory.frame_bytes = 0;
+}
+
+void memory_frame_end(void)
+{
+    memory_in_frame = false;
+    if (memory.frame_allocs > 0)
+    {
+        memory.frames_with_allocs++;
+    }
+}
+
+const MemoryStats* memory_stats(void)
+{
+    return &memory;
+}
+
+/* Logs the totals and every call site that still holds memory or allocated during a frame */
+void memory_report(void)
+{
+    pd->system->logToConsole("heap: %zu bytes live in %d blocks, %zu peak (%u allocs, %u frees, %u frames allocated)",
+                             memory.live_bytes, memory.live_allocs, memory.peak_bytes,
+                             (unsigned)memory.total_allocs, (unsigned)memory.total_frees,
+                             (unsigned)memory.frames_with_allocs);
+
+    for (int i = 0; i < memory_site_count; ++i)
+    {
+        const MemorySite* site = &memory_sites[i];
+        if (site->live_allocs > 0 || site->flagged)
+        {
+            const char* file = strrchr(site->tag, '/');
+            pd->system->logToConsole("  %-32s %8zu bytes in %3d blocks (%u allocs)%s",
+                                     file != NULL ? file + 1 : site->tag, site->live_bytes, site->live_allocs,
+                                     (unsigned)site->total_allocs, site->flagged ? "  [in frame]" : "");
+        }
+    }
+}
+
+#else
+
 void* pd_realloc(void* ptr, size_t size)
 {
     void* new_ptr = pd->system->realloc(ptr, size);
@@ -30,4 +232,318 @@ void* pd_calloc(size_t count, size_t size)
 void pd_free(void* ptr)
 {
     pd->system->realloc(ptr, 0);
-}
\ No newline at end of file
+}
+
+#endif // PLAYSICS_MEMORY_TRACKING
+
+/* ========================================================================== */
+/* FRAME ARENA                                                                */
+/* ========================================================================== */
+
+Arena* arena_create(size_t size)
+{
+    Arena* arena = (Arena*)pd_malloc(sizeof(Arena));
+    if (arena == NULL)
+    {
+        LOG_ERROR("arena:create: Memory allocation failed");
+        return NULL;
+    }
+
+    arena->base = (uint8_t*)pd_malloc(size);
+    if (arena->base == NULL)
+    {
+        LOG_ERROR("arena:create: Failed to allocate %zu bytes", size);
+        pd_free(arena);
+        return NULL;
+    }
+
+    arena->size = size;
+    arena->offset = 0;
+    arena->high_water = 0;
+    arena->scope_depth = 0;
+
+    return arena;
+}
+
+void arena_destroy(Arena* arena)
+{
+    if (arena != NULL)
+    {
+        pd_free(arena->base);
+        pd_free(arena);
+    }
+}
+
+/* Returns uninitialized memory; alignment must be a power of two */
+void* arena_alloc(Arena* arena, size_t size, size_t alignment)
+{
+    uintptr_t address = (uintptr_t)(arena->base + arena->offset);
+    uintptr_t aligned = (address + (alignment - 1)) & ~(uintptr_t)(alignment - 1);
+    size_t offset = (size_t)(aligned - (uintptr_t)arena->base);
+
+    if (offset + size > arena->size)
+    {
+        LOG_ERROR("arena:alloc: Out of memory (requested: %zu, used: %zu of %zu)",
+                  size, arena->offset, arena->size);
+        return NULL;
+    }
+
+    arena->offset = offset + size;
+    if (arena->offset > arena->high_water)
+    {
+        arena->high_water = arena->offset;
+    }
+
+    return arena->base + offset;
+}
+
+void arena_reset(Arena* arena)
+{
+    if (arena->scope_depth != 0)
+    {
+        LOG_WARNING("arena reset with %d scopes still open", arena->scope_depth);
+        arena->scope_depth = 0;
+    }
+    arena->offset = 0;
+}
+
+/* Scopes nest: closing one releases everything allocated since it was opened */
+ArenaScope arena_scope_begin(Arena* arena)
+{
+    arena->scope_depth++;
+    return (ArenaScope){ arena, arena->offset };
+}
+
+void arena_scope_end(ArenaScope scope)
+{
+    scope.arena->scope_depth--;
+    scope.arena->offset = scope.offset;
+}
+
+void arena_report(const Arena* arena, const char* name)
+{
+    pd->system->logToConsole("%s: high water %zu of %zu bytes (%.1f%%)", name,
+                             arena->high_water, arena->size,
+                             100.0 * (double)arena->high_water / (double)arena->size);
+}
+
+/* ========================================================================== */
+/* OBJECT POOL                                                                */
+/* ========================================================================== */
+
+/* Chunks are linked through a header that keeps the items 8-byte aligned */
+typedef struct PoolChunk
+{
+    struct PoolChunk* next;
+    int count;
+} PoolChunk;
+
+#define POOL_ITEM_ALIGN    8
+#define POOL_CHUNK_HEADER  ((sizeof(PoolChunk) + POOL_ITEM_ALIGN - 1) & ~(size_t)(POOL_ITEM_ALIGN - 1))
+
+/*
+ * With PLAYSICS_MEMORY_TRACKING each chunk also ends in one live bit per
+ * item, so pool_free can catch pointers it never handed out and items freed
+ * twice, either of which would corrupt the free list.
+ */
+#ifdef PLAYSICS_MEMORY_TRACKING
+#define POOL_LIVE_BYTES(count) (((size_t)(count) + 7) / 8)
+#else
+#define POOL_LIVE_BYTES(count) 0
+#endif
+
+/* max_items of 0 lets the pool grow without limit */
+Pool* pool_create(size_t item_size, int items_per_chunk, int max_items)
+{
+    if (item_size == 0 || items_per_chunk <= 0 || max_items < 0)
+    {
+        LOG_ERROR("pool:create: Invalid parameters");
+        return NULL;
+    }
+
+    Pool* pool = (Pool*)pd_malloc(sizeof(Pool));
+    if (pool == NULL)
+    {
+        LOG_ERROR("pool:create: Memory allocation failed");
+        return NULL;
+    }
+
+    // Every item must be able to hold the free list link
+    size_t size = MAX(item_size, sizeof(void*));
+    pool->item_size = (size + POOL_ITEM_ALIGN - 1) & ~(size_t)(POOL_ITEM_ALIGN - 1);
+    pool->items_per_chunk = items_per_chunk;
+    pool->max_items = max_items;
+    pool->free_list = NULL;
+    pool->chunks = NULL;
+    pool->chunk_count = 0;
+    pool->capacity = 0;
+    pool->used = 0;
+    pool->peak = 0;
+    pool->total_allocs = 0;
+    pool->total_frees = 0;
+
+    return pool;
+}
+
+void pool_destroy(Pool* pool)
+{
+    if (pool == NULL)
+    {
+        return;
+    }
+
+    PoolChunk* chunk = (PoolChunk*)pool->chunks;
+    while (chunk != NULL)
+    {
+        PoolChunk* next = chunk->next;
+        pd_free(chunk);
+        chunk = next;
+    }
+    pd_free(pool);
+}
+
+/* Adds one chunk and threads its items onto the free list */
+static bool pool_grow(Pool* pool)
+{
+    int count = pool->items_per_chunk;
+    if (pool->max_items > 0)
+    {
+        count = MIN(count, pool->max_items - pool->capacity);
+        if (count <= 0)
+        {
+            return false;
+        }
+    }
+
+    size_t span = pool->item_size * (size_t)count;
+    PoolChunk* chunk = (PoolChunk*)pd_malloc(POOL_CHUNK_HEADER + span + POOL_LIVE_BYTES(count));
+    if (chunk == NULL)
+    {
+        return false;
+    }
+
+    chunk->next = (PoolChunk*)pool->chunks;
+    chunk->count = count;
+    pool->chunks = chunk;
+    pool->chunk_count++;
+    pool->capacity += count;
+
+    // Link back to front so items are handed out in address order
+    uint8_t* items = (uint8_t*)chunk + POOL_CHUNK_HEADER;
+    memset(items + span, 0, POOL_LIVE_BYTES(count));
+    for (int i = count - 1; i >= 0; --i)
+    {
+        void* item = items + pool->item_size * (size_t)i;
+        *(void**)item = pool->free_list;
+        pool->free_list = item;
+    }
+
+    return true;
+}
+
+#ifdef PLAYSICS_MEMORY_TRACKING
+/*
+ * The byte holding item's live bit, with the bit in *mask, or NULL if item
+ * is not the start of an item slot in one of the pool's chunks.
+ */
+static uint8_t* pool_live_byte(const Pool* pool, const void* item, uint8_t* mask)
+{
+    uintptr_t address = (uintptr_t)item;
+    for (PoolChunk* chunk = (PoolChunk*)pool->chunks; chunk != NULL; chunk = chunk->next)
+    {
+        uint8_t* items = (uint8_t*)chunk + POOL_CHUNK_HEADER;
+        size_t span = pool->item_size * (size_t)chunk->count;
+        if (address < (uintptr_t)items || address >= (uintptr_t)items + span)
+        {
+            continue;
+        }
+
+        size_t offset = (size_t)(address - (uintptr_t)items);
+        if (offset % pool->item_size != 0)
+        {
+            return NULL;
+        }
+        size_t index = offset / pool->item_size;
+        *mask = (uint8_t)(1u << (index & 7));
+        return items + span + index / 8;
+    }
+    return NULL;
+}
+#endif // PLAYSICS_MEMORY_TRACKING
+
+/* Pre-grows the pool so a later burst of allocations never hits the system */
+bool pool_reserve(Pool* pool, int count)
+{
+    while (pool->capacity - pool->used < count)
+    {
+        if (!pool_grow(pool))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void* pool_alloc(Pool* pool)
+{
+    if (pool->free_list == NULL && !pool_grow(pool))
+    {
+        LOG_WARNING("pool exhausted (capacity: %d, cap: %d)", pool->capacity, pool->max_items);
+        return NULL;
+    }
+
+    void* item = pool->free_list;
+    pool->free_list = *(void**)item;
+
+#ifdef PLAYSICS_MEMORY_TRACKING
+    uint8_t mask;
+    uint8_t* live = pool_live_byte(pool, item, &mask);
+    *live |= mask;
+#endif
+
+    pool->used++;
+    pool->total_allocs++;
+    if (pool->used > pool->peak)
+    {
+        pool->peak = pool->used;
+    }
+
+    return item;
+}
+
+void pool_free(Pool* pool, void* item)
+{
+    if (item == NULL)
+    {
+        return;
+    }
+
+#ifdef PLAYSICS_MEMORY_TRACKING
+    uint8_t mask;
+    uint8_t* live = pool_live_byte(pool, item, &mask);
+    if (live == NULL)
+    {
+        LOG_ERROR("pool:free: %p was not allocated from this pool", item);
+        return;
+    }
+    if ((*live & mask) == 0)
+    {
+        LOG_ERROR("pool:free: %p freed twice", item);
+        return;
+    }
+    *live &= (uint8_t)~mask;
+#endif
+
+    *(void**)item = pool->free_list;
+    pool->free_list = item;
+
+    pool->used--;
+    pool->total_frees++;
+}
+
+void pool_report(const Pool* pool, const char* name)
+{
+    pd->system->logToConsole("%s: %d used, %d peak, %d capacity in %d chunks (%u allocs, %u frees)",
+                             name, pool->used, pool->peak, pool->capacity, pool->chunk_count,
+                             (unsigned)pool->total_allocs, (unsigned)pool->total_frees);
+}
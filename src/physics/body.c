@@ -0,0 +1,1113 @@
+#include <float.h>
+
+#include "common.h"
+#include "physics/body.h"
+#include "physics/collide.h"
+#include "physics/contact.h"
+#include "physics/contact_cache.h"
+#include "logging.h"
+#include "memory.h"
+#include "debug_draw.h"
+
+/* Contact keys pack two handles into 16 bits each */
+#define BODY_MAX_CAPACITY 65536
+
+/* ========================================================================== */
+/* SHAPES                                                                     */
+/* ========================================================================== */
+
+/* Outward normals for vertices wound with a positive signed area */
+static void body_shape_update_normals(BodyShape* shape)
+{
+    for (int i = 0; i < shape->count; ++i)
+    {
+        Vector2 edge = vec2_sub(shape->vertices[(i + 1) % shape->count], shape->vertices[i]);
+        shape->normals[i] = vec2_normalize(vec2_new(edge.y, -edge.x));
+    }
+}
+
+BodyShape body_shape_circle(float radius)
+{
+    BodyShape shape;
+    memset(&shape, 0, sizeof(shape));
+    shape.type = BODY_SHAPE_CIRCLE;
+    shape.radius = radius;
+    shape.extent = vec2_new(radius, radius);
+    return shape;
+}
+
+/* A box that rotates freely */
+BodyShape body_shape_box(float width, float height)
+{
+    float hw = 0.5f * width;
+    float hh = 0.5f * height;
+
+    BodyShape shape;
+    memset(&shape, 0, sizeof(shape));
+    shape.type = BODY_SHAPE_BOX;
+    shape.extent = vec2_new(hw, hh);
+    shape.count = 4;
+    shape.vertices[0] = vec2_new(-hw, -hh);
+    shape.vertices[1] = vec2_new(hw, -hh);
+    shape.vertices[2] = vec2_new(hw, hh);
+    shape.vertices[3] = vec2_new(-hw, hh);
+    body_shape_update_normals(&shape);
+    return shape;
+}
+
+/* A box whose body is kept axis-aligned: it gets no inertia and never turns */
+BodyShape body_shape_aabb(float width, float height)
+{
+    BodyShape shape = body_shape_box(width, height);
+    shape.type = BODY_SHAPE_AABB;
+    return shape;
+}
+
+/*
+ * A convex polygon of 3 to BODY_MAX_VERTICES vertices in either winding.
+ * The vertices are shifted so the centroid is the body's origin.
+ */
+BodyShape body_shape_polygon(const Vector2* vertices, int count)
+{
+    if (count < 3 || count > BODY_MAX_VERTICES)
+    {
+        LOG_WARNING("polygon needs 3 to %d vertices, got %d", BODY_MAX_VERTICES, count);
+        return body_shape_circle(1.0f);
+    }
+
+    BodyShape shape;
+    memset(&shape, 0, sizeof(shape));
+    shape.type = BODY_SHAPE_POLYGON;
+    shape.count = count;
+
+    float area = 0.0f;
+    Vector2 centroid = VEC2_ZERO;
+    for (int i = 0; i < count; ++i)
+    {
+        Vector2 e1 = vec2_sub(vertices[i], vertices[0]);
+        Vector2 e2 = vec2_sub(vertices[(i + 1) % count], vertices[0]);
+        float triangle = 0.5f * vec2_cross(e1, e2);
+        area += triangle;
+        centroid = vec2_add(centroid, vec2_scale(vec2_add(e1, e2), triangle / 3.0f));
+    }
+    if (fabsf(area) < VECTOR_EPSILON)
+    {
+        LOG_WARNING("degenerate polygon");
+        return body_shape_circle(1.0f);
+    }
+    centroid = vec2_add(vertices[0], vec2_scale(centroid, 1.0f / area));
+
+    for (int i = 0; i < count; ++i)
+    {
+        // Reverse a negative winding so the normals come out pointing outwards
+        Vector2 v = vertices[area > 0.0f ? i : count - 1 - i];
+        shape.vertices[i] = vec2_sub(v, centroid);
+        shape.extent.x = MAX(shape.extent.x, fabsf(shape.vertices[i].x));
+        shape.extent.y = MAX(shape.extent.y, fabsf(shape.vertices[i].y));
+    }
+    body_shape_update_normals(&shape);
+    return shape;
+}
+
+/*
+ * Whether a shape from outside the engine (a snapshot file) is one the
+ * constructors above could have made: a known type, a vertex count the
+ * arrays hold, and finite numbers throughout.
+ */
+bool body_shape_valid(const BodyShape* shape)
+{
+    if (!isfinite(shape->radius) || !isfinite(shape->extent.x) || !isfinite(shape->extent.y))
+    {
+        return false;
+    }
+
+    switch (shape->type)
+    {
+        case BODY_SHAPE_CIRCLE:
+            return shape->radius > 0.0f && shape->count == 0;
+        case BODY_SHAPE_AABB:
+        case BODY_SHAPE_BOX:
+            if (shape->count != 4)
+            {
+                return false;
+            }
+            break;
+        case BODY_SHAPE_POLYGON:
+            if (shape->count < 3 || shape->count > BODY_MAX_VERTICES)
+            {
+                return false;
+            }
+            break;
+        default:
+            return false;
+    }
+
+    for (int i = 0; i < shape->count; ++i)
+    {
+        if (!isfinite(shape->vertices[i].x) || !isfinite(shape->vertices[i].y) ||
+            !isfinite(shape->normals[i].x) || !isfinite(shape->normals[i].y))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Mass and moment of inertia about the origin, which is the centroid */
+static void body_shape_mass(const BodyShape* shape, float density, float* mass, float* inertia)
+{
+    if (shape->type == BODY_SHAPE_CIRCLE)
+    {
+        float r_sq = shape->radius * shape->radius;
+        *mass = density * FAST_PI * r_sq;
+        *inertia = 0.5f * *mass * r_sq;
+        return;
+    }
+
+    // Sum over the triangles fanned from the origin
+    float area = 0.0f;
+    float second_moment = 0.0f;
+    for (int i = 0; i < shape->count; ++i)
+    {
+        Vector2 e1 = shape->vertices[i];
+        Vector2 e2 = shape->vertices[(i + 1) % shape->count];
+        float cross = vec2_cross(e1, e2);
+        area += 0.5f * cross;
+        second_moment += cross * (vec2_dot(e1, e1) + vec2_dot(e1, e2) + vec2_dot(e2, e2)) / 12.0f;
+    }
+    *mass = density * area;
+    *inertia = density * second_moment;
+}
+
+/* ========================================================================== */
+/* WORLD                                                                      */
+/* ========================================================================== */
+
+BodyWorld* body_world_create(int capacity, int max_contacts)
+{
+    if (capacity <= 0 || capacity > BODY_MAX_CAPACITY || max_contacts <= 0)
+    {
+        LOG_ERROR("body:create: Invalid parameters");
+        return NULL;
+    }
+
+    BodyWorld* world = (BodyWorld*)pd_calloc(1, sizeof(BodyWorld));
+    if (world == NULL)
+    {
+        LOG_ERROR("body:create: Memory allocation failed");
+        return NULL;
+    }
+
+    size_t n = (size_t)capacity;
+    world->velocity = (BodyVelocity*)pd_malloc(sizeof(BodyVelocity) * n);
+    world->pose = (BodyPose*)pd_malloc(sizeof(BodyPose) * n);
+    world->bounds = (BodyBounds*)pd_malloc(sizeof(BodyBounds) * n);
+    world->prev_pose = (BodyPose*)pd_malloc(sizeof(BodyPose) * n);
+    world->fx = (float*)pd_malloc(sizeof(float) * n);
+    world->fy = (float*)pd_malloc(sizeof(float) * n);
+    world->torque = (float*)pd_malloc(sizeof(float) * n);
+    world->density = (float*)pd_malloc(sizeof(float) * n);
+    world->friction = (float*)pd_malloc(sizeof(float) * n);
+    world->restitution = (float*)pd_malloc(sizeof(float) * n);
+    world->shapes = (BodyShape*)pd_malloc(sizeof(BodyShape) * n);
+    world->awake = (bool*)pd_malloc(sizeof(bool) * n);
+    world->sleep_time = (float*)pd_malloc(sizeof(float) * n);
+    world->island_next = (uint32_t*)pd_malloc(sizeof(uint32_t) * n);
+    world->active = (uint32_t*)pd_malloc(sizeof(uint32_t) * n);
+    world->active_slot = (uint32_t*)pd_malloc(sizeof(uint32_t) * n);
+    world->island_parent = (uint32_t*)pd_malloc(sizeof(uint32_t) * n);
+    world->island_sleep = (float*)pd_malloc(sizeof(float) * n);
+    world->handle_to_index = (uint32_t*)pd_malloc(sizeof(uint32_t) * n);
+    world->index_to_handle = (BodyHandle*)pd_malloc(sizeof(BodyHandle) * n);
+    world->free_handles = (BodyHandle*)pd_malloc(sizeof(BodyHandle) * n);
+    world->sweep = (uint32_t*)pd_malloc(sizeof(uint32_t) * n);
+    world->rest = (uint32_t*)pd_malloc(sizeof(uint32_t) * n);
+    world->wide = (uint32_t*)pd_malloc(sizeof(uint32_t) * n);
+    world->manifolds = (ContactManifold*)pd_malloc(sizeof(ContactManifold) * (size_t)max_contacts);
+    world->manifold_entries = (ContactCacheEntry**)pd_malloc(sizeof(ContactCacheEntry*) * (size_t)max_contacts);
+    world->cache = contact_cache_create(max_contacts, capacity);
+
+    if (world->velocity == NULL || world->pose == NULL || world->bounds == NULL || world->prev_pose == NULL ||
+        world->fx == NULL || world->fy == NULL || world->torque == NULL || world->density == NULL ||
+        world->friction == NULL || world->restitution == NULL || world->shapes == NULL ||
+        world->awake == NULL || world->sleep_time == NULL || world->island_next == NULL ||
+        world->active == NULL || world->active_slot == NULL || world->island_parent == NULL ||
+        world->island_sleep == NULL ||
+        world->handle_to_index == NULL || world->index_to_handle == NULL || world->free_handles == NULL ||
+        world->sweep == NULL || world->rest == NULL || world->wide == NULL || world->manifolds == NULL || world->manifold_entries == NULL || world->cache == NULL)
+    {
+        LOG_ERROR("body:create: Failed to allocate storage for %d bodies", capacity);
+        body_world_destroy(world);
+        return NULL;
+    }
+
+    world->capacity = capacity;
+    world->max_manifolds = max_contacts;
+    world->gravity = vec2_new(0.0f, GRAVITY);
+    world->iterations = BODY_ITERATIONS;
+    body_world_clear(world);
+
+    return world;
+}
+
+void body_world_destroy(BodyWorld* world)
+{
+    if (world != NULL)
+    {
+        pd_free(world->velocity);
+        pd_free(world->pose);
+        pd_free(world->bounds);
+        pd_free(world->prev_pose);
+        pd_free(world->fx);
+        pd_free(world->fy);
+        pd_free(world->torque);
+        pd_free(world->density);
+        pd_free(world->friction);
+        pd_free(world->restitution);
+        pd_free(world->shapes);
+        pd_free(world->awake);
+        pd_free(world->sleep_time);
+        pd_free(world->island_next);
+        pd_free(world->active);
+        pd_free(world->active_slot);
+        pd_free(world->island_parent);
+        pd_free(world->island_sleep);
+        pd_free(world->handle_to_index);
+        pd_free(world->index_to_handle);
+        pd_free(world->free_handles);
+        pd_free(world->sweep);
+        pd_free(world->rest);
+        pd_free(world->wide);
+        pd_free(world->manifolds);
+        pd_free(world->manifold_entries);
+        contact_cache_destroy(world->cache);
+        pd_free(world);
+    }
+}
+
+void body_world_clear(BodyWorld* world)
+{
+    world->count = 0;
+    world->active_count = 0;
+    world->revision++;
+    world->awake_revision++;
+    world->manifold_count = 0;
+    contact_cache_clear(world->cache);
+
+    // Hand out low handles first so a fresh world fills its tables in order
+    world->free_count = world->capacity;
+    for (int i = 0; i < world->capacity; ++i)
+    {
+        world->free_handles[i] = (BodyHandle)(world->capacity - 1 - i);
+        world->handle_to_index[i] = BODY_INVALID_HANDLE;
+    }
+}
+
+/* More iterations make stacks stiffer and cost one more pass over every contact each */
+void body_world_set_iterations(BodyWorld* world, int iterations)
+{
+    world->iterations = MAX(iterations, 1);
+}
+
+static void body_pose_set(BodyPose* pose, float x, float y, float angle)
+{
+    pose->x = x;
+    pose->y = y;
+    pose->angle = angle;
+    VECTOR_SINCOSF(angle, &pose->s, &pose->c);
+}
+
+/* World-space box of body i, grown by half the contact margin so pairs within it overlap */
+static void body_compute_bounds(BodyWorld* world, int i)
+{
+    const float grow = 0.5f * BODY_CONTACT_MARGIN;
+    const BodyShape* shape = &world->shapes[i];
+    const BodyPose* pose = &world->pose[i];
+    BodyBounds* bounds = &world->bounds[i];
+
+    float ex = shape->radius;
+    float ey = shape->radius;
+    for (int v = 0; v < shape->count; ++v)
+    {
+        Vector2 p = shape->vertices[v];
+        ex = MAX(ex, fabsf(pose->c * p.x - pose->s * p.y));
+        ey = MAX(ey, fabsf(pose->s * p.x + pose->c * p.y));
+    }
+
+    bounds->min_x = pose->x - ex - grow;
+    bounds->min_y = pose->y - ey - grow;
+    bounds->max_x = pose->x + ex + grow;
+    bounds->max_y = pose->y + ey + grow;
+}
+
+static void body_activate(BodyWorld* world, int i)
+{
+    world->awake_revision++;
+    world->awake[i] = true;
+    world->sleep_time[i] = 0.0f;
+    world->active_slot[i] = (uint32_t)world->active_count;
+    world->active[world->active_count++] = (uint32_t)i;
+}
+
+/* Wakes the whole island body i sleeps in. Returns false if it was not asleep */
+static bool body_wake_island(BodyWorld* world, int i)
+{
+    if (world->awake[i] || world->velocity[i].inv_mass == 0.0f)
+    {
+        return false;
+    }
+
+    uint32_t member = (uint32_t)i;
+    do
+    {
+        uint32_t next = world->island_next[member];
+        world->island_next[member] = member;
+        body_activate(world, (int)member);
+        member = next;
+    } while (member != (uint32_t)i);
+    return true;
+}
+
+BodyHandle body_world_add(BodyWorld* world, const Body* body)
+{
+    if (world->free_count == 0)
+    {
+        LOG_WARNING("body world is full (capacity: %d)", world->capacity);
+        return BODY_INVALID_HANDLE;
+    }
+
+    BodyHandle handle = world->free_handles[--world->free_count];
+    int index = world->count++;
+    world->revision++;
+    world->awake_revision++;
+
+    world->handle_to_index[handle] = (uint32_t)index;
+    world->index_to_handle[index] = handle;
+
+    // A zero density marks a static body; AABBs never rotate
+    float mass = 0.0f;
+    float inertia = 0.0f;
+    if (body->density > 0.0f)
+    {
+        body_shape_mass(&body->shape, body->density, &mass, &inertia);
+    }
+    bool fixed_rotation = body->shape.type == BODY_SHAPE_AABB;
+
+    BodyVelocity* velocity = &world->velocity[index];
+    velocity->vx = body->velocity.x;
+    velocity->vy = body->velocity.y;
+    velocity->w = fixed_rotation ? 0.0f : body->angular_velocity;
+    velocity->inv_mass = mass > VECTOR_EPSILON ? 1.0f / mass : 0.0f;
+    velocity->inv_inertia = inertia > VECTOR_EPSILON && !fixed_rotation ? 1.0f / inertia : 0.0f;
+
+    body_pose_set(&world->pose[index], body->position.x, body->position.y, fixed_rotation ? 0.0f : body->angle);
+    world->prev_pose[index] = world->pose[index];
+    world->fx[index] = 0.0f;
+    world->fy[index] = 0.0f;
+    world->torque[index] = 0.0f;
+    world->density[index] = body->density;
+    world->friction[index] = body->friction;
+    world->restitution[index] = body->restitution;
+    world->shapes[index] = body->shape;
+    body_compute_bounds(world, index);
+
+    // Static bodies never move, so they are never awake
+    world->awake[index] = false;
+    world->island_next[index] = (uint32_t)index;
+    if (velocity->inv_mass > 0.0f)
+    {
+        body_activate(world, index);
+    }
+
+    return handle;
+}
+
+void body_world_remove(BodyWorld* world, BodyHandle handle)
+{
+    int index = body_world_index(world, handle);
+    if (index < 0)
+    {
+        LOG_WARNING("stale body handle %u", (unsigned)handle);
+        return;
+    }
+
+    // Islands are linked by dense index, so wake both bodies whose index is about to change
+    int last = world->count - 1;
+    body_wake_island(world, index);
+    body_wake_island(world, last);
+
+    // Swap the last live body into the hole to keep storage dense
+    world->count--;
+    world->revision++;
+    world->awake_revision++;
+    if (index != last)
+    {
+        world->velocity[index] = world->velocity[last];
+        world->pose[index] = world->pose[last];
+        world->bounds[index] = world->bounds[last];
+        world->prev_pose[index] = world->prev_pose[last];
+        world->fx[index] = world->fx[last];
+        world->fy[index] = world->fy[last];
+        world->torque[index] = world->torque[last];
+        world->density[index] = world->density[last];
+        world->friction[index] = world->friction[last];
+        world->restitution[index] = world->restitution[last];
+        world->shapes[index] = world->shapes[last];
+        world->awake[index] = world->awake[last];
+        world->sleep_time[index] = world->sleep_time[last];
+        world->island_next[index] = (uint32_t)index;
+
+        BodyHandle moved = world->index_to_handle[last];
+        world->index_to_handle[index] = moved;
+        world->handle_to_index[moved] = (uint32_t)index;
+    }
+
+    world->handle_to_index[handle] = BODY_INVALID_HANDLE;
+    world->free_handles[world->free_count++] = handle;
+
+    // Rebuild the active list over the new indices
+    world->active_count = 0;
+    for (int i = 0; i < world->count; ++i)
+    {
+        if (world->awake[i])
+        {
+            world->active_slot[i] = (uint32_t)world->active_count;
+            world->active[world->active_count++] = (uint32_t)i;
+        }
+    }
+
+    // The handle may be reused before the next step, so nothing cached for it may survive
+    contact_cache_forget(world->cache, handle);
+}
+
+bool body_world_get(const BodyWorld* world, BodyHandle handle, Body* out)
+{
+    int index = body_world_index(world, handle);
+    if (index < 0)
+    {
+        return false;
+    }
+
+    const BodyVelocity* velocity = &world->velocity[index];
+    const BodyPose* pose = &world->pose[index];
+    out->position = vec2_new(pose->x, pose->y);
+    out->angle = pose->angle;
+    out->velocity = vec2_new(velocity->vx, velocity->vy);
+    out->angular_velocity = velocity->w;
+    out->density = world->density[index];
+    out->friction = world->friction[index];
+    out->restitution = world->restitution[index];
+    out->shape = world->shapes[index];
+    return true;
+}
+
+/* Accumulates a force applied at a world-space point until the next step */
+void body_world_apply_force(BodyWorld* world, BodyHandle handle, Vector2 force, Vector2 point)
+{
+    int index = body_world_index(world, handle);
+    if (index >= 0 && world->velocity[index].inv_mass > 0.0f)
+    {
+        const BodyPose* pose = &world->pose[index];
+        world->fx[index] += force.x;
+        world->fy[index] += force.y;
+        world->torque[index] += vec2_cross(vec2_new(point.x - pose->x, point.y - pose->y), force);
+        body_wake_island(world, index);
+    }
+}
+
+/* Wakes a sleeping body along with everything resting on or under it */
+void body_world_wake(BodyWorld* world, BodyHandle handle)
+{
+    int index = body_world_index(world, handle);
+    if (index >= 0)
+    {
+        body_wake_island(world, index);
+    }
+}
+
+/* False for sleeping and static bodies */
+bool body_world_is_awake(const BodyWorld* world, BodyHandle handle)
+{
+    int index = body_world_index(world, handle);
+    return index >= 0 && world->awake[index];
+}
+
+/*
+ * Moves a body and sets its velocity outright, as a rewind does. The body
+ * is not interpolated from where it was, and its island wakes up.
+ */
+void body_world_set_state(BodyWorld* world, BodyHandle handle, Vector2 position, float angle,
+                          Vector2 velocity, float angular_velocity)
+{
+    int index = body_world_index(world, handle);
+    if (index < 0 || world->velocity[index].inv_mass == 0.0f)
+    {
+        return;
+    }
+
+    // Bodies without inertia never turn
+    bool fixed_rotation = world->velocity[index].inv_inertia == 0.0f;
+    body_pose_set(&world->pose[index], position.x, position.y, fixed_rotation ? 0.0f : angle);
+    world->prev_pose[index] = world->pose[index];
+    world->velocity[index].vx = velocity.x;
+    world->velocity[index].vy = velocity.y;
+    world->velocity[index].w = fixed_rotation ? 0.0f : angular_velocity;
+    body_compute_bounds(world, index);
+    body_wake_island(world, index);
+}
+
+/*
+ * Rebuilds everything derived from the dense arrays after count bodies were
+ * written in directly, as a snapshot load does: the handle table and free
+ * list, each body's trig and bounds, and the active list. Cached contacts
+ * refer to the old bodies and are dropped. Returns false, leaving the world
+ * empty, if the handles are out of range or repeated.
+ */
+bool body_world_reindex(BodyWorld* world, int count)
+{
+    for (int i = 0; i < world->capacity; ++i)
+    {
+        world->handle_to_index[i] = BODY_INVALID_HANDLE;
+    }
+
+    if (count < 0 || count > world->capacity)
+    {
+        LOG_WARNING("invalid body count %d", count);
+        body_world_clear(world);
+        return false;
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+        BodyHandle handle = world->index_to_handle[i];
+        if (handle >= (BodyHandle)world->capacity || world->handle_to_index[handle] != BODY_INVALID_HANDLE)
+        {
+            LOG_WARNING("invalid body handle table");
+            body_world_clear(world);
+            return false;
+        }
+        world->handle_to_index[handle] = (uint32_t)i;
+    }
+    world->count = count;
+    world->revision++;
+    world->awake_revision++;
+    world->manifold_count = 0;
+    contact_cache_clear(world->cache);
+
+    world->free_count = 0;
+    for (int handle = world->capacity - 1; handle >= 0; --handle)
+    {
+        if (world->handle_to_index[handle] == BODY_INVALID_HANDLE)
+        {
+            world->free_handles[world->free_count++] = (BodyHandle)handle;
+        }
+    }
+
+    // Islands are rebuilt from scratch, so everything that can move starts awake
+    world->active_count = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        BodyPose* pose = &world->pose[i];
+        body_pose_set(pose, pose->x, pose->y, pose->angle);
+        world->prev_pose[i] = *pose;
+        world->fx[i] = 0.0f;
+        world->fy[i] = 0.0f;
+        world->torque[i] = 0.0f;
+        body_compute_bounds(world, i);
+
+        world->awake[i] = false;
+        world->island_next[i] = (uint32_t)i;
+        if (world->velocity[i].inv_mass > 0.0f)
+        {
+            body_activate(world, i);
+        }
+    }
+    return true;
+}
+
+/* ========================================================================== */
+/* STEP                                                                       */
+/* ========================================================================== */
+
+/* Active bodies from position first in the active list on */
+static void body_integrate_velocities(BodyWorld* world, int first, float dt)
+{
+    Vector2 gravity = world->gravity;
+    for (int k = first; k < world->active_count; ++k)
+    {
+        uint32_t i = world->active[k];
+        BodyVelocity* velocity = &world->velocity[i];
+        velocity->vx += (gravity.x + world->fx[i] * velocity->inv_mass) * dt;
+        velocity->vy += (gravity.y + world->fy[i] * velocity->inv_mass) * dt;
+        velocity->w += world->torque[i] * velocity->inv_inertia * dt;
+        world->fx[i] = 0.0f;
+        world->fy[i] = 0.0f;
+        world->torque[i] = 0.0f;
+    }
+}
+
+static void body_integrate_positions(BodyWorld* world, float dt)
+{
+    for (int k = 0; k < world->active_count; ++k)
+    {
+        uint32_t i = world->active[k];
+        const BodyVelocity* velocity = &world->velocity[i];
+        BodyPose* pose = &world->pose[i];
+        world->prev_pose[i] = *pose;
+
+        pose->x += velocity->vx * dt;
+        pose->y += velocity->vy * dt;
+        if (velocity->w != 0.0f)
+        {
+            body_pose_set(pose, pose->x, pose->y, pose->angle + velocity->w * dt);
+        }
+    }
+}
+
+/* Only awake bodies move, so everyone else keeps the box computed when they last did */
+static void body_update_bounds(BodyWorld* world)
+{
+    for (int k = 0; k < world->active_count; ++k)
+    {
+        body_compute_bounds(world, (int)world->active[k]);
+    }
+}
+
+/* Insertion sort by left edge; orders kept from the last step are nearly sorted, so this is close to linear */
+static void body_sort_by_left(uint32_t* order, int count, const BodyBounds* bounds)
+{
+    for (int i = 1; i < count; ++i)
+    {
+        uint32_t item = order[i];
+        float key = bounds[item].min_x;
+        int j = i - 1;
+        while (j >= 0 && bounds[order[j]].min_x > key)
+        {
+            order[j + 1] = order[j];
+            j--;
+        }
+        order[j + 1] = item;
+    }
+}
+
+/* Re-sorts the awake bodies, starting over from the active list whenever it has changed */
+static void body_sort_sweep(BodyWorld* world)
+{
+    if (world->sweep_revision != world->awake_revision)
+    {
+        memcpy(world->sweep, world->active, sizeof(uint32_t) * (size_t)world->active_count);
+        world->sweep_count = world->active_count;
+        world->sweep_revision = world->awake_revision;
+    }
+    body_sort_by_left(world->sweep, world->sweep_count, world->bounds);
+}
+
+/* Sorts the static and sleeping bodies into rest and wide, if the awake set changed since the last time */
+static void body_build_rest(BodyWorld* world)
+{
+    if (world->rest_revision == world->awake_revision)
+    {
+        return;
+    }
+
+    const BodyBounds* bounds = world->bounds;
+    world->rest_count = 0;
+    world->wide_count = 0;
+    world->rest_reach = 0.0f;
+    for (int i = 0; i < world->count; ++i)
+    {
+        if (world->awake[i])
+        {
+            continue;
+        }
+
+        float width = bounds[i].max_x - bounds[i].min_x;
+        if (width > BODY_WIDE_EXTENT)
+        {
+            world->wide[world->wide_count++] = (uint32_t)i;
+        }
+        else
+        {
+            world->rest[world->rest_count++] = (uint32_t)i;
+            world->rest_reach = MAX(world->rest_reach, width);
+        }
+    }
+    body_sort_by_left(world->rest, world->rest_count, bounds);
+    world->rest_revision = world->awake_revision;
+}
+
+/* First position in rest whose left edge is at or right of x */
+static int body_rest_lower_bound(const BodyWorld* world, float x)
+{
+    int low = 0;
+    int high = world->rest_count;
+    while (low < high)
+    {
+        int mid = (low + high) / 2;
+        if (world->bounds[world->rest[mid]].min_x < x)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+static inline bool body_boxes_overlap(const BodyBounds* a, const BodyBounds* b)
+{
+    return a->min_x <= b->max_x && b->min_x <= a->max_x && a->min_y <= b->max_y && b->min_y <= a->max_y;
+}
+
+/*
+ * Contact cache lookup for a pair whose boxes overlap. The narrowphase only
+ * runs if the pair is new or has moved relative to itself; otherwise the
+ * cached manifold is reused, and either way the cached impulses come along
+ * for warm starting. A touching pair is appended to this step's manifolds,
+ * and a sleeping body in it wakes its island. Returns false once the
+ * manifolds are full.
+ */
+static bool body_add_pair(BodyWorld* world, uint32_t a, uint32_t b)
+{
+    if (world->manifold_count == world->max_manifolds)
+    {
+        LOG_WARNING("body contacts full (capacity: %d)", world->max_manifolds);
+        return false;
+    }
+
+    // Order the pair by handle so its key and normal are the same every step
+    uint32_t first = a;
+    uint32_t second = b;
+    if (world->index_to_handle[first] > world->index_to_handle[second])
+    {
+        first = b;
+        second = a;
+    }
+
+    const BodyPose* pose_a = &world->pose[first];
+    const BodyPose* pose_b = &world->pose[second];
+    uint32_t key = (world->index_to_handle[first] << 16) | world->index_to_handle[second];
+    ContactManifold* manifold = &world->manifolds[world->manifold_count];
+
+    bool created;
+    ContactCacheEntry* entry = contact_cache_acquire(world->cache, key, &created);
+    if (entry == NULL)
+    {
+        // Cache full: the pair still collides, just without warm starting
+        if (collide_shapes(&world->shapes[first], pose_a, &world->shapes[second], pose_b,
+                           BODY_CONTACT_MARGIN, manifold) == 0)
+        {
+            return true;
+        }
+    }
+    else
+    {
+        if (!created && contact_cache_reuse(entry, pose_a, pose_b))
+        {
+            world->cache->reused++;
+        }
+        else
+        {
+            collide_shapes(&world->shapes[first], pose_a, &world->shapes[second], pose_b,
+                           BODY_CONTACT_MARGIN, manifold);
+            contact_cache_update(entry, manifold, pose_a, pose_b);
+        }
+
+        if (entry->manifold.point_count == 0)
+        {
+            return true;
+        }
+        *manifold = entry->manifold;
+    }
+
+    body_wake_island(world, (int)(world->awake[a] ? b : a));
+
+    manifold->key = key;
+    manifold->a = first;
+    manifold->b = second;
+    manifold->friction = sqrtf(world->friction[first] * world->friction[second]);
+    manifold->restitution = MAX(world->restitution[first], world->restitution[second]);
+    world->manifold_entries[world->manifold_count++] = entry;
+    return true;
+}
+
+/*
+ * Pairs awake body a with the resting bodies its box reaches. Bodies woken
+ * this step are still in rest, so one that woke itself skips itself and
+ * those that woke before it; their own lookup already paired them with it.
+ */
+static bool body_find_resting_pairs(BodyWorld* world, uint32_t a)
+{
+    const BodyBounds* bounds = world->bounds;
+    const BodyBounds* box_a = &bounds[a];
+    const uint32_t slot = world->active_slot[a];
+
+    // Nothing in rest starting further left than its widest member can reach this box
+    for (int j = body_rest_lower_bound(world, box_a->min_x - world->rest_reach); j < world->rest_count; ++j)
+    {
+        uint32_t b = world->rest[j];
+        if (bounds[b].min_x > box_a->max_x)
+        {
+            break;
+        }
+        if (body_boxes_overlap(box_a, &bounds[b]) &&
+            !(world->awake[b] && world->active_slot[b] <= slot) && !body_add_pair(world, a, b))
+        {
+            return false;
+        }
+    }
+    for (int j = 0; j < world->wide_count; ++j)
+    {
+        uint32_t b = world->wide[j];
+        if (body_boxes_overlap(box_a, &bounds[b]) &&
+            !(world->awake[b] && world->active_slot[b] <= slot) && !body_add_pair(world, a, b))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Finds this step's contacts: sort-and-sweep along x over the awake bodies,
+ * then each awake body against the resting ones it can reach; two resting
+ * bodies are never paired. A body touching a sleeping one wakes its island.
+ * The woken bodies are appended to the active list, so the same loop then
+ * looks up their resting neighbours too, and every pair is visited once.
+ * They also get the velocity update they missed at the start of the step.
+ */
+static void body_find_contacts(BodyWorld* world, float dt)
+{
+    const uint32_t* sweep = world->sweep;
+    const BodyBounds* bounds = world->bounds;
+    int awake_count = world->active_count;
+
+    world->manifold_count = 0;
+    contact_cache_begin(world->cache);
+
+    for (int i = 0; i < world->sweep_count; ++i)
+    {
+        uint32_t a = sweep[i];
+        const BodyBounds* box_a = &bounds[a];
+
+        for (int j = i + 1; j < world->sweep_count; ++j)
+        {
+            uint32_t b = sweep[j];
+            const BodyBounds* box_b = &bounds[b];
+            if (box_b->min_x > box_a->max_x)
+            {
+                break;
+            }
+            if (box_b->min_y > box_a->max_y || box_b->max_y < box_a->min_y)
+            {
+                continue;
+            }
+            if (!body_add_pair(world, a, b))
+            {
+                goto done;
+            }
+        }
+    }
+
+    for (int k = 0; k < world->active_count; ++k)
+    {
+        if (!body_find_resting_pairs(world, world->active[k]))
+        {
+            break;
+        }
+    }
+
+done:
+    body_integrate_velocities(world, awake_count, dt);
+}
+
+/* ========================================================================== */
+/* ISLANDS                                                                    */
+/* ========================================================================== */
+
+static uint32_t body_island_find(uint32_t* parent, uint32_t i)
+{
+    while (parent[i] != i)
+    {
+        // Path halving: point every other node at its grandparent on the way up
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+/*
+ * Groups the awake bodies into islands by union-find over this step's
+ * touching contacts; static bodies join nothing, so a floor does not merge
+ * every pile on it into one island. Each body counts how long it has been
+ * slower than the sleep thresholds, and an island whose slowest-to-settle
+ * body has been still for BODY_TIME_TO_SLEEP goes to sleep as a whole.
+ * Everything here walks only active bodies and live manifolds.
+ */
+static void body_update_islands(BodyWorld* world, float dt)
+{
+    uint32_t* parent = world->island_parent;
+    float* island_sleep = world->island_sleep;
+    const float linear_sq = BODY_SLEEP_LINEAR * BODY_SLEEP_LINEAR;
+    const float angular_sq = BODY_SLEEP_ANGULAR * BODY_SLEEP_ANGULAR;
+
+    for (int k = 0; k < world->active_count; ++k)
+    {
+        uint32_t i = world->active[k];
+        parent[i] = i;
+        island_sleep[i] = FLT_MAX;
+    }
+
+    for (int m = 0; m < world->manifold_count; ++m)
+    {
+        const ContactManifold* manifold = &world->manifolds[m];
+        if (world->velocity[manifold->a].inv_mass == 0.0f || world->velocity[manifold->b].inv_mass == 0.0f)
+        {
+            continue;
+        }
+
+        uint32_t root_a = body_island_find(parent, manifold->a);
+        uint32_t root_b = body_island_find(parent, manifold->b);
+        if (root_a != root_b)
+        {
+            parent[root_b] = root_a;
+        }
+    }
+
+    for (int k = 0; k < world->active_count; ++k)
+    {
+        uint32_t i = world->active[k];
+        const BodyVelocity* velocity = &world->velocity[i];
+        if (vec2_length_squared(vec2_new(velocity->vx, velocity->vy)) > linear_sq ||
+            velocity->w * velocity->w > angular_sq)
+        {
+            world->sleep_time[i] = 0.0f;
+        }
+        else
+        {
+            world->sleep_time[i] += dt;
+        }
+
+        uint32_t root = body_island_find(parent, i);
+        island_sleep[root] = MIN(island_sleep[root], world->sleep_time[i]);
+    }
+
+    // Put islands to sleep, linking each into a ring through its root
+    int k = 0;
+    while (k < world->active_count)
+    {
+        uint32_t i = world->active[k];
+        uint32_t root = body_island_find(parent, i);
+        if (island_sleep[root] < BODY_TIME_TO_SLEEP)
+        {
+            k++;
+            continue;
+        }
+
+        BodyVelocity* velocity = &world->velocity[i];
+        velocity->vx = 0.0f;
+        velocity->vy = 0.0f;
+        velocity->w = 0.0f;
+        world->prev_pose[i] = world->pose[i];
+        world->awake[i] = false;
+        world->awake_revision++;
+        body_compute_bounds(world, (int)i);
+        if (i != root)
+        {
+            world->island_next[i] = world->island_next[root];
+            world->island_next[root] = i;
+        }
+
+        // Swap-remove; the body moved into slot k is examined next
+        uint32_t moved = world->active[--world->active_count];
+        world->active[k] = moved;
+        world->active_slot[moved] = (uint32_t)k;
+    }
+}
+
+/*
+ * One fixed step: forces and gravity into velocities, contacts from the
+ * current poses, warm-started impulse iterations, then positions from the
+ * solved velocities. The solved impulses go back into the contact cache to
+ * warm start the next step, and pairs that stopped overlapping leave it.
+ * Islands that have come to rest go to sleep last; sleeping bodies cost
+ * nothing until something wakes them.
+ */
+void body_world_step(BodyWorld* world, float dt)
+{
+    if (dt <= 0.0f)
+    {
+        return;
+    }
+
+    body_integrate_velocities(world, 0, dt);
+
+    body_update_bounds(world);
+    body_sort_sweep(world);
+    body_build_rest(world);
+    body_find_contacts(world, dt);
+
+    contact_prepare(world->manifolds, world->manifold_count, world->velocity, dt);
+    contact_warm_start(world->manifolds, world->manifold_count, world->velocity);
+    for (int i = 0; i < world->iterations; ++i)
+    {
+        contact_solve(world->manifolds, world->manifold_count, world->velocity);
+    }
+    contact_cache_store_impulses(world->manifolds, world->manifold_entries, world->manifold_count);
+    for (int k = 0; k < world->active_count; ++k)
+    {
+        contact_cache_evict(world->cache, world->index_to_handle[world->active[k]]);
+    }
+
+#ifdef PLAYSICS_DEBUG_DRAW
+    for (int i = 0; i < world->manifold_count; ++i)
+    {
+        const ContactManifold* manifold = &world->manifolds[i];
+        const BodyPose* pose = &world->pose[manifold->a];
+        for (int p = 0; p < manifold->point_count; ++p)
+        {
+            const ContactPoint* cp = &manifold->points[p];
+            DEBUG_DRAW_CONTACT(pose->x + cp->rax, pose->y + cp->ray, manifold->nx, manifold->ny);
+        }
+    }
+#endif
+
+    body_integrate_positions(world, dt);
+    body_update_islands(world, dt);
+}
+
+/* ========================================================================== */
+/* BUILDERS                                                                   */
+/* ========================================================================== */
+
+/*
+ * Stacks rows of size x size boxes into a pyramid standing on base, one box
+ * fewer per row. Returns the number of bodies added.
+ */
+int body_world_build_pyramid(BodyWorld* world, Vector2 base, int rows, float size, float density)
+{
+    Body body;
+    memset(&body, 0, sizeof(body));
+    body.density = density;
+    body.friction = 0.6f;
+    body.shape = body_shape_box(size, size);
+
+    int added = 0;
+    for (int row = 0; row < rows; ++row)
+    {
+        int columns = rows - row;
+        float left = base.x - 0.5f * size * (float)(columns - 1);
+        for (int column = 0; column < columns; ++column)
+        {
+            body.position = vec2_new(left + size * (float)column, base.y - size * (0.5f + (float)row));
+            if (body_world_add(world, &body) == BODY_INVALID_HANDLE)
+            {
+                return added;
+            }
+            added++;
+        }
+    }
+    return added;
+}
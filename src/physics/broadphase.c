@@ -0,0 +1,792 @@
+#include "common.h"
+#include "physics/broadphase.h"
+#include "logging.h"
+#include "memory.h"
+#include "debug_draw.h"
+
+BroadphaseGrid* broadphase_grid_create(float cell_size, int max_items)
+{
+    if (cell_size <= 0.0f || max_items <= 0)
+    {
+        LOG_ERROR("broadphase:create: Invalid parameters");
+        return NULL;
+    }
+
+    BroadphaseGrid* grid = (BroadphaseGrid*)pd_malloc(sizeof(BroadphaseGrid));
+    if (grid == NULL)
+    {
+        LOG_ERROR("broadphase:create: Memory allocation failed");
+        return NULL;
+    }
+
+    grid->cell_size = cell_size;
+    grid->inv_cell_size = 1.0f / cell_size;
+    grid->columns = (int)ceilf((float)SCREEN_WIDTH / cell_size);
+    grid->rows = (int)ceilf((float)SCREEN_HEIGHT / cell_size);
+    grid->max_items = max_items;
+    grid->pairs = NULL;
+    grid->max_pairs = 0;
+    grid->pair_count = 0;
+    grid->overflowed = false;
+    grid->overflow_reported = false;
+
+    int cells = grid->columns * grid->rows;
+    grid->cell_start = (uint32_t*)pd_malloc(sizeof(uint32_t) * (size_t)(cells + 1));
+    grid->cell_of = (uint32_t*)pd_malloc(sizeof(uint32_t) * (size_t)max_items);
+    grid->sorted = (uint32_t*)pd_malloc(sizeof(uint32_t) * (size_t)max_items);
+
+    if (grid->cell_start == NULL || grid->cell_of == NULL || grid->sorted == NULL)
+    {
+        LOG_ERROR("broadphase:create: Failed to allocate grid storage");
+        broadphase_grid_destroy(grid);
+        return NULL;
+    }
+
+    return grid;
+}
+
+void broadphase_grid_destroy(BroadphaseGrid* grid)
+{
+    if (grid != NULL)
+    {
+        pd_free(grid->cell_start);
+        pd_free(grid->cell_of);
+        pd_free(grid->sorted);
+        pd_free(grid);
+    }
+}
+
+/* Tests every item of cell a against every item of cell b (a != b) */
+static void broadphase_grid_test_cells(BroadphaseGrid* grid, const float* x, const float* y,
+                                       int cell_a, int cell_b, float range_sq)
+{
+    const uint32_t* sorted = grid->sorted;
+    uint32_t b_begin = grid->cell_start[cell_b];
+    uint32_t b_end = grid->cell_start[cell_b + 1];
+    if (b_begin == b_end)
+    {
+        return;
+    }
+
+    for (uint32_t i = grid->cell_start[cell_a]; i < grid->cell_start[cell_a + 1]; ++i)
+    {
+        uint32_t a = sorted[i];
+        float ax = x[a];
+        float ay = y[a];
+
+        for (uint32_t j = b_begin; j < b_end; ++j)
+        {
+            uint32_t b = sorted[j];
+            float dx = x[b] - ax;
+            float dy = y[b] - ay;
+            if (dx * dx + dy * dy < range_sq)
+            {
+                if (grid->pair_count == grid->max_pairs)
+                {
+                    grid->overflowed = true;
+                    return;
+                }
+                grid->pairs[grid->pair_count++] = (BroadphasePair){ a, b };
+            }
+        }
+    }
+}
+
+/* Tests the items of one cell against each other */
+static void broadphase_grid_test_self(BroadphaseGrid* grid, const float* x, const float* y,
+                                      int cell, float range_sq)
+{
+    const uint32_t* sorted = grid->sorted;
+    uint32_t end = grid->cell_start[cell + 1];
+
+    for (uint32_t i = grid->cell_start[cell]; i < end; ++i)
+    {
+        uint32_t a = sorted[i];
+        float ax = x[a];
+        float ay = y[a];
+
+        for (uint32_t j = i + 1; j < end; ++j)
+        {
+            uint32_t b = sorted[j];
+            float dx = x[b] - ax;
+            float dy = y[b] - ay;
+            if (dx * dx + dy * dy < range_sq)
+            {
+                if (grid->pair_count == grid->max_pairs)
+                {
+                    grid->overflowed = true;
+                    return;
+                }
+                grid->pairs[grid->pair_count++] = (BroadphasePair){ a, b };
+            }
+        }
+    }
+}
+
+/*
+ * Rebuilds the grid from the given positions and writes every pair closer
+ * than two radii into the caller's buffer, stopping once it is full (logged
+ * the first time it happens). Items outside the screen are clamped into the
+ * border cells, so they still collide correctly, just less efficiently. The
+ * cell size must be at least 2 * radius for the one-ring neighbour search to
+ * be complete.
+ */
+int broadphase_grid_build(BroadphaseGrid* grid, const float* x, const float* y, int count, float radius,
+                          BroadphasePair* pairs, int max_pairs)
+{
+    grid->pairs = pairs;
+    grid->max_pairs = max_pairs;
+    grid->pair_count = 0;
+    grid->overflowed = false;
+
+    if (count > grid->max_items)
+    {
+        LOG_WARNING("%d items exceed grid capacity %d", count, grid->max_items);
+        count = grid->max_items;
+    }
+
+    const int columns = grid->columns;
+    const int rows = grid->rows;
+    const int cells = columns * rows;
+    const float inv_cell = grid->inv_cell_size;
+    uint32_t* cell_start = grid->cell_start;
+    uint32_t* cell_of = grid->cell_of;
+
+    // Pass 1: bin every item and histogram the cells
+    memset(cell_start, 0, sizeof(uint32_t) * (size_t)(cells + 1));
+    for (int i = 0; i < count; ++i)
+    {
+        int cx = (int)float_clamp(x[i] * inv_cell, 0.0f, (float)(columns - 1));
+        int cy = (int)float_clamp(y[i] * inv_cell, 0.0f, (float)(rows - 1));
+        uint32_t cell = (uint32_t)(cy * columns + cx);
+        cell_of[i] = cell;
+        cell_start[cell]++;
+    }
+
+    // Inclusive prefix sum: cell_start[c] becomes the end of cell c
+    uint32_t running = 0;
+    for (int c = 0; c < cells; ++c)
+    {
+        running += cell_start[c];
+        cell_start[c] = running;
+    }
+    cell_start[cells] = running;
+
+    // Pass 2: scatter back to front, leaving cell_start[c] at the start of c
+    for (int i = count - 1; i >= 0; --i)
+    {
+        grid->sorted[--cell_start[cell_of[i]]] = (uint32_t)i;
+    }
+
+    // Pair search over a half neighbourhood so every pair is reported once
+    const float range = 2.0f * radius;
+    const float range_sq = range * range;
+
+    for (int cy = 0; cy < rows; ++cy)
+    {
+        for (int cx = 0; cx < columns; ++cx)
+        {
+            int cell = cy * columns + cx;
+            if (cell_start[cell] == cell_start[cell + 1])
+            {
+                continue;
+            }
+
+            broadphase_grid_test_self(grid, x, y, cell, range_sq);
+            if (cx + 1 < columns)
+            {
+                broadphase_grid_test_cells(grid, x, y, cell, cell + 1, range_sq);
+            }
+            if (cy + 1 < rows)
+            {
+                int below = cell + columns;
+                if (cx > 0)
+                {
+                    broadphase_grid_test_cells(grid, x, y, cell, below - 1, range_sq);
+                }
+                broadphase_grid_test_cells(grid, x, y, cell, below, range_sq);
+                if (cx + 1 < columns)
+                {
+                    broadphase_grid_test_cells(grid, x, y, cell, below + 1, range_sq);
+                }
+            }
+
+            if (grid->overflowed)
+            {
+                if (!grid->overflow_reported)
+                {
+                    LOG_WARNING("grid pairs full (capacity: %d); pairs past it are dropped", grid->max_pairs);
+                    grid->overflow_reported = true;
+                }
+                return grid->pair_count;
+            }
+        }
+    }
+
+    return grid->pair_count;
+}
+
+#ifdef PLAYSICS_DEBUG_DRAW
+/* Outlines every occupied cell of the last build */
+void broadphase_grid_debug_draw(const BroadphaseGrid* grid)
+{
+    for (int cy = 0; cy < grid->rows; ++cy)
+    {
+        for (int cx = 0; cx < grid->columns; ++cx)
+        {
+            int cell = cy * grid->columns + cx;
+            if (grid->cell_start[cell] != grid->cell_start[cell + 1])
+            {
+                float x = (float)cx * grid->cell_size;
+                float y = (float)cy * grid->cell_size;
+                DEBUG_DRAW_AABB(x, y, x + grid->cell_size, y + grid->cell_size);
+            }
+        }
+    }
+}
+#endif
+
+/* ========================================================================== */
+/* SWEEP AND PRUNE                                                            */
+/* ========================================================================== */
+
+/* A set of boxes as four arrays, indexed by axis: 0 is x, 1 is y */
+typedef struct
+{
+    const float* min[2];
+    const float* max[2];
+} BroadphaseBoxes;
+
+/*
+ * Endpoint order: by value, then mins before maxes so boxes that just touch
+ * count as overlapping, then by item. Being total, the order an update
+ * sorts into is the one a rebuild would, and a min passes a max exactly
+ * when the overlap test below changes its answer for them.
+ */
+static inline bool broadphase_sap_before(const BroadphaseEndpoint* a, const BroadphaseEndpoint* b)
+{
+    if (a->value != b->value)
+    {
+        return a->value < b->value;
+    }
+    uint32_t rank_a = ((a->item & 1u) << 31) | (a->item >> 1);
+    uint32_t rank_b = ((b->item & 1u) << 31) | (b->item >> 1);
+    return rank_a < rank_b;
+}
+
+static int broadphase_sap_compare(const void* a, const void* b)
+{
+    const BroadphaseEndpoint* ea = (const BroadphaseEndpoint*)a;
+    const BroadphaseEndpoint* eb = (const BroadphaseEndpoint*)b;
+    return broadphase_sap_before(ea, eb) ? -1 : broadphase_sap_before(eb, ea) ? 1 : 0;
+}
+
+static inline bool broadphase_sap_overlap_on(const BroadphaseBoxes* boxes, int axis, uint32_t a, uint32_t b)
+{
+    return boxes->min[axis][b] <= boxes->max[axis][a] && boxes->min[axis][a] <= boxes->max[axis][b];
+}
+
+static inline bool broadphase_sap_overlap(const BroadphaseBoxes* boxes, uint32_t a, uint32_t b)
+{
+    return broadphase_sap_overlap_on(boxes, 0, a, b) && broadphase_sap_overlap_on(boxes, 1, a, b);
+}
+
+/* The boxes as of the last update */
+static BroadphaseBoxes broadphase_sap_previous(const BroadphaseSap* sap)
+{
+    const float* bounds = sap->bounds;
+    const size_t n = (size_t)sap->max_items;
+    BroadphaseBoxes boxes = { { bounds, bounds + n }, { bounds + 2 * n, bounds + 3 * n } };
+    return boxes;
+}
+
+/*
+ * max_changes is where the added and removed lists start, not a limit: a
+ * rebuild lists every overlapping pair as added, and both double whenever
+ * an update fills them.
+ */
+BroadphaseSap* broadphase_sap_create(int max_items, int max_changes)
+{
+    // Pair keys pack both indices into 16 bits each
+    if (max_items <= 0 || max_items > 0x10000 || max_changes <= 0)
+    {
+        LOG_ERROR("broadphase:sap_create: Invalid parameters");
+        return NULL;
+    }
+
+    BroadphaseSap* sap = (BroadphaseSap*)pd_calloc(1, sizeof(BroadphaseSap));
+    if (sap == NULL)
+    {
+        LOG_ERROR("broadphase:sap_create: Memory allocation failed");
+        return NULL;
+    }
+
+    sap->max_items = max_items;
+    sap->max_changes = max_changes;
+
+    size_t items = (size_t)max_items;
+    sap->endpoints[0] = (BroadphaseEndpoint*)pd_malloc(sizeof(BroadphaseEndpoint) * 2 * items);
+    sap->endpoints[1] = (BroadphaseEndpoint*)pd_malloc(sizeof(BroadphaseEndpoint) * 2 * items);
+    sap->bounds = (float*)pd_malloc(sizeof(float) * 4 * items);
+    sap->open = (uint32_t*)pd_malloc(sizeof(uint32_t) * items);
+    sap->added = (BroadphasePair*)pd_malloc(sizeof(BroadphasePair) * (size_t)max_changes);
+    sap->removed = (BroadphasePair*)pd_malloc(sizeof(BroadphasePair) * (size_t)max_changes);
+
+    if (sap->endpoints[0] == NULL || sap->endpoints[1] == NULL || sap->bounds == NULL || sap->open == NULL ||
+        sap->added == NULL || sap->removed == NULL)
+    {
+        LOG_ERROR("broadphase:sap_create: Failed to allocate sweep storage");
+        broadphase_sap_destroy(sap);
+        return NULL;
+    }
+
+    broadphase_sap_clear(sap);
+    return sap;
+}
+
+void broadphase_sap_destroy(BroadphaseSap* sap)
+{
+    if (sap != NULL)
+    {
+        pd_free(sap->endpoints[0]);
+        pd_free(sap->endpoints[1]);
+        pd_free(sap->bounds);
+        pd_free(sap->open);
+        pd_free(sap->added);
+        pd_free(sap->removed);
+        pd_free(sap);
+    }
+}
+
+/* Forgets every item; the next update rebuilds and reports a reset */
+void broadphase_sap_clear(BroadphaseSap* sap)
+{
+    sap->item_count = 0;
+    sap->built = false;
+    sap->added_count = 0;
+    sap->removed_count = 0;
+    sap->reset = false;
+    sap->overflowed = false;
+}
+
+/*
+ * Appends a change, doubling both lists when full. If memory runs out the
+ * change is dropped, the update is marked overflowed and the next one
+ * rebuilds, which puts whoever follows the changes right again.
+ */
+static void broadphase_sap_record(BroadphaseSap* sap, bool added, uint32_t a, uint32_t b)
+{
+    int* count = added ? &sap->added_count : &sap->removed_count;
+    if (*count == sap->max_changes)
+    {
+        if (sap->overflowed)
+        {
+            return;
+        }
+
+        // A failed realloc leaves its list as it was; one that succeeded is just roomier than needed
+        size_t size = sizeof(BroadphasePair) * 2 * (size_t)sap->max_changes;
+        BroadphasePair* added_list = (BroadphasePair*)pd_realloc(sap->added, size);
+        sap->added = added_list != NULL ? added_list : sap->added;
+        BroadphasePair* removed_list = (BroadphasePair*)pd_realloc(sap->removed, size);
+        sap->removed = removed_list != NULL ? removed_list : sap->removed;
+        if (added_list == NULL || removed_list == NULL)
+        {
+            if (!sap->overflow_reported)
+            {
+                LOG_WARNING("sweep changes can't grow past %d pairs; rebuilding", sap->max_changes);
+                sap->overflow_reported = true;
+            }
+            sap->overflowed = true;
+            sap->built = false;
+            return;
+        }
+        sap->max_changes *= 2;
+    }
+
+    BroadphasePair* list = added ? sap->added : sap->removed;
+    list[(*count)++] = (BroadphasePair){ MIN(a, b), MAX(a, b) };
+}
+
+/* Sorts both axes from scratch and sweeps x once, listing every overlapping pair as added */
+static void broadphase_sap_rebuild(BroadphaseSap* sap, const BroadphaseBoxes* boxes, int count, uint32_t revision)
+{
+    sap->reset = true;
+    sap->overflowed = false;
+    sap->item_count = count;
+    sap->revision = revision;
+    sap->built = true;
+
+    for (int axis = 0; axis < 2; ++axis)
+    {
+        BroadphaseEndpoint* endpoints = sap->endpoints[axis];
+        for (int i = 0; i < count; ++i)
+        {
+            endpoints[2 * i] = (BroadphaseEndpoint){ boxes->min[axis][i], (uint32_t)i << 1 };
+            endpoints[2 * i + 1] = (BroadphaseEndpoint){ boxes->max[axis][i], ((uint32_t)i << 1) | 1u };
+        }
+        qsort(endpoints, (size_t)count * 2, sizeof(BroadphaseEndpoint), broadphase_sap_compare);
+    }
+
+    const BroadphaseEndpoint* endpoints = sap->endpoints[0];
+    int open_count = 0;
+    for (int e = 0; e < count * 2; ++e)
+    {
+        uint32_t item = endpoints[e].item >> 1;
+        if ((endpoints[e].item & 1u) == 0)
+        {
+            for (int o = 0; o < open_count; ++o)
+            {
+                if (broadphase_sap_overlap_on(boxes, 1, sap->open[o], item))
+                {
+                    broadphase_sap_record(sap, true, sap->open[o], item);
+                }
+            }
+            sap->open[open_count++] = item;
+        }
+        else
+        {
+            for (int o = 0; o < open_count; ++o)
+            {
+                if (sap->open[o] == item)
+                {
+                    sap->open[o] = sap->open[--open_count];
+                    break;
+                }
+            }
+        }
+    }
+}
+
+/*
+ * Moves each endpoint on one axis to its item's current extent and
+ * insertion-sorts them back into order. An endpoint only passes the ones it
+ * actually overtook, so the cost follows how much the order changed rather
+ * than the item count squared. A min passing a max starts an overlap on
+ * this axis, and the pair is added if the boxes now overlap on both; a max
+ * passing a min ends one, and the pair is removed if the boxes overlapped
+ * on both before. A pair whose overlap starts or ends on both axes in one
+ * update is recorded on x only, so each change is listed once.
+ */
+static void broadphase_sap_resort(BroadphaseSap* sap, int axis, const BroadphaseBoxes* previous,
+                                  const BroadphaseBoxes* boxes)
+{
+    BroadphaseEndpoint* endpoints = sap->endpoints[axis];
+    const int count = sap->item_count * 2;
+
+    for (int e = 0; e < count; ++e)
+    {
+        uint32_t item = endpoints[e].item;
+        endpoints[e].value = (item & 1u) ? boxes->max[axis][item >> 1] : boxes->min[axis][item >> 1];
+    }
+
+    for (int i = 1; i < count; ++i)
+    {
+        BroadphaseEndpoint moving = endpoints[i];
+        int j = i - 1;
+        while (j >= 0 && broadphase_sap_before(&moving, &endpoints[j]))
+        {
+            uint32_t passed = endpoints[j].item;
+            bool moving_max = (moving.item & 1u) != 0;
+            bool passed_max = (passed & 1u) != 0;
+            uint32_t a = moving.item >> 1;
+            uint32_t b = passed >> 1;
+            if (!moving_max && passed_max)
+            {
+                if (broadphase_sap_overlap(boxes, a, b) && (axis == 0 || broadphase_sap_overlap_on(previous, 0, a, b)))
+                {
+                    broadphase_sap_record(sap, true, a, b);
+                }
+            }
+            else if (moving_max && !passed_max)
+            {
+                if (broadphase_sap_overlap(previous, a, b) && (axis == 0 || broadphase_sap_overlap_on(boxes, 0, a, b)))
+                {
+                    broadphase_sap_record(sap, false, a, b);
+                }
+            }
+            endpoints[j + 1] = endpoints[j];
+            j--;
+        }
+        endpoints[j + 1] = moving;
+    }
+}
+
+/*
+ * Brings the sweep up to date with the given boxes and lists the pairs that
+ * started overlapping in sap->added and those that stopped in sap->removed.
+ * Boxes are indexed like the caller's arrays, and a different count or
+ * revision (indices moved) means a rebuild: sap->reset is set and added
+ * holds every overlapping pair. sap->overflowed means the lists were cut
+ * short; the next update rebuilds.
+ */
+void broadphase_sap_update(BroadphaseSap* sap, const float* min_x, const float* min_y, const float* max_x,
+                           const float* max_y, int count, uint32_t revision)
+{
+    sap->added_count = 0;
+    sap->removed_count = 0;
+    sap->reset = false;
+
+    if (count > sap->max_items)
+    {
+        LOG_WARNING("%d items exceed sweep capacity %d", count, sap->max_items);
+        count = sap->max_items;
+    }
+
+    BroadphaseBoxes boxes = { { min_x, min_y }, { max_x, max_y } };
+    if (!sap->built || sap->revision != revision || sap->item_count != count)
+    {
+        broadphase_sap_rebuild(sap, &boxes, count, revision);
+    }
+    else
+    {
+        sap->overflowed = false;
+        BroadphaseBoxes previous = broadphase_sap_previous(sap);
+        broadphase_sap_resort(sap, 0, &previous, &boxes);
+        broadphase_sap_resort(sap, 1, &previous, &boxes);
+    }
+
+    // Laid out as broadphase_sap_previous reads it
+    size_t n = (size_t)sap->max_items;
+    size_t size = sizeof(float) * (size_t)count;
+    memcpy(sap->bounds, min_x, size);
+    memcpy(sap->bounds + n, min_y, size);
+    memcpy(sap->bounds + 2 * n, max_x, size);
+    memcpy(sap->bounds + 3 * n, max_y, size);
+}
+
+/* ========================================================================== */
+/* PAIR SET                                                                   */
+/* ========================================================================== */
+
+/* Fibonacci hashing, as in the contact cache */
+static inline uint32_t broadphase_pair_home(const BroadphasePairSet* set, uint32_t key)
+{
+    return (key * 2654435769u) >> set->shift;
+}
+
+/* Sizes the table for capacity keys, never more than half full so probe runs stay short and always end */
+static void broadphase_pair_table_size(int capacity, uint32_t* slots, int* bits)
+{
+    *slots = 16;
+    *bits = 4;
+    while (*slots < (uint32_t)capacity * 2)
+    {
+        *slots <<= 1;
+        (*bits)++;
+    }
+}
+
+BroadphasePairSet* broadphase_pair_set_create(int capacity)
+{
+    if (capacity <= 0)
+    {
+        LOG_ERROR("broadphase:pair_set_create: Invalid parameters");
+        return NULL;
+    }
+
+    BroadphasePairSet* set = (BroadphasePairSet*)pd_calloc(1, sizeof(BroadphasePairSet));
+    if (set == NULL)
+    {
+        LOG_ERROR("broadphase:pair_set_create: Memory allocation failed");
+        return NULL;
+    }
+
+    uint32_t slots;
+    int bits;
+    broadphase_pair_table_size(capacity, &slots, &bits);
+    set->capacity = capacity;
+    set->mask = slots - 1;
+    set->shift = 32 - bits;
+    set->pairs = (BroadphasePair*)pd_malloc(sizeof(BroadphasePair) * (size_t)capacity);
+    set->table_key = (uint32_t*)pd_malloc(sizeof(uint32_t) * slots);
+    set->table_slot = (uint32_t*)pd_malloc(sizeof(uint32_t) * slots);
+    if (set->pairs == NULL || set->table_key == NULL || set->table_slot == NULL)
+    {
+        LOG_ERROR("broadphase:pair_set_create: Failed to allocate pair storage");
+        broadphase_pair_set_destroy(set);
+        return NULL;
+    }
+
+    broadphase_pair_set_clear(set);
+    return set;
+}
+
+void broadphase_pair_set_destroy(BroadphasePairSet* set)
+{
+    if (set != NULL)
+    {
+        pd_free(set->pairs);
+        pd_free(set->table_key);
+        pd_free(set->table_slot);
+        pd_free(set);
+    }
+}
+
+void broadphase_pair_set_clear(BroadphasePairSet* set)
+{
+    for (uint32_t i = 0; i <= set->mask; ++i)
+    {
+        set->table_key[i] = BROADPHASE_PAIR_EMPTY;
+    }
+    set->count = 0;
+}
+
+/* Table slot holding key, or the empty slot that ends its probe run */
+static uint32_t broadphase_pair_probe(const BroadphasePairSet* set, uint32_t key)
+{
+    uint32_t slot = broadphase_pair_home(set, key);
+    while (set->table_key[slot] != key && set->table_key[slot] != BROADPHASE_PAIR_EMPTY)
+    {
+        slot = (slot + 1) & set->mask;
+    }
+    return slot;
+}
+
+/*
+ * Doubles the pair storage and rehashes the set into a table twice the
+ * size. Happens a few times while a scene first fills up, then the storage
+ * fits. Returns false, with the old storage untouched, if memory ran out.
+ */
+static bool broadphase_pair_set_grow(BroadphasePairSet* set)
+{
+    int capacity = set->capacity * 2;
+    uint32_t slots;
+    int bits;
+    broadphase_pair_table_size(capacity, &slots, &bits);
+
+    uint32_t* table_key = (uint32_t*)pd_malloc(sizeof(uint32_t) * slots);
+    uint32_t* table_slot = (uint32_t*)pd_malloc(sizeof(uint32_t) * slots);
+    BroadphasePair* pairs = table_key != NULL && table_slot != NULL
+                                ? (BroadphasePair*)pd_realloc(set->pairs, sizeof(BroadphasePair) * (size_t)capacity)
+                                : NULL;
+    if (pairs == NULL)
+    {
+        pd_free(table_key);
+        pd_free(table_slot);
+        return false;
+    }
+
+    pd_free(set->table_key);
+    pd_free(set->table_slot);
+    set->pairs = pairs;
+    set->table_key = table_key;
+    set->table_slot = table_slot;
+    set->capacity = capacity;
+    set->mask = slots - 1;
+    set->shift = 32 - bits;
+
+    for (uint32_t i = 0; i < slots; ++i)
+    {
+        table_key[i] = BROADPHASE_PAIR_EMPTY;
+    }
+    for (int pair = 0; pair < set->count; ++pair)
+    {
+        uint32_t slot = broadphase_pair_probe(set, (pairs[pair].a << 16) | pairs[pair].b);
+        table_key[slot] = (pairs[pair].a << 16) | pairs[pair].b;
+        table_slot[slot] = (uint32_t)pair;
+    }
+    return true;
+}
+
+/* Adds a pair (a < b, both below 65536) unless it is already in; false if it didn't fit */
+bool broadphase_pair_set_add(BroadphasePairSet* set, uint32_t a, uint32_t b)
+{
+    uint32_t key = (a << 16) | b;
+    uint32_t slot = broadphase_pair_probe(set, key);
+    if (set->table_key[slot] == key)
+    {
+        return true;
+    }
+
+    if (set->count == set->capacity)
+    {
+        if (!broadphase_pair_set_grow(set))
+        {
+            if (!set->overflow_reported)
+            {
+                LOG_WARNING("pair set can't grow past %d pairs", set->capacity);
+                set->overflow_reported = true;
+            }
+            return false;
+        }
+        slot = broadphase_pair_probe(set, key);
+    }
+
+    int pair = set->count++;
+    set->pairs[pair] = (BroadphasePair){ a, b };
+    set->table_key[slot] = key;
+    set->table_slot[slot] = (uint32_t)pair;
+    return true;
+}
+
+/* Empties a table slot with backward-shift deletion, as contact_cache_remove_at does */
+static void broadphase_pair_set_erase(BroadphasePairSet* set, uint32_t hole)
+{
+    uint32_t j = hole;
+    for (;;)
+    {
+        j = (j + 1) & set->mask;
+        if (set->table_key[j] == BROADPHASE_PAIR_EMPTY)
+        {
+            break;
+        }
+
+        uint32_t home = broadphase_pair_home(set, set->table_key[j]);
+        bool stays = hole <= j ? (hole < home && home <= j) : (hole < home || home <= j);
+        if (!stays)
+        {
+            set->table_key[hole] = set->table_key[j];
+            set->table_slot[hole] = set->table_slot[j];
+            hole = j;
+        }
+    }
+    set->table_key[hole] = BROADPHASE_PAIR_EMPTY;
+}
+
+/* Removes a pair (a < b) if it is in, moving the last pair into its place */
+void broadphase_pair_set_remove(BroadphasePairSet* set, uint32_t a, uint32_t b)
+{
+    uint32_t slot = broadphase_pair_probe(set, (a << 16) | b);
+    if (set->table_key[slot] == BROADPHASE_PAIR_EMPTY)
+    {
+        return;
+    }
+
+    uint32_t pair = set->table_slot[slot];
+    broadphase_pair_set_erase(set, slot);
+
+    uint32_t last = (uint32_t)--set->count;
+    if (pair != last)
+    {
+        set->pairs[pair] = set->pairs[last];
+        uint32_t moved = broadphase_pair_probe(set, (set->pairs[pair].a << 16) | set->pairs[pair].b);
+        set->table_slot[moved] = pair;
+    }
+}
+
+/*
+ * Applies the sweep's last update to the set, starting it over after a
+ * reset. The cost follows what changed, not how many pairs there are.
+ * Returns false if the set is now missing pairs, because the sweep's
+ * changes or the set itself ran out of memory; clearing the sweep then
+ * rebuilds both on the next update.
+ */
+bool broadphase_pair_set_apply(BroadphasePairSet* set, const BroadphaseSap* sap)
+{
+    if (sap->reset)
+    {
+        broadphase_pair_set_clear(set);
+    }
+    for (int i = 0; i < sap->removed_count; ++i)
+    {
+        broadphase_pair_set_remove(set, sap->removed[i].a, sap->removed[i].b);
+    }
+
+    bool complete = !sap->overflowed;
+    for (int i = 0; i < sap->added_count; ++i)
+    {
+        complete &= broadphase_pair_set_add(set, sap->added[i].a, sap->added[i].b);
+    }
+    return complete;
+}
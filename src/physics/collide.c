@@ -0,0 +1,348 @@
+#include <float.h>
+
+#include "common.h"
+#include "physics/collide.h"
+
+/*
+ * Narrowphase: contact manifolds between body shapes. Polygons (boxes and
+ * AABBs included) are tested with the separating axis theorem and their
+ * contact points found by clipping the incident edge against the reference
+ * face, so a resting box gets two points. Pairs closer than the margin still
+ * produce contacts, with a positive separation the solver treats as
+ * speculative; keeping them alive while a stack settles is what lets warm
+ * starting converge.
+ */
+
+/* Only switch the reference face to b when it is clearly the better axis */
+#define COLLIDE_RELATIVE_TOL 0.98f
+#define COLLIDE_ABSOLUTE_TOL 0.05f
+
+/* Feature ids: reference edge in bits 8-15, incident vertex or clip plane below */
+#define COLLIDE_ID_CLIPPED 0x80u
+#define COLLIDE_ID_FLIPPED 0x10000u
+
+typedef struct
+{
+    Vector2 v;
+    uint32_t id;
+} CollideVertex;
+
+/* A polygon shape moved into world space */
+typedef struct
+{
+    int count;
+    Vector2 vertices[BODY_MAX_VERTICES];
+    Vector2 normals[BODY_MAX_VERTICES];
+} CollidePolygon;
+
+static void collide_world_polygon(const BodyShape* shape, const BodyPose* pose, CollidePolygon* out)
+{
+    float c = pose->c;
+    float s = pose->s;
+    out->count = shape->count;
+    for (int i = 0; i < shape->count; ++i)
+    {
+        Vector2 v = shape->vertices[i];
+        Vector2 n = shape->normals[i];
+        out->vertices[i] = vec2_new(c * v.x - s * v.y + pose->x, s * v.x + c * v.y + pose->y);
+        out->normals[i] = vec2_new(c * n.x - s * n.y, s * n.x + c * n.y);
+    }
+}
+
+static void collide_add_point(ContactManifold* manifold, const BodyPose* pose_a, const BodyPose* pose_b,
+                              Vector2 point, float separation, uint32_t id)
+{
+    ContactPoint* cp = &manifold->points[manifold->point_count++];
+    cp->rax = point.x - pose_a->x;
+    cp->ray = point.y - pose_a->y;
+    cp->rbx = point.x - pose_b->x;
+    cp->rby = point.y - pose_b->y;
+    cp->separation = separation;
+    cp->id = id;
+    cp->normal_impulse = 0.0f;
+    cp->tangent_impulse = 0.0f;
+}
+
+/* ========================================================================== */
+/* CIRCLES                                                                    */
+/* ========================================================================== */
+
+static int collide_circles(const BodyShape* shape_a, const BodyPose* pose_a,
+                           const BodyShape* shape_b, const BodyPose* pose_b,
+                           float margin, ContactManifold* manifold)
+{
+    Vector2 d = vec2_new(pose_b->x - pose_a->x, pose_b->y - pose_a->y);
+    float reach = shape_a->radius + shape_b->radius + margin;
+    float dist_sq = vec2_length_squared(d);
+    if (dist_sq > reach * reach)
+    {
+        return 0;
+    }
+
+    // Concentric circles push apart along an arbitrary axis
+    float dist = VECTOR_SQRTF(dist_sq);
+    Vector2 n = dist > VECTOR_EPSILON ? vec2_scale(d, 1.0f / dist) : vec2_new(0.0f, -1.0f);
+    float separation = dist - shape_a->radius - shape_b->radius;
+
+    manifold->nx = n.x;
+    manifold->ny = n.y;
+    Vector2 point = vec2_new(pose_a->x + n.x * (shape_a->radius + 0.5f * separation),
+                             pose_a->y + n.y * (shape_a->radius + 0.5f * separation));
+    collide_add_point(manifold, pose_a, pose_b, point, separation, 0);
+    return 1;
+}
+
+/*
+ * Polygon against a circle centred at center. The normal points from the
+ * polygon to the circle and the point is halfway between the two surfaces.
+ */
+static bool collide_polygon_circle(const CollidePolygon* poly, Vector2 center, float radius, float margin,
+                                   Vector2* normal, Vector2* point, float* separation)
+{
+    int face = 0;
+    float best = -FLT_MAX;
+    for (int i = 0; i < poly->count; ++i)
+    {
+        float s = vec2_dot(poly->normals[i], vec2_sub(center, poly->vertices[i]));
+        if (s > radius + margin)
+        {
+            return false;
+        }
+        if (s > best)
+        {
+            best = s;
+            face = i;
+        }
+    }
+
+    Vector2 v1 = poly->vertices[face];
+    Vector2 v2 = poly->vertices[(face + 1) % poly->count];
+    Vector2 n = poly->normals[face];
+    Vector2 surface = vec2_sub(center, vec2_scale(n, best));
+
+    // Outside the face's span the closest feature is a vertex
+    if (best > VECTOR_EPSILON)
+    {
+        Vector2 corner = surface;
+        if (vec2_dot(vec2_sub(center, v1), vec2_sub(v2, v1)) <= 0.0f)
+        {
+            corner = v1;
+        }
+        else if (vec2_dot(vec2_sub(center, v2), vec2_sub(v1, v2)) <= 0.0f)
+        {
+            corner = v2;
+        }
+
+        if (corner.x != surface.x || corner.y != surface.y)
+        {
+            Vector2 d = vec2_sub(center, corner);
+            float dist_sq = vec2_length_squared(d);
+            if (dist_sq > (radius + margin) * (radius + margin) || dist_sq < VECTOR_EPSILON)
+            {
+                return false;
+            }
+            n = vec2_scale(d, 1.0f / VECTOR_SQRTF(dist_sq));
+            surface = corner;
+        }
+    }
+
+    *separation = vec2_dot(vec2_sub(center, surface), n) - radius;
+    *normal = n;
+    *point = vec2_add(surface, vec2_scale(n, 0.5f * *separation));
+    return true;
+}
+
+/* ========================================================================== */
+/* POLYGONS                                                                   */
+/* ========================================================================== */
+
+/* Largest separation of b along any face normal of a */
+static float collide_max_separation(const CollidePolygon* a, const CollidePolygon* b, int* edge)
+{
+    float best = -FLT_MAX;
+    *edge = 0;
+    for (int i = 0; i < a->count; ++i)
+    {
+        Vector2 n = a->normals[i];
+        Vector2 v = a->vertices[i];
+
+        float deepest = FLT_MAX;
+        for (int j = 0; j < b->count; ++j)
+        {
+            float s = vec2_dot(n, vec2_sub(b->vertices[j], v));
+            deepest = MIN(deepest, s);
+        }
+
+        if (deepest > best)
+        {
+            best = deepest;
+            *edge = i;
+        }
+    }
+    return best;
+}
+
+/* Keeps the part of a segment where dot(normal, v) <= offset */
+static int collide_clip(CollideVertex out[2], const CollideVertex in[2], Vector2 normal, float offset,
+                        uint32_t plane)
+{
+    int count = 0;
+    float d0 = vec2_dot(normal, in[0].v) - offset;
+    float d1 = vec2_dot(normal, in[1].v) - offset;
+
+    if (d0 <= 0.0f)
+    {
+        out[count++] = in[0];
+    }
+    if (d1 <= 0.0f)
+    {
+        out[count++] = in[1];
+    }
+
+    if (d0 * d1 < 0.0f)
+    {
+        float t = d0 / (d0 - d1);
+        out[count].v = vec2_lerp(in[0].v, in[1].v, t);
+        out[count].id = (in[0].id & ~0xFFu) | COLLIDE_ID_CLIPPED | plane;
+        count++;
+    }
+    return count;
+}
+
+static int collide_polygons(const CollidePolygon* a, const BodyPose* pose_a,
+                            const CollidePolygon* b, const BodyPose* pose_b,
+                            float margin, ContactManifold* manifold)
+{
+    int edge_a;
+    float separation_a = collide_max_separation(a, b, &edge_a);
+    if (separation_a > margin)
+    {
+        return 0;
+    }
+
+    int edge_b;
+    float separation_b = collide_max_separation(b, a, &edge_b);
+    if (separation_b > margin)
+    {
+        return 0;
+    }
+
+    const CollidePolygon* ref = a;
+    const CollidePolygon* inc = b;
+    int ref_edge = edge_a;
+    uint32_t flipped = 0;
+    if (separation_b > COLLIDE_RELATIVE_TOL * separation_a + COLLIDE_ABSOLUTE_TOL)
+    {
+        ref = b;
+        inc = a;
+        ref_edge = edge_b;
+        flipped = COLLIDE_ID_FLIPPED;
+    }
+
+    // The incident edge is the one facing the reference face most directly
+    Vector2 n = ref->normals[ref_edge];
+    int inc_edge = 0;
+    float facing = FLT_MAX;
+    for (int i = 0; i < inc->count; ++i)
+    {
+        float d = vec2_dot(n, inc->normals[i]);
+        if (d < facing)
+        {
+            facing = d;
+            inc_edge = i;
+        }
+    }
+
+    uint32_t ref_id = (uint32_t)ref_edge << 8;
+    int inc_next = (inc_edge + 1) % inc->count;
+    CollideVertex incident[2] = {
+        { inc->vertices[inc_edge], ref_id | (uint32_t)inc_edge },
+        { inc->vertices[inc_next], ref_id | (uint32_t)inc_next },
+    };
+
+    // Clip it to the reference face's side planes
+    Vector2 v11 = ref->vertices[ref_edge];
+    Vector2 v12 = ref->vertices[(ref_edge + 1) % ref->count];
+    Vector2 tangent = vec2_normalize(vec2_sub(v12, v11));
+
+    CollideVertex clip1[2];
+    CollideVertex clip2[2];
+    if (collide_clip(clip1, incident, vec2_negate(tangent), -vec2_dot(tangent, v11), 0) < 2 ||
+        collide_clip(clip2, clip1, tangent, vec2_dot(tangent, v12), 1) < 2)
+    {
+        return 0;
+    }
+
+    manifold->nx = flipped ? -n.x : n.x;
+    manifold->ny = flipped ? -n.y : n.y;
+
+    float front = vec2_dot(n, v11);
+    for (int i = 0; i < 2; ++i)
+    {
+        float separation = vec2_dot(n, clip2[i].v) - front;
+        if (separation <= margin)
+        {
+            // Halfway between the incident point and the reference face
+            Vector2 point = vec2_sub(clip2[i].v, vec2_scale(n, 0.5f * separation));
+            collide_add_point(manifold, pose_a, pose_b, point, separation, clip2[i].id | flipped);
+        }
+    }
+    return manifold->point_count;
+}
+
+/* ========================================================================== */
+/* DISPATCH                                                                   */
+/* ========================================================================== */
+
+/*
+ * Fills in the normal and points of a manifold for two posed shapes and
+ * returns the number of points, zero when they are further apart than the
+ * margin. Accumulated impulses start at zero.
+ */
+int collide_shapes(const BodyShape* shape_a, const BodyPose* pose_a,
+                   const BodyShape* shape_b, const BodyPose* pose_b,
+                   float margin, ContactManifold* manifold)
+{
+    manifold->point_count = 0;
+
+    bool circle_a = shape_a->type == BODY_SHAPE_CIRCLE;
+    bool circle_b = shape_b->type == BODY_SHAPE_CIRCLE;
+    if (circle_a && circle_b)
+    {
+        return collide_circles(shape_a, pose_a, shape_b, pose_b, margin, manifold);
+    }
+
+    if (circle_a || circle_b)
+    {
+        CollidePolygon poly;
+        collide_world_polygon(circle_a ? shape_b : shape_a, circle_a ? pose_b : pose_a, &poly);
+
+        const BodyPose* circle_pose = circle_a ? pose_a : pose_b;
+        float radius = circle_a ? shape_a->radius : shape_b->radius;
+
+        Vector2 n;
+        Vector2 point;
+        float separation;
+        if (!collide_polygon_circle(&poly, vec2_new(circle_pose->x, circle_pose->y), radius, margin,
+                                    &n, &point, &separation))
+        {
+            return 0;
+        }
+
+        // The normal came out pointing at the circle
+        if (circle_a)
+        {
+            n = vec2_negate(n);
+        }
+        manifold->nx = n.x;
+        manifold->ny = n.y;
+        collide_add_point(manifold, pose_a, pose_b, point, separation, 0);
+        return 1;
+    }
+
+    CollidePolygon poly_a;
+    CollidePolygon poly_b;
+    collide_world_polygon(shape_a, pose_a, &poly_a);
+    collide_world_polygon(shape_b, pose_b, &poly_b);
+    return collide_polygons(&poly_a, pose_a, &poly_b, pose_b, margin, manifold);
+}
@@ -0,0 +1,276 @@
+#include "common.h"
+#include "physics/contact.h"
+
+/*
+ * Sequential-impulse contact solver. Each point accumulates its impulse over
+ * the iterations and it is the total that gets clamped, not each
+ * increment. What a point ended the previous step with, kept by the contact
+ * cache, is applied up front (warm starting), so a resting stack starts
+ * every step close to its solution. The two points of a resting face are
+ * solved together as one 2x2 problem, since solving them one at a time
+ * leaves a small torque imbalance that tall stacks amplify until they
+ * topple. Iterations read and write only the manifolds and BodyVelocity.
+ */
+
+/* Condition number past which two points are solved one at a time instead */
+#define CONTACT_MAX_CONDITION 1000.0f
+
+/*
+ * Effective masses and target normal velocities for every point. Points
+ * still apart may close the gap within the step; overlapping ones are
+ * pushed out at a fraction of their depth beyond the slop, or bounced if
+ * they hit fast enough.
+ */
+void contact_prepare(ContactManifold* manifolds, int count, const BodyVelocity* velocity, float dt)
+{
+    float inv_dt = dt > 0.0f ? 1.0f / dt : 0.0f;
+
+    for (int i = 0; i < count; ++i)
+    {
+        ContactManifold* manifold = &manifolds[i];
+        const BodyVelocity* a = &velocity[manifold->a];
+        const BodyVelocity* b = &velocity[manifold->b];
+        float nx = manifold->nx;
+        float ny = manifold->ny;
+        float tx = ny;
+        float ty = -nx;
+        float inv_mass = a->inv_mass + b->inv_mass;
+
+        for (int p = 0; p < manifold->point_count; ++p)
+        {
+            ContactPoint* cp = &manifold->points[p];
+
+            float rna = cp->rax * ny - cp->ray * nx;
+            float rnb = cp->rbx * ny - cp->rby * nx;
+            float k_normal = inv_mass + a->inv_inertia * rna * rna + b->inv_inertia * rnb * rnb;
+            cp->normal_mass = k_normal > 0.0f ? 1.0f / k_normal : 0.0f;
+
+            float rta = cp->rax * ty - cp->ray * tx;
+            float rtb = cp->rbx * ty - cp->rby * tx;
+            float k_tangent = inv_mass + a->inv_inertia * rta * rta + b->inv_inertia * rtb * rtb;
+            cp->tangent_mass = k_tangent > 0.0f ? 1.0f / k_tangent : 0.0f;
+
+            if (cp->separation > 0.0f)
+            {
+                cp->bias = -cp->separation * inv_dt;
+            }
+            else
+            {
+                cp->bias = BODY_BAUMGARTE * inv_dt * MAX(-cp->separation - BODY_LINEAR_SLOP, 0.0f);
+            }
+
+            float dvx = b->vx - b->w * cp->rby - a->vx + a->w * cp->ray;
+            float dvy = b->vy + b->w * cp->rbx - a->vy - a->w * cp->rax;
+            float vn = dvx * nx + dvy * ny;
+            if (vn < -BODY_BOUNCE_THRESHOLD)
+            {
+                cp->bias = MAX(cp->bias, -manifold->restitution * vn);
+            }
+        }
+
+        manifold->block = false;
+        if (manifold->point_count == 2)
+        {
+            const ContactPoint* c1 = &manifold->points[0];
+            const ContactPoint* c2 = &manifold->points[1];
+            float rn1a = c1->rax * ny - c1->ray * nx;
+            float rn1b = c1->rbx * ny - c1->rby * nx;
+            float rn2a = c2->rax * ny - c2->ray * nx;
+            float rn2b = c2->rbx * ny - c2->rby * nx;
+
+            float k11 = inv_mass + a->inv_inertia * rn1a * rn1a + b->inv_inertia * rn1b * rn1b;
+            float k22 = inv_mass + a->inv_inertia * rn2a * rn2a + b->inv_inertia * rn2b * rn2b;
+            float k12 = inv_mass + a->inv_inertia * rn1a * rn2a + b->inv_inertia * rn1b * rn2b;
+            float det = k11 * k22 - k12 * k12;
+            if (k11 * k11 < CONTACT_MAX_CONDITION * det)
+            {
+                manifold->k11 = k11;
+                manifold->k12 = k12;
+                manifold->k22 = k22;
+                manifold->inv11 = k22 / det;
+                manifold->inv12 = -k12 / det;
+                manifold->inv22 = k11 / det;
+                manifold->block = true;
+            }
+        }
+    }
+}
+
+/* Applies the impulses the contact cache carried over from last step */
+void contact_warm_start(const ContactManifold* manifolds, int count, BodyVelocity* velocity)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        const ContactManifold* manifold = &manifolds[i];
+        BodyVelocity* a = &velocity[manifold->a];
+        BodyVelocity* b = &velocity[manifold->b];
+
+        for (int p = 0; p < manifold->point_count; ++p)
+        {
+            const ContactPoint* cp = &manifold->points[p];
+            float px = manifold->nx * cp->normal_impulse + manifold->ny * cp->tangent_impulse;
+            float py = manifold->ny * cp->normal_impulse - manifold->nx * cp->tangent_impulse;
+
+            a->vx -= a->inv_mass * px;
+            a->vy -= a->inv_mass * py;
+            a->w -= a->inv_inertia * (cp->rax * py - cp->ray * px);
+            b->vx += b->inv_mass * px;
+            b->vy += b->inv_mass * py;
+            b->w += b->inv_inertia * (cp->rbx * py - cp->rby * px);
+        }
+    }
+}
+
+/*
+ * Solves both normal impulses of a two-point manifold at once. The total
+ * impulses x must satisfy x >= 0, vn >= bias and (vn - bias) * x = 0 at each
+ * point; with two points there are only four cases, tried in turn: both
+ * touching, only the first, only the second, neither. If none fits, which
+ * only round-off allows, the impulses are left as they were.
+ */
+static void contact_solve_block(ContactManifold* manifold, float* vax, float* vay, float* wa,
+                                float* vbx, float* vby, float* wb, float ma, float ia, float mb, float ib)
+{
+    ContactPoint* c1 = &manifold->points[0];
+    ContactPoint* c2 = &manifold->points[1];
+    float nx = manifold->nx;
+    float ny = manifold->ny;
+
+    float dv1x = *vbx - *wb * c1->rby - *vax + *wa * c1->ray;
+    float dv1y = *vby + *wb * c1->rbx - *vay - *wa * c1->rax;
+    float dv2x = *vbx - *wb * c2->rby - *vax + *wa * c2->ray;
+    float dv2y = *vby + *wb * c2->rbx - *vay - *wa * c2->rax;
+
+    // b = vn - bias - K * a, with a the impulses so far
+    float a1 = c1->normal_impulse;
+    float a2 = c2->normal_impulse;
+    float b1 = dv1x * nx + dv1y * ny - c1->bias - (manifold->k11 * a1 + manifold->k12 * a2);
+    float b2 = dv2x * nx + dv2y * ny - c2->bias - (manifold->k12 * a1 + manifold->k22 * a2);
+
+    float x1;
+    float x2;
+    for (;;)
+    {
+        // Both points touching: vn = bias at each
+        x1 = -(manifold->inv11 * b1 + manifold->inv12 * b2);
+        x2 = -(manifold->inv12 * b1 + manifold->inv22 * b2);
+        if (x1 >= 0.0f && x2 >= 0.0f)
+        {
+            break;
+        }
+
+        // Only the first
+        x1 = -c1->normal_mass * b1;
+        x2 = 0.0f;
+        if (x1 >= 0.0f && manifold->k12 * x1 + b2 >= 0.0f)
+        {
+            break;
+        }
+
+        // Only the second
+        x1 = 0.0f;
+        x2 = -c2->normal_mass * b2;
+        if (x2 >= 0.0f && manifold->k12 * x2 + b1 >= 0.0f)
+        {
+            break;
+        }
+
+        // Neither
+        x1 = 0.0f;
+        x2 = 0.0f;
+        if (b1 >= 0.0f && b2 >= 0.0f)
+        {
+            break;
+        }
+        return;
+    }
+
+    float d1 = x1 - a1;
+    float d2 = x2 - a2;
+    c1->normal_impulse = x1;
+    c2->normal_impulse = x2;
+
+    float p1x = nx * d1, p1y = ny * d1;
+    float p2x = nx * d2, p2y = ny * d2;
+    *vax -= ma * (p1x + p2x);
+    *vay -= ma * (p1y + p2y);
+    *wa -= ia * (c1->rax * p1y - c1->ray * p1x + c2->rax * p2y - c2->ray * p2x);
+    *vbx += mb * (p1x + p2x);
+    *vby += mb * (p1y + p2y);
+    *wb += ib * (c1->rbx * p1y - c1->rby * p1x + c2->rbx * p2y - c2->rby * p2x);
+}
+
+/* One Gauss-Seidel pass: friction first, then the non-penetration impulse it is bounded by */
+void contact_solve(ContactManifold* manifolds, int count, BodyVelocity* velocity)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        ContactManifold* manifold = &manifolds[i];
+        BodyVelocity* a = &velocity[manifold->a];
+        BodyVelocity* b = &velocity[manifold->b];
+
+        // Work on locals; a and b are written back once per manifold
+        float vax = a->vx, vay = a->vy, wa = a->w;
+        float vbx = b->vx, vby = b->vy, wb = b->w;
+        float ma = a->inv_mass, ia = a->inv_inertia;
+        float mb = b->inv_mass, ib = b->inv_inertia;
+        float nx = manifold->nx;
+        float ny = manifold->ny;
+        float tx = ny;
+        float ty = -nx;
+
+        for (int p = 0; p < manifold->point_count; ++p)
+        {
+            ContactPoint* cp = &manifold->points[p];
+
+            float dvx = vbx - wb * cp->rby - vax + wa * cp->ray;
+            float dvy = vby + wb * cp->rbx - vay - wa * cp->rax;
+            float lambda = -cp->tangent_mass * (dvx * tx + dvy * ty);
+            float max_friction = manifold->friction * cp->normal_impulse;
+            float impulse = float_clamp(cp->tangent_impulse + lambda, -max_friction, max_friction);
+            lambda = impulse - cp->tangent_impulse;
+            cp->tangent_impulse = impulse;
+
+            float px = tx * lambda;
+            float py = ty * lambda;
+            vax -= ma * px;
+            vay -= ma * py;
+            wa -= ia * (cp->rax * py - cp->ray * px);
+            vbx += mb * px;
+            vby += mb * py;
+            wb += ib * (cp->rbx * py - cp->rby * px);
+        }
+
+        if (manifold->block)
+        {
+            contact_solve_block(manifold, &vax, &vay, &wa, &vbx, &vby, &wb, ma, ia, mb, ib);
+        }
+        for (int p = 0; p < manifold->point_count && !manifold->block; ++p)
+        {
+            ContactPoint* cp = &manifold->points[p];
+
+            float dvx = vbx - wb * cp->rby - vax + wa * cp->ray;
+            float dvy = vby + wb * cp->rbx - vay - wa * cp->rax;
+            float lambda = cp->normal_mass * (cp->bias - (dvx * nx + dvy * ny));
+            float impulse = MAX(cp->normal_impulse + lambda, 0.0f);
+            lambda = impulse - cp->normal_impulse;
+            cp->normal_impulse = impulse;
+
+            float px = nx * lambda;
+            float py = ny * lambda;
+            vax -= ma * px;
+            vay -= ma * py;
+            wa -= ia * (cp->rax * py - cp->ray * px);
+            vbx += mb * px;
+            vby += mb * py;
+            wb += ib * (cp->rbx * py - cp->rby * px);
+        }
+
+        a->vx = vax;
+        a->vy = vay;
+        a->w = wa;
+        b->vx = vbx;
+        b->vy = vby;
+        b->w = wb;
+    }
+}
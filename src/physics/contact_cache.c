@@ -0,0 +1,374 @@
+#include "common.h"
+#include "physics/contact_cache.h"
+#include "logging.h"
+#include "memory.h"
+
+/* Fibonacci hashing: the top bits of key times 2^32 / phi */
+static inline uint32_t contact_cache_home(const ContactCache* cache, uint32_t key)
+{
+    return (key * 2654435769u) >> cache->shift;
+}
+
+ContactCache* contact_cache_create(int max_pairs, int max_bodies)
+{
+    if (max_pairs <= 0 || max_bodies <= 0)
+    {
+        LOG_ERROR("contact_cache:create: Invalid capacity %d pairs, %d bodies", max_pairs, max_bodies);
+        return NULL;
+    }
+
+    // Never more than half full, so probe runs stay short and always end
+    uint32_t capacity = 16;
+    int bits = 4;
+    while (capacity < (uint32_t)max_pairs * 2)
+    {
+        capacity <<= 1;
+        bits++;
+    }
+
+    ContactCache* cache = (ContactCache*)pd_malloc(sizeof(ContactCache));
+    if (cache == NULL)
+    {
+        LOG_ERROR("contact_cache:create: Memory allocation failed");
+        return NULL;
+    }
+
+    // Every entry is reserved up front, so steps never reach the allocator
+    cache->slots = (ContactCacheSlot*)pd_malloc(sizeof(ContactCacheSlot) * capacity);
+    cache->entries = POOL_CREATE(ContactCacheEntry, max_pairs, max_pairs);
+    cache->body_entries = (ContactCacheEntry**)pd_calloc((size_t)max_bodies, sizeof(ContactCacheEntry*));
+    if (cache->slots == NULL || cache->entries == NULL || cache->body_entries == NULL ||
+        !pool_reserve(cache->entries, max_pairs))
+    {
+        LOG_ERROR("contact_cache:create: Failed to allocate %d entries", max_pairs);
+        pd_free(cache->slots);
+        pool_destroy(cache->entries);
+        pd_free(cache->body_entries);
+        pd_free(cache);
+        return NULL;
+    }
+
+    cache->mask = capacity - 1;
+    cache->shift = 32 - bits;
+    cache->max_count = max_pairs;
+    cache->max_bodies = max_bodies;
+    for (uint32_t i = 0; i < capacity; ++i)
+    {
+        cache->slots[i].key = CONTACT_CACHE_EMPTY;
+    }
+    contact_cache_clear(cache);
+
+    return cache;
+}
+
+void contact_cache_destroy(ContactCache* cache)
+{
+    if (cache != NULL)
+    {
+        pd_free(cache->slots);
+        pool_destroy(cache->entries);
+        pd_free(cache->body_entries);
+        pd_free(cache);
+    }
+}
+
+void contact_cache_clear(ContactCache* cache)
+{
+    for (uint32_t i = 0; i <= cache->mask; ++i)
+    {
+        ContactCacheSlot* slot = &cache->slots[i];
+        if (slot->key != CONTACT_CACHE_EMPTY)
+        {
+            pool_free(cache->entries, slot->entry);
+            slot->key = CONTACT_CACHE_EMPTY;
+        }
+    }
+    for (int i = 0; i < cache->max_bodies; ++i)
+    {
+        cache->body_entries[i] = NULL;
+    }
+    cache->count = 0;
+    cache->stamp = 0;
+    cache->lookups = 0;
+    cache->reused = 0;
+    cache->evictions = 0;
+}
+
+/* The handle at one end of a key: 0 for the lower, 1 for the higher */
+static inline uint32_t contact_cache_handle(uint32_t key, int end)
+{
+    return end == 0 ? key >> 16 : key & 0xFFFFu;
+}
+
+/* Which end of the entry's key a handle is */
+static inline int contact_cache_end(const ContactCacheEntry* entry, uint32_t handle)
+{
+    return entry->key >> 16 == handle ? 0 : 1;
+}
+
+/* Pushes the entry onto the lists of both its handles */
+static void contact_cache_link(ContactCache* cache, ContactCacheEntry* entry)
+{
+    for (int end = 0; end < 2; ++end)
+    {
+        uint32_t handle = contact_cache_handle(entry->key, end);
+        ContactCacheEntry* head = cache->body_entries[handle];
+        entry->prev[end] = NULL;
+        entry->next[end] = head;
+        if (head != NULL)
+        {
+            head->prev[contact_cache_end(head, handle)] = entry;
+        }
+        cache->body_entries[handle] = entry;
+    }
+}
+
+static void contact_cache_unlink(ContactCache* cache, ContactCacheEntry* entry)
+{
+    for (int end = 0; end < 2; ++end)
+    {
+        uint32_t handle = contact_cache_handle(entry->key, end);
+        ContactCacheEntry* prev = entry->prev[end];
+        ContactCacheEntry* next = entry->next[end];
+        if (prev != NULL)
+        {
+            prev->next[contact_cache_end(prev, handle)] = next;
+        }
+        else
+        {
+            cache->body_entries[handle] = next;
+        }
+        if (next != NULL)
+        {
+            next->prev[contact_cache_end(next, handle)] = prev;
+        }
+    }
+}
+
+/* Starts a step; only entries acquired from here on survive its eviction sweep */
+void contact_cache_begin(ContactCache* cache)
+{
+    cache->stamp++;
+}
+
+/*
+ * Finds or inserts the entry for a pair key and marks it live for this
+ * step. New entries start with an empty manifold and created set. Entries
+ * stay where they are until evicted, so the pointer holds for the step.
+ * Returns NULL when the cache is full.
+ */
+ContactCacheEntry* contact_cache_acquire(ContactCache* cache, uint32_t key, bool* created)
+{
+    cache->lookups++;
+
+    uint32_t index = contact_cache_home(cache, key);
+    for (;;)
+    {
+        ContactCacheSlot* slot = &cache->slots[index];
+        if (slot->key == key)
+        {
+            slot->entry->stamp = cache->stamp;
+            *created = false;
+            return slot->entry;
+        }
+        if (slot->key == CONTACT_CACHE_EMPTY)
+        {
+            break;
+        }
+        index = (index + 1) & cache->mask;
+    }
+
+    if (cache->count == cache->max_count)
+    {
+        return NULL;
+    }
+
+    ContactCacheEntry* entry = POOL_ALLOC(cache->entries, ContactCacheEntry);
+    entry->key = key;
+    entry->stamp = cache->stamp;
+    entry->manifold.point_count = 0;
+    cache->slots[index].key = key;
+    cache->slots[index].entry = entry;
+    contact_cache_link(cache, entry);
+    cache->count++;
+    *created = true;
+    return entry;
+}
+
+/* Pose of b in a's frame */
+static void contact_cache_relative(const BodyPose* pose_a, const BodyPose* pose_b, Vector2* relative, float* angle)
+{
+    Vector2 d = vec2_new(pose_b->x - pose_a->x, pose_b->y - pose_a->y);
+    *relative = vec2_new(pose_a->c * d.x + pose_a->s * d.y, pose_a->c * d.y - pose_a->s * d.x);
+    *angle = pose_b->angle - pose_a->angle;
+}
+
+/*
+ * While b has not moved relative to a since the manifold was computed, the
+ * pair has only undergone a rigid motion, and the manifold stays valid once
+ * its normal and anchors are turned by however far a has turned. Returns
+ * false when the narrowphase has to run again.
+ */
+bool contact_cache_reuse(ContactCacheEntry* entry, const BodyPose* pose_a, const BodyPose* pose_b)
+{
+    Vector2 relative;
+    float angle;
+    contact_cache_relative(pose_a, pose_b, &relative, &angle);
+    if (fabsf(relative.x - entry->relative.x) > CONTACT_CACHE_LINEAR_TOL ||
+        fabsf(relative.y - entry->relative.y) > CONTACT_CACHE_LINEAR_TOL ||
+        fabsf(angle - entry->relative_angle) > CONTACT_CACHE_ANGULAR_TOL)
+    {
+        return false;
+    }
+
+    float turn = pose_a->angle - entry->angle_a;
+    if (turn != 0.0f)
+    {
+        float s;
+        float c;
+        VECTOR_SINCOSF(turn, &s, &c);
+
+        ContactManifold* manifold = &entry->manifold;
+        float nx = manifold->nx;
+        manifold->nx = c * nx - s * manifold->ny;
+        manifold->ny = s * nx + c * manifold->ny;
+        for (int p = 0; p < manifold->point_count; ++p)
+        {
+            ContactPoint* cp = &manifold->points[p];
+            float rax = cp->rax;
+            float rbx = cp->rbx;
+            cp->rax = c * rax - s * cp->ray;
+            cp->ray = s * rax + c * cp->ray;
+            cp->rbx = c * rbx - s * cp->rby;
+            cp->rby = s * rbx + c * cp->rby;
+        }
+        entry->angle_a = pose_a->angle;
+    }
+    return true;
+}
+
+/*
+ * Replaces the entry's manifold with one fresh from the narrowphase. Points
+ * whose feature id was already there keep their accumulated impulses.
+ */
+void contact_cache_update(ContactCacheEntry* entry, const ContactManifold* manifold,
+                          const BodyPose* pose_a, const BodyPose* pose_b)
+{
+    ContactManifold fresh = *manifold;
+    const ContactManifold* old = &entry->manifold;
+    for (int p = 0; p < fresh.point_count; ++p)
+    {
+        ContactPoint* cp = &fresh.points[p];
+        for (int q = 0; q < old->point_count; ++q)
+        {
+            if (old->points[q].id == cp->id)
+            {
+                cp->normal_impulse = old->points[q].normal_impulse;
+                cp->tangent_impulse = old->points[q].tangent_impulse;
+                break;
+            }
+        }
+    }
+
+    entry->manifold = fresh;
+    contact_cache_relative(pose_a, pose_b, &entry->relative, &entry->relative_angle);
+    entry->angle_a = pose_a->angle;
+}
+
+/* Writes the solved impulses back to the entries the manifolds were copied from */
+void contact_cache_store_impulses(const ContactManifold* manifolds, ContactCacheEntry* const* entries, int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        if (entries[i] == NULL)
+        {
+            continue;
+        }
+
+        ContactManifold* cached = &entries[i]->manifold;
+        for (int p = 0; p < manifolds[i].point_count; ++p)
+        {
+            cached->points[p].normal_impulse = manifolds[i].points[p].normal_impulse;
+            cached->points[p].tangent_impulse = manifolds[i].points[p].tangent_impulse;
+        }
+    }
+}
+
+/*
+ * Backward-shift deletion: later members of the probe run are pulled into
+ * the hole unless their home slot lies cyclically after it, so lookups never
+ * stop early at a gap and no tombstones are needed.
+ */
+static void contact_cache_remove_at(ContactCache* cache, uint32_t hole)
+{
+    ContactCacheSlot* slots = cache->slots;
+    pool_free(cache->entries, slots[hole].entry);
+
+    uint32_t j = hole;
+    for (;;)
+    {
+        j = (j + 1) & cache->mask;
+        if (slots[j].key == CONTACT_CACHE_EMPTY)
+        {
+            break;
+        }
+
+        uint32_t home = contact_cache_home(cache, slots[j].key);
+        bool stays = hole <= j ? (hole < home && home <= j) : (hole < home || home <= j);
+        if (!stays)
+        {
+            slots[hole] = slots[j];
+            hole = j;
+        }
+    }
+
+    slots[hole].key = CONTACT_CACHE_EMPTY;
+    cache->count--;
+}
+
+/* Table slot of a key that is in the table */
+static uint32_t contact_cache_find(const ContactCache* cache, uint32_t key)
+{
+    uint32_t index = contact_cache_home(cache, key);
+    while (cache->slots[index].key != key)
+    {
+        index = (index + 1) & cache->mask;
+    }
+    return index;
+}
+
+static void contact_cache_remove(ContactCache* cache, ContactCacheEntry* entry)
+{
+    contact_cache_unlink(cache, entry);
+    contact_cache_remove_at(cache, contact_cache_find(cache, entry->key));
+}
+
+/*
+ * Drops the entries of one body that were not acquired this step. The body
+ * world calls this for each awake body as a step ends; entries between two
+ * sleeping or static bodies are never looked at, since neither body can
+ * have moved.
+ */
+void contact_cache_evict(ContactCache* cache, uint32_t handle)
+{
+    ContactCacheEntry* entry = cache->body_entries[handle];
+    while (entry != NULL)
+    {
+        ContactCacheEntry* next = entry->next[contact_cache_end(entry, handle)];
+        if (entry->stamp != cache->stamp)
+        {
+            contact_cache_remove(cache, entry);
+            cache->evictions++;
+        }
+        entry = next;
+    }
+}
+
+/* Drops every entry of a handle, as its body leaves the world */
+void contact_cache_forget(ContactCache* cache, uint32_t handle)
+{
+    while (cache->body_entries[handle] != NULL)
+    {
+        contact_cache_remove(cache, cache->body_entries[handle]);
+    }
+}
@@ -0,0 +1,406 @@
+#include "common.h"
+#include "physics/force.h"
+#include "physics/particle.h"
+#include "logging.h"
+#include "memory.h"
+
+ForceRegistry* force_registry_create(int max_particles, int max_fields, int max_springs)
+{
+    if (max_particles <= 0 || max_fields < 0 || max_springs < 0)
+    {
+        LOG_ERROR("force:create: Invalid parameters");
+        return NULL;
+    }
+
+    ForceRegistry* registry = (ForceRegistry*)pd_calloc(1, sizeof(ForceRegistry));
+    if (registry == NULL)
+    {
+        LOG_ERROR("force:create: Memory allocation failed");
+        return NULL;
+    }
+
+    registry->max_particles = max_particles;
+    registry->max_fields = max_fields;
+    registry->max_springs = max_springs;
+
+    size_t fields = (size_t)MAX(max_fields, 1);
+    size_t springs = (size_t)MAX(max_springs, 1);
+
+    registry->fields = (ForceField*)pd_malloc(sizeof(ForceField) * fields);
+    registry->field_active = (bool*)pd_malloc(sizeof(bool) * fields);
+    registry->spring_a = (ParticleHandle*)pd_malloc(sizeof(ParticleHandle) * springs);
+    registry->spring_b = (ParticleHandle*)pd_malloc(sizeof(ParticleHandle) * springs);
+    registry->spring_rest = (float*)pd_malloc(sizeof(float) * springs);
+    registry->spring_stiffness = (float*)pd_malloc(sizeof(float) * springs);
+    registry->spring_damping = (float*)pd_malloc(sizeof(float) * springs);
+    registry->spring_index_a = (uint32_t*)pd_malloc(sizeof(uint32_t) * springs);
+    registry->spring_index_b = (uint32_t*)pd_malloc(sizeof(uint32_t) * springs);
+    registry->spring_fx = (float*)pd_malloc(sizeof(float) * springs);
+    registry->spring_fy = (float*)pd_malloc(sizeof(float) * springs);
+    registry->mass = (float*)pd_malloc(sizeof(float) * (size_t)max_particles);
+
+    if (registry->fields == NULL || registry->field_active == NULL || registry->spring_a == NULL ||
+        registry->spring_b == NULL || registry->spring_rest == NULL || registry->spring_stiffness == NULL ||
+        registry->spring_damping == NULL || registry->spring_index_a == NULL || registry->spring_index_b == NULL ||
+        registry->spring_fx == NULL || registry->spring_fy == NULL || registry->mass == NULL)
+    {
+        LOG_ERROR("force:create: Failed to allocate generator storage");
+        force_registry_destroy(registry);
+        return NULL;
+    }
+
+    force_registry_clear(registry);
+    return registry;
+}
+
+void force_registry_destroy(ForceRegistry* registry)
+{
+    if (registry != NULL)
+    {
+        pd_free(registry->fields);
+        pd_free(registry->field_active);
+        pd_free(registry->spring_a);
+        pd_free(registry->spring_b);
+        pd_free(registry->spring_rest);
+        pd_free(registry->spring_stiffness);
+        pd_free(registry->spring_damping);
+        pd_free(registry->spring_index_a);
+        pd_free(registry->spring_index_b);
+        pd_free(registry->spring_fx);
+        pd_free(registry->spring_fy);
+        pd_free(registry->mass);
+        pd_free(registry);
+    }
+}
+
+void force_registry_clear(ForceRegistry* registry)
+{
+    registry->field_count = 0;
+    registry->spring_count = 0;
+    registry->dirty = true;
+}
+
+/* === FIELDS === */
+
+ForceField force_gravity(Vector2 acceleration)
+{
+    ForceField field;
+    memset(&field, 0, sizeof(field));
+    field.kind = FORCE_GRAVITY;
+    field.vector = acceleration;
+    return field;
+}
+
+/* Drag force of linear * speed + quadratic * speed^2, against the velocity */
+ForceField force_drag(float linear, float quadratic)
+{
+    ForceField field;
+    memset(&field, 0, sizeof(field));
+    field.kind = FORCE_DRAG;
+    field.linear = linear;
+    field.quadratic = quadratic;
+    return field;
+}
+
+/* A force of coefficient * (velocity - particle velocity): drag in moving air */
+ForceField force_wind(Vector2 velocity, float coefficient)
+{
+    ForceField field;
+    memset(&field, 0, sizeof(field));
+    field.kind = FORCE_WIND;
+    field.vector = velocity;
+    field.linear = coefficient;
+    return field;
+}
+
+/*
+ * Pulls towards center with an acceleration of strength there, fading to
+ * nothing at radius; a negative strength pushes away instead. Applied as a
+ * force, like gravity, so heavy and light particles respond alike.
+ */
+ForceField force_attractor(Vector2 center, float radius, float strength, ForceFalloff falloff)
+{
+    ForceField field;
+    memset(&field, 0, sizeof(field));
+    field.kind = FORCE_ATTRACTOR;
+    field.vector = center;
+    field.radius = radius;
+    field.strength = strength;
+    field.falloff = falloff;
+    field.count = -1;
+    return field;
+}
+
+/* Registers a field in the first free slot; the id stays valid until it is removed */
+int force_add_field(ForceRegistry* registry, const ForceField* field)
+{
+    int slot = 0;
+    while (slot < registry->field_count && registry->field_active[slot])
+    {
+        slot++;
+    }
+    if (slot == registry->max_fields)
+    {
+        LOG_WARNING("force fields full (capacity: %d)", registry->max_fields);
+        return -1;
+    }
+
+    registry->fields[slot] = *field;
+    registry->field_active[slot] = true;
+    registry->field_count = MAX(registry->field_count, slot + 1);
+    return slot;
+}
+
+void force_remove_field(ForceRegistry* registry, int field)
+{
+    if (field >= 0 && field < registry->field_count)
+    {
+        registry->field_active[field] = false;
+    }
+}
+
+/* The field behind an id, to be changed in place (an attractor following the crank), or NULL */
+ForceField* force_get_field(ForceRegistry* registry, int field)
+{
+    if (field < 0 || field >= registry->field_count || !registry->field_active[field])
+    {
+        return NULL;
+    }
+    return &registry->fields[field];
+}
+
+/* === SPRINGS === */
+
+/*
+ * Adds a damped spring resting at the particles' current distance. Returns
+ * its slot, or -1. A spring goes away with either of its particles and the
+ * ones after it move down, so the slot only stays valid until a particle
+ * is removed; springs are meant to be owned through their particles.
+ */
+int force_add_spring(ForceRegistry* registry, const ParticleWorld* world, ParticleHandle a, ParticleHandle b,
+                     float stiffness, float damping)
+{
+    int ia = particle_world_index(world, a);
+    int ib = particle_world_index(world, b);
+    if (ia < 0 || ib < 0 || ia == ib)
+    {
+        LOG_WARNING("invalid particle pair %u, %u", (unsigned)a, (unsigned)b);
+        return -1;
+    }
+    if (registry->spring_count == registry->max_springs)
+    {
+        LOG_WARNING("springs full (capacity: %d)", registry->max_springs);
+        return -1;
+    }
+
+    int spring = registry->spring_count++;
+    registry->spring_a[spring] = a;
+    registry->spring_b[spring] = b;
+    registry->spring_rest[spring] = vec2_distance(vec2_new(world->x[ia], world->y[ia]),
+                                                  vec2_new(world->x[ib], world->y[ib]));
+    registry->spring_stiffness[spring] = MAX(stiffness, 0.0f);
+    registry->spring_damping[spring] = MAX(damping, 0.0f);
+    registry->dirty = true;
+
+    return spring;
+}
+
+/* Drops springs on removed particles and resolves the rest to dense indices */
+static void force_prepare_springs(ForceRegistry* registry, const ParticleWorld* world)
+{
+    int kept = 0;
+    for (int i = 0; i < registry->spring_count; ++i)
+    {
+        int ia = particle_world_index(world, registry->spring_a[i]);
+        int ib = particle_world_index(world, registry->spring_b[i]);
+        if (ia >= 0 && ib >= 0)
+        {
+            registry->spring_a[kept] = registry->spring_a[i];
+            registry->spring_b[kept] = registry->spring_b[i];
+            registry->spring_rest[kept] = registry->spring_rest[i];
+            registry->spring_stiffness[kept] = registry->spring_stiffness[i];
+            registry->spring_damping[kept] = registry->spring_damping[i];
+            registry->spring_index_a[kept] = (uint32_t)ia;
+            registry->spring_index_b[kept] = (uint32_t)ib;
+            kept++;
+        }
+    }
+    registry->spring_count = kept;
+
+    registry->dirty = false;
+    registry->world_revision = world->revision;
+}
+
+/* === PASSES === */
+
+/*
+ * Every uniform field at once: gravity, drag and wind fold into
+ * mass * gravity + push - (linear + quadratic * speed) * velocity, with the
+ * sums taken over all registered fields before the loop. Also records each
+ * particle's mass for the attractor passes. Immovable particles get a mass
+ * of zero, masked arithmetically like pbd.c's degenerate constraints.
+ */
+static void force_uniform_kernel(const float* restrict vx, const float* restrict vy,
+                                 const float* restrict inv_mass, float* restrict mass,
+                                 float* restrict fx, float* restrict fy, int count,
+                                 float gravity_x, float gravity_y, float push_x, float push_y,
+                                 float linear, float quadratic)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        float movable = (float)(inv_mass[i] > 0.0f);
+        float m = movable / (inv_mass[i] + (1.0f - movable));
+        float speed = sqrtf(vx[i] * vx[i] + vy[i] * vy[i]);
+        float k = linear + quadratic * speed;
+
+        mass[i] = m;
+        fx[i] += m * gravity_x + push_x - k * vx[i];
+        fy[i] += m * gravity_y + push_y - k * vy[i];
+    }
+}
+
+/*
+ * One attractor. The falloff is c0 + c1 * t + c2 * t^2 over
+ * t = 1 - distance / radius, masked to zero outside the radius, so every
+ * falloff shares this loop; the direction is taken against a floored
+ * distance so a particle at the centre gets no force rather than a NaN.
+ */
+static void force_attractor_kernel(const float* restrict x, const float* restrict y,
+                                   const float* restrict mass, float* restrict fx, float* restrict fy,
+                                   int count, float center_x, float center_y, float inv_radius,
+                                   float strength, float c0, float c1, float c2)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        float dx = center_x - x[i];
+        float dy = center_y - y[i];
+        float distance = sqrtf(dx * dx + dy * dy);
+        float t = 1.0f - distance * inv_radius;
+        float inside = (float)(t > 0.0f);
+        float falloff = inside * (c0 + (c1 + c2 * t) * t);
+        float s = strength * falloff * mass[i] / MAX(distance, VECTOR_EPSILON);
+
+        fx[i] += dx * s;
+        fy[i] += dy * s;
+    }
+}
+
+/* Spring forces along each spring's axis: stiffness on the stretch, damping on the closing speed */
+static void force_spring_kernel(const float* restrict x, const float* restrict y,
+                                const float* restrict vx, const float* restrict vy,
+                                const uint32_t* restrict a, const uint32_t* restrict b,
+                                const float* restrict rest, const float* restrict stiffness,
+                                const float* restrict damping, float* restrict out_x, float* restrict out_y,
+                                int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        uint32_t ia = a[i];
+        uint32_t ib = b[i];
+        float dx = x[ib] - x[ia];
+        float dy = y[ib] - y[ia];
+        float length = sqrtf(dx * dx + dy * dy);
+        float valid = (float)(length > VECTOR_EPSILON);
+        float inv_length = valid / (length + (1.0f - valid));
+        float nx = dx * inv_length;
+        float ny = dy * inv_length;
+
+        float closing = (vx[ib] - vx[ia]) * nx + (vy[ib] - vy[ia]) * ny;
+        float magnitude = stiffness[i] * (length - rest[i]) + damping[i] * closing;
+        out_x[i] = magnitude * nx;
+        out_y[i] = magnitude * ny;
+    }
+}
+
+/*
+ * Accumulates every registered generator into the world's force arrays,
+ * ahead of particle_world_integrate. Each kind is its own branch-free pass
+ * over the arrays, so adding a field costs at most one more linear pass and
+ * never a test per particle.
+ */
+void force_registry_apply(ForceRegistry* registry, ParticleWorld* world)
+{
+    int count = world->count;
+    if (count > registry->max_particles)
+    {
+        LOG_WARNING("world has %d particles, force registry was sized for %d", count, registry->max_particles);
+        count = registry->max_particles;
+    }
+
+    // Fold the uniform fields into one set of coefficients
+    Vector2 gravity = VEC2_ZERO;
+    Vector2 push = VEC2_ZERO;
+    float linear = 0.0f;
+    float quadratic = 0.0f;
+    for (int i = 0; i < registry->field_count; ++i)
+    {
+        const ForceField* field = &registry->fields[i];
+        if (!registry->field_active[i])
+        {
+            continue;
+        }
+        switch (field->kind)
+        {
+            case FORCE_GRAVITY:
+                gravity = vec2_add(gravity, field->vector);
+                break;
+            case FORCE_DRAG:
+                linear += field->linear;
+                quadratic += field->quadratic;
+                break;
+            case FORCE_WIND:
+                push = vec2_add(push, vec2_scale(field->vector, field->linear));
+                linear += field->linear;
+                break;
+            case FORCE_ATTRACTOR:
+                break;
+        }
+    }
+
+    force_uniform_kernel(world->vx, world->vy, world->inv_mass, registry->mass, world->fx, world->fy, count,
+                         gravity.x, gravity.y, push.x, push.y, linear, quadratic);
+
+    for (int i = 0; i < registry->field_count; ++i)
+    {
+        const ForceField* field = &registry->fields[i];
+        if (!registry->field_active[i] || field->kind != FORCE_ATTRACTOR || field->radius <= 0.0f ||
+            field->strength == 0.0f)
+        {
+            continue;
+        }
+
+        int first = MIN(MAX(field->first, 0), count);
+        int end = field->count < 0 ? count : MIN(first + field->count, count);
+
+        float c0 = field->falloff == FORCE_FALLOFF_NONE ? 1.0f : 0.0f;
+        float c1 = field->falloff == FORCE_FALLOFF_LINEAR ? 1.0f : 0.0f;
+        float c2 = field->falloff == FORCE_FALLOFF_QUADRATIC ? 1.0f : 0.0f;
+        force_attractor_kernel(world->x + first, world->y + first, registry->mass + first, world->fx + first,
+                               world->fy + first, end - first, field->vector.x, field->vector.y, 1.0f / field->radius,
+                               field->strength, c0, c1, c2);
+    }
+
+    if (registry->spring_count == 0)
+    {
+        return;
+    }
+    if (registry->dirty || registry->world_revision != world->revision)
+    {
+        force_prepare_springs(registry, world);
+    }
+
+    // Forces are computed for all springs in one pass, then scattered, since
+    // springs sharing a particle would collide in a vectorized accumulate
+    force_spring_kernel(world->x, world->y, world->vx, world->vy, registry->spring_index_a, registry->spring_index_b,
+                        registry->spring_rest, registry->spring_stiffness, registry->spring_damping,
+                        registry->spring_fx, registry->spring_fy, registry->spring_count);
+    for (int i = 0; i < registry->spring_count; ++i)
+    {
+        uint32_t ia = registry->spring_index_a[i];
+        uint32_t ib = registry->spring_index_b[i];
+        world->fx[ia] += registry->spring_fx[i];
+        world->fy[ia] += registry->spring_fy[i];
+        world->fx[ib] -= registry->spring_fx[i];
+        world->fy[ib] -= registry->spring_fy[i];
+    }
+}
@@ -0,0 +1,373 @@
+#include "common.h"
+#include "physics/particle.h"
+#include "physics/fixed.h"
+#include "logging.h"
+#include "memory.h"
+#include "debug_draw.h"
+
+/* Number of per-particle float arrays carved out of the world's block */
+#define PARTICLE_FLOAT_ARRAYS 9
+
+/* Keep every array 16-byte aligned so the integrator loop vectorizes cleanly */
+static int particle_round_capacity(int capacity)
+{
+    return (capacity + 3) & ~3;
+}
+
+ParticleWorld* particle_world_create(int capacity)
+{
+    if (capacity <= 0)
+    {
+        LOG_ERROR("particle:create: Invalid capacity %d", capacity);
+        return NULL;
+    }
+
+    ParticleWorld* world = (ParticleWorld*)pd_malloc(sizeof(ParticleWorld));
+    if (world == NULL)
+    {
+        LOG_ERROR("particle:create: Memory allocation failed");
+        return NULL;
+    }
+
+    // All arrays live in a single block: one allocation, no fragmentation
+    int stride = particle_round_capacity(capacity);
+    size_t float_bytes = (size_t)stride * sizeof(float);
+    size_t index_bytes = (size_t)stride * sizeof(uint32_t);
+    uint8_t* block = (uint8_t*)pd_malloc(float_bytes * PARTICLE_FLOAT_ARRAYS + index_bytes * 3);
+    if (block == NULL)
+    {
+        LOG_ERROR("particle:create: Failed to allocate storage for %d particles", capacity);
+        pd_free(world);
+        return NULL;
+    }
+
+    world->x = (float*)(block + float_bytes * 0);
+    world->y = (float*)(block + float_bytes * 1);
+    world->vx = (float*)(block + float_bytes * 2);
+    world->vy = (float*)(block + float_bytes * 3);
+    world->fx = (float*)(block + float_bytes * 4);
+    world->fy = (float*)(block + float_bytes * 5);
+    world->inv_mass = (float*)(block + float_bytes * 6);
+    world->prev_x = (float*)(block + float_bytes * 7);
+    world->prev_y = (float*)(block + float_bytes * 8);
+
+    uint8_t* indices = block + float_bytes * PARTICLE_FLOAT_ARRAYS;
+    world->handle_to_index = (uint32_t*)(indices + index_bytes * 0);
+    world->index_to_handle = (ParticleHandle*)(indices + index_bytes * 1);
+    world->free_handles = (ParticleHandle*)(indices + index_bytes * 2);
+
+    world->capacity = capacity;
+    world->revision = 0;
+    particle_world_clear(world);
+
+    return world;
+}
+
+void particle_world_destroy(ParticleWorld* world)
+{
+    if (world != NULL)
+    {
+        // x is the start of the shared block
+        pd_free(world->x);
+        pd_free(world);
+    }
+}
+
+void particle_world_clear(ParticleWorld* world)
+{
+    world->count = 0;
+    world->revision++;
+
+    // Hand out low handles first so a fresh world fills its tables in order
+    world->free_count = world->capacity;
+    for (int i = 0; i < world->capacity; ++i)
+    {
+        world->free_handles[i] = (ParticleHandle)(world->capacity - 1 - i);
+        world->handle_to_index[i] = PARTICLE_INVALID_HANDLE;
+    }
+}
+
+ParticleHandle particle_world_add(ParticleWorld* world, const Particle* particle)
+{
+    if (world->free_count == 0)
+    {
+        LOG_WARNING("particle world is full (capacity: %d)", world->capacity);
+        return PARTICLE_INVALID_HANDLE;
+    }
+
+    ParticleHandle handle = world->free_handles[--world->free_count];
+    int index = world->count++;
+    world->revision++;
+
+    world->handle_to_index[handle] = (uint32_t)index;
+    world->index_to_handle[index] = handle;
+
+    // A zero mass marks an immovable particle
+    float inv_mass = particle->mass > VECTOR_EPSILON ? 1.0f / particle->mass : 0.0f;
+
+    world->x[index] = particle->position.x;
+    world->y[index] = particle->position.y;
+    world->prev_x[index] = particle->position.x;
+    world->prev_y[index] = particle->position.y;
+    world->vx[index] = particle->velocity.x;
+    world->vy[index] = particle->velocity.y;
+    world->fx[index] = particle->acceleration.x * particle->mass;
+    world->fy[index] = particle->acceleration.y * particle->mass;
+    world->inv_mass[index] = inv_mass;
+
+    return handle;
+}
+
+void particle_world_remove(ParticleWorld* world, ParticleHandle handle)
+{
+    int index = particle_world_index(world, handle);
+    if (index < 0)
+    {
+        LOG_WARNING("stale particle handle %u", (unsigned)handle);
+        return;
+    }
+
+    // Swap the last live particle into the hole to keep storage dense
+    int last = --world->count;
+    world->revision++;
+    if (index != last)
+    {
+        world->x[index] = world->x[last];
+        world->y[index] = world->y[last];
+        world->prev_x[index] = world->prev_x[last];
+        world->prev_y[index] = world->prev_y[last];
+        world->vx[index] = world->vx[last];
+        world->vy[index] = world->vy[last];
+        world->fx[index] = world->fx[last];
+        world->fy[index] = world->fy[last];
+        world->inv_mass[index] = world->inv_mass[last];
+
+        ParticleHandle moved = world->index_to_handle[last];
+        world->index_to_handle[index] = moved;
+        world->handle_to_index[moved] = (uint32_t)index;
+    }
+
+    world->handle_to_index[handle] = PARTICLE_INVALID_HANDLE;
+    world->free_handles[world->free_count++] = handle;
+}
+
+/*
+ * Rebuilds the handle table and free list after count particles and their
+ * index_to_handle entries were written in directly, as a snapshot load does.
+ * Forces and interpolation start over. Returns false, leaving the world
+ * empty, if the handles are out of range or repeated.
+ */
+bool particle_world_reindex(ParticleWorld* world, int count)
+{
+    world->revision++;
+    for (int i = 0; i < world->capacity; ++i)
+    {
+        world->handle_to_index[i] = PARTICLE_INVALID_HANDLE;
+    }
+
+    if (count < 0 || count > world->capacity)
+    {
+        LOG_WARNING("invalid particle count %d", count);
+        particle_world_clear(world);
+        return false;
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+        ParticleHandle handle = world->index_to_handle[i];
+        if (handle >= (ParticleHandle)world->capacity || world->handle_to_index[handle] != PARTICLE_INVALID_HANDLE)
+        {
+            LOG_WARNING("invalid particle handle table");
+            particle_world_clear(world);
+            return false;
+        }
+        world->handle_to_index[handle] = (uint32_t)i;
+        world->prev_x[i] = world->x[i];
+        world->prev_y[i] = world->y[i];
+        world->fx[i] = 0.0f;
+        world->fy[i] = 0.0f;
+    }
+    world->count = count;
+
+    // Same order as a fresh world: the lowest free handle goes out first
+    world->free_count = 0;
+    for (int handle = world->capacity - 1; handle >= 0; --handle)
+    {
+        if (world->handle_to_index[handle] == PARTICLE_INVALID_HANDLE)
+        {
+            world->free_handles[world->free_count++] = (ParticleHandle)handle;
+        }
+    }
+    return true;
+}
+
+bool particle_world_get(const ParticleWorld* world, ParticleHandle handle, Particle* out)
+{
+    int index = particle_world_index(world, handle);
+    if (index < 0)
+    {
+        return false;
+    }
+
+    float inv_mass = world->inv_mass[index];
+    out->position = vec2_new(world->x[index], world->y[index]);
+    out->velocity = vec2_new(world->vx[index], world->vy[index]);
+    out->acceleration = vec2_scale(vec2_new(world->fx[index], world->fy[index]), inv_mass);
+    out->mass = inv_mass > 0.0f ? 1.0f / inv_mass : 0.0f;
+    return true;
+}
+
+void particle_world_apply_force(ParticleWorld* world, ParticleHandle handle, Vector2 force)
+{
+    int index = particle_world_index(world, handle);
+    if (index >= 0)
+    {
+        world->fx[index] += force.x;
+        world->fy[index] += force.y;
+    }
+}
+
+#ifndef PLAYSICS_FIXED_POINT
+/*
+ * Single fused pass so each array is streamed once per step. The arrays are
+ * taken as restrict parameters rather than restrict locals: GCC only trusts
+ * the former, and without it the loop does not vectorize.
+ */
+static void particle_integrate_kernel(float* restrict x, float* restrict y,
+                                      float* restrict prev_x, float* restrict prev_y,
+                                      float* restrict vx, float* restrict vy,
+                                      float* restrict fx, float* restrict fy,
+                                      const float* restrict inv_mass, int count, float dt)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        prev_x[i] = x[i];
+        prev_y[i] = y[i];
+
+        float scale = inv_mass[i] * dt;
+        vx[i] += fx[i] * scale;
+        vy[i] += fy[i] * scale;
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+        fx[i] = 0.0f;
+        fy[i] = 0.0f;
+    }
+}
+#endif
+
+/*
+ * Semi-implicit Euler over the whole world; clears the force accumulators.
+ * The pre-step positions are kept for render interpolation.
+ */
+void particle_world_integrate(ParticleWorld* world, float dt)
+{
+#ifdef PLAYSICS_FIXED_POINT
+    particle_world_integrate_fixed(world, dt);
+#else
+    particle_integrate_kernel(world->x, world->y, world->prev_x, world->prev_y,
+                              world->vx, world->vy, world->fx, world->fy,
+                              world->inv_mass, world->count, dt);
+#endif
+}
+
+/*
+ * Same step as particle_world_integrate, computed in Q16.16. Each particle is
+ * quantized, stepped with integer arithmetic only and written back; the
+ * float <-> fixed conversions are exact IEEE operations, so this step is
+ * bit-identical on every target. Only this step: forces, collisions,
+ * constraints and bodies stay in float. PLAYSICS_FIXED_POINT makes this the
+ * engine's integrator, and also keeps those float stages to arithmetic that
+ * rounds the same on every target (no contraction, no libm trig or powf).
+ */
+void particle_world_integrate_fixed(ParticleWorld* world, float dt)
+{
+    const Fixed fixed_dt = fixed_from_float(dt);
+    const int count = world->count;
+
+    for (int i = 0; i < count; ++i)
+    {
+        FixedVector2 position = fxvec2_new(fixed_from_float(world->x[i]), fixed_from_float(world->y[i]));
+        FixedVector2 velocity = fxvec2_new(fixed_from_float(world->vx[i]), fixed_from_float(world->vy[i]));
+        FixedVector2 force = fxvec2_new(fixed_from_float(world->fx[i]), fixed_from_float(world->fy[i]));
+        Fixed scale = fixed_mul(fixed_from_float(world->inv_mass[i]), fixed_dt);
+
+        velocity = fxvec2_add(velocity, fxvec2_scale(force, scale));
+        FixedVector2 next = fxvec2_add(position, fxvec2_scale(velocity, fixed_dt));
+
+        world->prev_x[i] = fixed_to_float(position.x);
+        world->prev_y[i] = fixed_to_float(position.y);
+        world->x[i] = fixed_to_float(next.x);
+        world->y[i] = fixed_to_float(next.y);
+        world->vx[i] = fixed_to_float(velocity.x);
+        world->vy[i] = fixed_to_float(velocity.y);
+        world->fx[i] = 0.0f;
+        world->fy[i] = 0.0f;
+    }
+}
+
+/* FNV-1a over the bit patterns of every live particle's position and velocity */
+uint32_t particle_world_hash(const ParticleWorld* world)
+{
+    const float* arrays[4] = { world->x, world->y, world->vx, world->vy };
+    uint32_t hash = 2166136261u;
+
+    for (int a = 0; a < 4; ++a)
+    {
+        const uint8_t* bytes = (const uint8_t*)arrays[a];
+        size_t size = sizeof(float) * (size_t)world->count;
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+/*
+ * Resolves overlapping particle pairs from the broadphase: pushes each pair
+ * apart along the contact normal, weighted by inverse mass, and removes the
+ * approaching part of their relative velocity.
+ */
+void particle_world_collide(ParticleWorld* world, const BroadphasePair* pairs, int pair_count, float radius)
+{
+    float* restrict x = world->x;
+    float* restrict y = world->y;
+    float* restrict vx = world->vx;
+    float* restrict vy = world->vy;
+    const float* restrict inv_mass = world->inv_mass;
+    const float diameter = 2.0f * radius;
+
+    for (int i = 0; i < pair_count; ++i)
+    {
+        uint32_t a = pairs[i].a;
+        uint32_t b = pairs[i].b;
+
+        float w = inv_mass[a] + inv_mass[b];
+        Vector2 delta = vec2_new(x[b] - x[a], y[b] - y[a]);
+        float dist_sq = vec2_length_squared(delta);
+        if (w <= 0.0f || dist_sq >= diameter * diameter || dist_sq < VECTOR_EPSILON)
+        {
+            continue;
+        }
+
+        float dist = sqrtf(dist_sq);
+        Vector2 normal = vec2_scale(delta, 1.0f / dist);
+        float correction = (diameter - dist) / w;
+
+        x[a] -= normal.x * correction * inv_mass[a];
+        y[a] -= normal.y * correction * inv_mass[a];
+        x[b] += normal.x * correction * inv_mass[b];
+        y[b] += normal.y * correction * inv_mass[b];
+        DEBUG_DRAW_CONTACT(0.5f * (x[a] + x[b]), 0.5f * (y[a] + y[b]), normal.x, normal.y);
+
+        float approach = vec2_dot(vec2_new(vx[b] - vx[a], vy[b] - vy[a]), normal);
+        if (approach < 0.0f)
+        {
+            float impulse = -approach / w;
+            vx[a] -= normal.x * impulse * inv_mass[a];
+            vy[a] -= normal.y * impulse * inv_mass[a];
+            vx[b] += normal.x * impulse * inv_mass[b];
+            vy[b] += normal.y * impulse * inv_mass[b];
+        }
+    }
+}
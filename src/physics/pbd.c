@@ -0,0 +1,497 @@
+#include "common.h"
+#include "physics/pbd.h"
+#include "physics/particle.h"
+#include "logging.h"
+#include "memory.h"
+
+/* Batch index for constraints that found no free colour; solved serially */
+#define PBD_OVERFLOW_BATCH PBD_MAX_COLORS
+
+PbdSolver* pbd_solver_create(int max_particles, int max_distance, int max_pins)
+{
+    if (max_particles <= 0 || max_distance < 0 || max_pins < 0)
+    {
+        LOG_ERROR("pbd:create: Invalid parameters");
+        return NULL;
+    }
+
+    PbdSolver* solver = (PbdSolver*)pd_calloc(1, sizeof(PbdSolver));
+    if (solver == NULL)
+    {
+        LOG_ERROR("pbd:create: Memory allocation failed");
+        return NULL;
+    }
+
+    solver->iterations = PBD_ITERATIONS;
+    solver->max_distance = max_distance;
+    solver->max_pins = max_pins;
+    solver->max_particles = max_particles;
+
+    size_t distances = (size_t)MAX(max_distance, 1);
+    size_t pins = (size_t)MAX(max_pins, 1);
+
+    solver->distance_a = (ParticleHandle*)pd_malloc(sizeof(ParticleHandle) * distances);
+    solver->distance_b = (ParticleHandle*)pd_malloc(sizeof(ParticleHandle) * distances);
+    solver->distance_rest = (float*)pd_malloc(sizeof(float) * distances);
+    solver->distance_stiffness = (float*)pd_malloc(sizeof(float) * distances);
+    solver->distance_color = (uint8_t*)pd_malloc(sizeof(uint8_t) * distances);
+    solver->batch_a = (uint32_t*)pd_malloc(sizeof(uint32_t) * distances);
+    solver->batch_b = (uint32_t*)pd_malloc(sizeof(uint32_t) * distances);
+    solver->batch_rest = (float*)pd_malloc(sizeof(float) * distances);
+    solver->batch_stiffness = (float*)pd_malloc(sizeof(float) * distances);
+    solver->color_mask = (uint32_t*)pd_malloc(sizeof(uint32_t) * (size_t)max_particles);
+    solver->pin_handle = (ParticleHandle*)pd_malloc(sizeof(ParticleHandle) * pins);
+    solver->pin_index = (uint32_t*)pd_malloc(sizeof(uint32_t) * pins);
+    solver->pin_x = (float*)pd_malloc(sizeof(float) * pins);
+    solver->pin_y = (float*)pd_malloc(sizeof(float) * pins);
+
+    if (solver->distance_a == NULL || solver->distance_b == NULL || solver->distance_rest == NULL ||
+        solver->distance_stiffness == NULL || solver->distance_color == NULL ||
+        solver->batch_a == NULL || solver->batch_b == NULL || solver->batch_rest == NULL ||
+        solver->batch_stiffness == NULL || solver->color_mask == NULL ||
+        solver->pin_handle == NULL || solver->pin_index == NULL || solver->pin_x == NULL || solver->pin_y == NULL)
+    {
+        LOG_ERROR("pbd:create: Failed to allocate constraint storage");
+        pbd_solver_destroy(solver);
+        return NULL;
+    }
+
+    pbd_solver_clear(solver);
+    return solver;
+}
+
+void pbd_solver_destroy(PbdSolver* solver)
+{
+    if (solver != NULL)
+    {
+        pd_free(solver->distance_a);
+        pd_free(solver->distance_b);
+        pd_free(solver->distance_rest);
+        pd_free(solver->distance_stiffness);
+        pd_free(solver->distance_color);
+        pd_free(solver->batch_a);
+        pd_free(solver->batch_b);
+        pd_free(solver->batch_rest);
+        pd_free(solver->batch_stiffness);
+        pd_free(solver->color_mask);
+        pd_free(solver->pin_handle);
+        pd_free(solver->pin_index);
+        pd_free(solver->pin_x);
+        pd_free(solver->pin_y);
+        pd_free(solver);
+    }
+}
+
+void pbd_solver_clear(PbdSolver* solver)
+{
+    solver->distance_count = 0;
+    solver->pin_count = 0;
+    solver->batch_count = 0;
+    solver->bounded = false;
+    solver->dirty = true;
+}
+
+/* More iterations make constraints stiffer and cost one more pass over every batch each */
+void pbd_solver_set_iterations(PbdSolver* solver, int iterations)
+{
+    solver->iterations = MAX(iterations, 1);
+    // Per-iteration stiffness depends on the count
+    solver->dirty = true;
+}
+
+/* Adds a constraint holding two particles at their current distance */
+int pbd_add_distance(PbdSolver* solver, const ParticleWorld* world, ParticleHandle a, ParticleHandle b, float stiffness)
+{
+    int ia = particle_world_index(world, a);
+    int ib = particle_world_index(world, b);
+    if (ia < 0 || ib < 0 || ia == ib)
+    {
+        LOG_WARNING("invalid particle pair %u, %u", (unsigned)a, (unsigned)b);
+        return -1;
+    }
+    if (solver->distance_count == solver->max_distance)
+    {
+        LOG_WARNING("distance constraints full (capacity: %d)", solver->max_distance);
+        return -1;
+    }
+
+    int constraint = solver->distance_count++;
+    solver->distance_a[constraint] = a;
+    solver->distance_b[constraint] = b;
+    solver->distance_rest[constraint] = vec2_distance(vec2_new(world->x[ia], world->y[ia]),
+                                                      vec2_new(world->x[ib], world->y[ib]));
+    solver->distance_stiffness[constraint] = float_clamp(stiffness, 0.0f, 1.0f);
+    solver->dirty = true;
+
+    return constraint;
+}
+
+/* Pins a particle where it currently is; move it with pbd_set_pin_position */
+int pbd_add_pin(PbdSolver* solver, const ParticleWorld* world, ParticleHandle handle)
+{
+    int index = particle_world_index(world, handle);
+    if (index < 0)
+    {
+        LOG_WARNING("stale particle handle %u", (unsigned)handle);
+        return -1;
+    }
+    if (solver->pin_count == solver->max_pins)
+    {
+        LOG_WARNING("pins full (capacity: %d)", solver->max_pins);
+        return -1;
+    }
+
+    int pin = solver->pin_count++;
+    solver->pin_handle[pin] = handle;
+    solver->pin_index[pin] = (uint32_t)index;
+    solver->pin_x[pin] = world->x[index];
+    solver->pin_y[pin] = world->y[index];
+    solver->dirty = true;
+
+    return pin;
+}
+
+void pbd_set_pin_position(PbdSolver* solver, int pin, Vector2 position)
+{
+    if (pin >= 0 && pin < solver->pin_count)
+    {
+        solver->pin_x[pin] = position.x;
+        solver->pin_y[pin] = position.y;
+    }
+}
+
+void pbd_set_bounds(PbdSolver* solver, Vector2 min, Vector2 max, float radius)
+{
+    solver->bounded = true;
+    solver->bounds_min = min;
+    solver->bounds_max = max;
+    solver->radius = radius;
+}
+
+/*
+ * x^(1 / n) for x in [0, 1]. libm's powf rounds differently from one target to
+ * the next, so the fixed-point build bisects for the root with multiplies,
+ * which round the same everywhere.
+ */
+static float pbd_root(float x, int n)
+{
+#ifdef PLAYSICS_FIXED_POINT
+    float low = 0.0f;
+    float high = 1.0f;
+    for (int step = 0; step < 24; ++step)
+    {
+        float middle = 0.5f * (low + high);
+        float power = middle;
+        for (int i = 1; i < n; ++i)
+        {
+            power *= middle;
+        }
+        if (power < x)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return 0.5f * (low + high);
+#else
+    return powf(x, 1.0f / (float)n);
+#endif
+}
+
+/*
+ * Resolves handles to dense indices, drops constraints on removed particles
+ * and sorts the distance constraints into colour batches. Runs only when the
+ * constraint set or the world's index layout changed.
+ */
+static void pbd_solver_prepare(PbdSolver* solver, const ParticleWorld* world)
+{
+    // Compact away pins and constraints whose particles are gone
+    int pins = 0;
+    for (int i = 0; i < solver->pin_count; ++i)
+    {
+        int index = particle_world_index(world, solver->pin_handle[i]);
+        if (index >= 0)
+        {
+            solver->pin_handle[pins] = solver->pin_handle[i];
+            solver->pin_index[pins] = (uint32_t)index;
+            solver->pin_x[pins] = solver->pin_x[i];
+            solver->pin_y[pins] = solver->pin_y[i];
+            pins++;
+        }
+    }
+    solver->pin_count = pins;
+
+    int kept = 0;
+    for (int i = 0; i < solver->distance_count; ++i)
+    {
+        if (particle_world_index(world, solver->distance_a[i]) >= 0 &&
+            particle_world_index(world, solver->distance_b[i]) >= 0)
+        {
+            solver->distance_a[kept] = solver->distance_a[i];
+            solver->distance_b[kept] = solver->distance_b[i];
+            solver->distance_rest[kept] = solver->distance_rest[i];
+            solver->distance_stiffness[kept] = solver->distance_stiffness[i];
+            kept++;
+        }
+    }
+    solver->distance_count = kept;
+
+    if (world->count > solver->max_particles)
+    {
+        LOG_WARNING("world has %d particles, solver was sized for %d", world->count, solver->max_particles);
+    }
+
+    // Greedy colouring: each constraint takes the lowest colour neither of its
+    // particles already uses
+    int counts[PBD_MAX_COLORS + 1] = { 0 };
+    memset(solver->color_mask, 0, sizeof(uint32_t) * (size_t)MIN(world->count, solver->max_particles));
+
+    for (int i = 0; i < kept; ++i)
+    {
+        int ia = particle_world_index(world, solver->distance_a[i]);
+        int ib = particle_world_index(world, solver->distance_b[i]);
+        if (ia >= solver->max_particles || ib >= solver->max_particles)
+        {
+            solver->distance_color[i] = PBD_OVERFLOW_BATCH;
+            counts[PBD_OVERFLOW_BATCH]++;
+            continue;
+        }
+
+        uint32_t used = solver->color_mask[ia] | solver->color_mask[ib];
+        int color = 0;
+        while (color < PBD_MAX_COLORS && (used & (1u << color)) != 0)
+        {
+            color++;
+        }
+
+        if (color < PBD_MAX_COLORS)
+        {
+            solver->color_mask[ia] |= 1u << color;
+            solver->color_mask[ib] |= 1u << color;
+        }
+        solver->distance_color[i] = (uint8_t)color;
+        counts[color]++;
+    }
+
+    // Counting sort into contiguous batches, trimming empty trailing colours
+    int start = 0;
+    solver->batch_count = 0;
+    for (int c = 0; c <= PBD_MAX_COLORS; ++c)
+    {
+        solver->batch_start[c] = start;
+        start += counts[c];
+        if (counts[c] > 0)
+        {
+            solver->batch_count = c + 1;
+        }
+    }
+    solver->batch_start[PBD_MAX_COLORS + 1] = start;
+
+    // Stiffness is applied once per iteration, so spread it over all of them
+    int iterations = MAX(solver->iterations, 1);
+    int cursor[PBD_MAX_COLORS + 1];
+    memcpy(cursor, solver->batch_start, sizeof(cursor));
+
+    for (int i = 0; i < kept; ++i)
+    {
+        int slot = cursor[solver->distance_color[i]]++;
+        solver->batch_a[slot] = (uint32_t)particle_world_index(world, solver->distance_a[i]);
+        solver->batch_b[slot] = (uint32_t)particle_world_index(world, solver->distance_b[i]);
+        solver->batch_rest[slot] = solver->distance_rest[i];
+        solver->batch_stiffness[slot] = 1.0f - pbd_root(1.0f - solver->distance_stiffness[i], iterations);
+    }
+
+    solver->dirty = false;
+    solver->world_revision = world->revision;
+}
+
+/*
+ * One batch of distance constraints. Within a colour no two constraints touch
+ * the same particle, so the order of the loop doesn't matter; degenerate
+ * constraints are masked out arithmetically rather than branched around.
+ */
+static void pbd_solve_distance_batch(float* restrict x, float* restrict y, const float* restrict inv_mass,
+                                     const uint32_t* restrict a, const uint32_t* restrict b,
+                                     const float* restrict rest, const float* restrict stiffness, int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        uint32_t ia = a[i];
+        uint32_t ib = b[i];
+        float dx = x[ib] - x[ia];
+        float dy = y[ib] - y[ia];
+        float wa = inv_mass[ia];
+        float wb = inv_mass[ib];
+
+        float length = sqrtf(dx * dx + dy * dy);
+        float denominator = (wa + wb) * length;
+        float valid = (float)(denominator > VECTOR_EPSILON);
+        float s = valid * stiffness[i] * (length - rest[i]) / (denominator + (1.0f - valid));
+
+        x[ia] += wa * s * dx;
+        y[ia] += wa * s * dy;
+        x[ib] -= wb * s * dx;
+        y[ib] -= wb * s * dy;
+    }
+}
+
+static void pbd_solve_bounds(float* restrict x, float* restrict y, int count,
+                             float min_x, float min_y, float max_x, float max_y)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        x[i] = fminf(fmaxf(x[i], min_x), max_x);
+        y[i] = fminf(fmaxf(y[i], min_y), max_y);
+    }
+}
+
+/*
+ * Projects the integrated positions onto the constraints, then derives each
+ * particle's velocity from how far it actually moved this step.
+ */
+void pbd_solver_solve(PbdSolver* solver, ParticleWorld* world, float dt)
+{
+    if (solver->dirty || solver->world_revision != world->revision)
+    {
+        pbd_solver_prepare(solver, world);
+    }
+
+    float* x = world->x;
+    float* y = world->y;
+    const int count = world->count;
+
+    for (int iteration = 0; iteration < solver->iterations; ++iteration)
+    {
+        for (int batch = 0; batch < solver->batch_count; ++batch)
+        {
+            int start = solver->batch_start[batch];
+            pbd_solve_distance_batch(x, y, world->inv_mass,
+                                     solver->batch_a + start, solver->batch_b + start,
+                                     solver->batch_rest + start, solver->batch_stiffness + start,
+                                     solver->batch_start[batch + 1] - start);
+        }
+
+        for (int i = 0; i < solver->pin_count; ++i)
+        {
+            x[solver->pin_index[i]] = solver->pin_x[i];
+            y[solver->pin_index[i]] = solver->pin_y[i];
+        }
+
+        if (solver->bounded)
+        {
+            pbd_solve_bounds(x, y, count,
+                             solver->bounds_min.x + solver->radius, solver->bounds_min.y + solver->radius,
+                             solver->bounds_max.x - solver->radius, solver->bounds_max.y - solver->radius);
+        }
+    }
+
+    float inv_dt = 1.0f / dt;
+    for (int i = 0; i < count; ++i)
+    {
+        world->vx[i] = (x[i] - world->prev_x[i]) * inv_dt;
+        world->vy[i] = (y[i] - world->prev_y[i]) * inv_dt;
+    }
+}
+
+/* ========================================================================== */
+/* BUILDERS                                                                   */
+/* ========================================================================== */
+
+/* A chain of particles from start to end whose first particle is pinned */
+ParticleHandle pbd_build_rope(PbdSolver* solver, ParticleWorld* world, Vector2 start, Vector2 end,
+                              int segments, float mass, float stiffness)
+{
+    if (segments < 1)
+    {
+        return PARTICLE_INVALID_HANDLE;
+    }
+
+    Particle particle = { start, VEC2_ZERO, VEC2_ZERO, 0.0f };
+    ParticleHandle first = particle_world_add(world, &particle);
+    if (first == PARTICLE_INVALID_HANDLE)
+    {
+        return PARTICLE_INVALID_HANDLE;
+    }
+    pbd_add_pin(solver, world, first);
+
+    ParticleHandle previous = first;
+    particle.mass = mass;
+    for (int i = 1; i <= segments; ++i)
+    {
+        particle.position = vec2_lerp(start, end, (float)i / (float)segments);
+        ParticleHandle handle = particle_world_add(world, &particle);
+        if (handle == PARTICLE_INVALID_HANDLE)
+        {
+            break;
+        }
+        pbd_add_distance(solver, world, previous, handle, stiffness);
+        previous = handle;
+    }
+
+    return first;
+}
+
+/* A grid of particles joined to their right and lower neighbours, pinned at the top corners */
+ParticleHandle pbd_build_cloth(PbdSolver* solver, ParticleWorld* world, Vector2 origin,
+                               int columns, int rows, float spacing, float mass, float stiffness)
+{
+    if (columns < 2 || rows < 1)
+    {
+        return PARTICLE_INVALID_HANDLE;
+    }
+
+    // Handles of the row above, to link each node to the one over it
+    ParticleHandle* above = (ParticleHandle*)pd_malloc(sizeof(ParticleHandle) * (size_t)columns);
+    if (above == NULL)
+    {
+        LOG_ERROR("pbd:cloth: Memory allocation failed");
+        return PARTICLE_INVALID_HANDLE;
+    }
+
+    ParticleHandle first = PARTICLE_INVALID_HANDLE;
+    for (int row = 0; row < rows; ++row)
+    {
+        ParticleHandle left = PARTICLE_INVALID_HANDLE;
+        for (int column = 0; column < columns; ++column)
+        {
+            bool anchor = row == 0 && (column == 0 || column == columns - 1);
+            Particle particle = {
+                .position = vec2_add(origin, vec2_new(column * spacing, row * spacing)),
+                .mass = anchor ? 0.0f : mass,
+            };
+
+            ParticleHandle handle = particle_world_add(world, &particle);
+            if (handle == PARTICLE_INVALID_HANDLE)
+            {
+                pd_free(above);
+                return first;
+            }
+
+            if (first == PARTICLE_INVALID_HANDLE)
+            {
+                first = handle;
+            }
+            if (anchor)
+            {
+                pbd_add_pin(solver, world, handle);
+            }
+            if (left != PARTICLE_INVALID_HANDLE)
+            {
+                pbd_add_distance(solver, world, left, handle, stiffness);
+            }
+            if (row > 0)
+            {
+                pbd_add_distance(solver, world, above[column], handle, stiffness);
+            }
+
+            left = handle;
+            above[column] = handle;
+        }
+    }
+
+    pd_free(above);
+    return first;
+}
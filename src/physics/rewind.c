@@ -0,0 +1,457 @@
+#include "common.h"
+#include "physics/rewind.h"
+#include "physics/body.h"
+#include "logging.h"
+#include "memory.h"
+
+/*
+ * Frame layout, packed without alignment so every field goes through
+ * memcpy:
+ *
+ *   uint16 particle records, uint16 body records, then the records, each
+ *   kind in ascending index order
+ *   record: tag byte, [uint16 index], one delta per field
+ *
+ * The tag's low two bits give the width of this record's deltas (8, 16 or
+ * 32 bits, whichever fits the largest). The upper six count the unchanged
+ * objects skipped since the previous record, so a run of changes costs no
+ * index at all; REWIND_SKIP_ESCAPE means a full index follows instead. A
+ * delta is old minus new, so adding it to the newest state steps back.
+ * Objects in steady motion move a few pixels per step, and their deltas fit
+ * the 8-bit width.
+ */
+
+/* Quantization: 1/16 pixel, 1/16 pixel per second, 1/4096 radian, 1/1024 radian per second */
+#define REWIND_POSITION_SCALE 16.0f
+#define REWIND_VELOCITY_SCALE 16.0f
+#define REWIND_ANGLE_SCALE    4096.0f
+#define REWIND_SPIN_SCALE     1024.0f
+
+/* Quantized values stay within this, so a delta between two always fits in 32 bits */
+#define REWIND_MAX_QUANTUM 1.0e9f
+
+/* What NaN quantizes to: outside the clamped range, so it never matches a real value */
+#define REWIND_NOT_FINITE (-1000000001)
+
+#define REWIND_PARTICLE_FIELDS 4
+#define REWIND_BODY_FIELDS     6
+#define REWIND_HEADER_SIZE     4
+
+#define REWIND_WIDTH_MASK  3u
+#define REWIND_SKIP_SHIFT  2
+#define REWIND_SKIP_ESCAPE 63
+#define REWIND_MAX_OBJECTS 0x10000
+
+/* Rounds half away from zero without a call to roundf; NaN would make the conversion undefined */
+static inline int32_t rewind_quantize(float value, float scale)
+{
+    if (isnan(value))
+    {
+        return REWIND_NOT_FINITE;
+    }
+    float q = float_clamp(value * scale, -REWIND_MAX_QUANTUM, REWIND_MAX_QUANTUM);
+    return (int32_t)(q >= 0.0f ? q + 0.5f : q - 0.5f);
+}
+
+/*
+ * A stored NaN comes back as zero, so stepping back always restores finite
+ * state, even to a frame recorded after the simulation blew up.
+ */
+static inline float rewind_dequantize(int32_t value, float scale)
+{
+    return value == REWIND_NOT_FINITE ? 0.0f : (float)value / scale;
+}
+
+static void rewind_quantize_particle(const ParticleWorld* particles, int i, int32_t out[REWIND_PARTICLE_FIELDS])
+{
+    out[0] = rewind_quantize(particles->x[i], REWIND_POSITION_SCALE);
+    out[1] = rewind_quantize(particles->y[i], REWIND_POSITION_SCALE);
+    out[2] = rewind_quantize(particles->vx[i], REWIND_VELOCITY_SCALE);
+    out[3] = rewind_quantize(particles->vy[i], REWIND_VELOCITY_SCALE);
+}
+
+static void rewind_quantize_body(const BodyWorld* bodies, int i, int32_t out[REWIND_BODY_FIELDS])
+{
+    const BodyPose* pose = &bodies->pose[i];
+    const BodyVelocity* velocity = &bodies->velocity[i];
+    out[0] = rewind_quantize(pose->x, REWIND_POSITION_SCALE);
+    out[1] = rewind_quantize(pose->y, REWIND_POSITION_SCALE);
+    out[2] = rewind_quantize(pose->angle, REWIND_ANGLE_SCALE);
+    out[3] = rewind_quantize(velocity->vx, REWIND_VELOCITY_SCALE);
+    out[4] = rewind_quantize(velocity->vy, REWIND_VELOCITY_SCALE);
+    out[5] = rewind_quantize(velocity->w, REWIND_SPIN_SCALE);
+}
+
+RewindBuffer* rewind_create(uint32_t budget, int max_frames, int particle_capacity, int body_capacity)
+{
+    if (budget < REWIND_HEADER_SIZE || max_frames <= 0 || particle_capacity < 0 || body_capacity < 0 ||
+        particle_capacity > REWIND_MAX_OBJECTS || body_capacity > REWIND_MAX_OBJECTS)
+    {
+        LOG_ERROR("rewind:create: Invalid parameters");
+        return NULL;
+    }
+
+    RewindBuffer* buffer = (RewindBuffer*)pd_calloc(1, sizeof(RewindBuffer));
+    if (buffer == NULL)
+    {
+        LOG_ERROR("rewind:create: Memory allocation failed");
+        return NULL;
+    }
+
+    // Worst case for one frame: every object changed, with an escaped index and 32-bit deltas
+    uint32_t particle_record = 3 + 4 * REWIND_PARTICLE_FIELDS;
+    uint32_t body_record = 3 + 4 * REWIND_BODY_FIELDS;
+    buffer->scratch_size = REWIND_HEADER_SIZE + particle_record * (uint32_t)particle_capacity +
+                           body_record * (uint32_t)body_capacity;
+
+    buffer->data = (uint8_t*)pd_malloc(budget);
+    buffer->frame_offset = (uint32_t*)pd_malloc(sizeof(uint32_t) * (size_t)max_frames);
+    buffer->frame_size = (uint32_t*)pd_malloc(sizeof(uint32_t) * (size_t)max_frames);
+    buffer->particle_state = (int32_t*)pd_malloc(sizeof(int32_t) * REWIND_PARTICLE_FIELDS * (size_t)MAX(particle_capacity, 1));
+    buffer->body_state = (int32_t*)pd_malloc(sizeof(int32_t) * REWIND_BODY_FIELDS * (size_t)MAX(body_capacity, 1));
+    buffer->scratch = (uint8_t*)pd_malloc(buffer->scratch_size);
+
+    if (buffer->data == NULL || buffer->frame_offset == NULL || buffer->frame_size == NULL ||
+        buffer->particle_state == NULL || buffer->body_state == NULL || buffer->scratch == NULL)
+    {
+        LOG_ERROR("rewind:create: Failed to allocate %u bytes of history", (unsigned)budget);
+        rewind_destroy(buffer);
+        return NULL;
+    }
+
+    buffer->size = budget;
+    buffer->max_frames = max_frames;
+    buffer->particle_capacity = particle_capacity;
+    buffer->body_capacity = body_capacity;
+    rewind_reset(buffer);
+
+    return buffer;
+}
+
+void rewind_destroy(RewindBuffer* buffer)
+{
+    if (buffer != NULL)
+    {
+        pd_free(buffer->data);
+        pd_free(buffer->frame_offset);
+        pd_free(buffer->frame_size);
+        pd_free(buffer->particle_state);
+        pd_free(buffer->body_state);
+        pd_free(buffer->scratch);
+        pd_free(buffer);
+    }
+}
+
+/* Forgets the history; the next record starts it over */
+void rewind_reset(RewindBuffer* buffer)
+{
+    buffer->first_frame = 0;
+    buffer->frame_count = 0;
+    buffer->has_base = false;
+}
+
+/* The history only applies while the same objects sit at the same dense indices */
+static bool rewind_matches(const RewindBuffer* buffer, const ParticleWorld* particles, const BodyWorld* bodies)
+{
+    return buffer->has_base && particles->count == buffer->particle_count && bodies->count == buffer->body_count &&
+           particles->revision == buffer->particle_revision && bodies->revision == buffer->body_revision;
+}
+
+/* Takes the current state as the newest frame, with nothing before it */
+static void rewind_rebase(RewindBuffer* buffer, const ParticleWorld* particles, const BodyWorld* bodies)
+{
+    rewind_reset(buffer);
+    if (particles->count > buffer->particle_capacity || bodies->count > buffer->body_capacity)
+    {
+        return;
+    }
+
+    for (int i = 0; i < particles->count; ++i)
+    {
+        rewind_quantize_particle(particles, i, &buffer->particle_state[REWIND_PARTICLE_FIELDS * i]);
+    }
+    for (int i = 0; i < bodies->count; ++i)
+    {
+        rewind_quantize_body(bodies, i, &buffer->body_state[REWIND_BODY_FIELDS * i]);
+    }
+
+    buffer->has_base = true;
+    buffer->particle_count = particles->count;
+    buffer->body_count = bodies->count;
+    buffer->particle_revision = particles->revision;
+    buffer->body_revision = bodies->revision;
+}
+
+/* ========================================================================== */
+/* RECORDS                                                                    */
+/* ========================================================================== */
+
+/*
+ * Writes the record stepping object index back from now to the stored
+ * state, and stores now. previous is the index of the last record written
+ * for this kind of object, -1 before the first.
+ */
+static uint8_t* rewind_put_record(uint8_t* out, int index, int previous, int32_t* state, const int32_t* now,
+                                  int fields)
+{
+    int32_t delta[REWIND_BODY_FIELDS];
+    uint32_t width = 0;
+    for (int f = 0; f < fields; ++f)
+    {
+        delta[f] = state[f] - now[f];
+        if (delta[f] < INT16_MIN || delta[f] > INT16_MAX)
+        {
+            width = 2;
+        }
+        else if ((delta[f] < INT8_MIN || delta[f] > INT8_MAX) && width == 0)
+        {
+            width = 1;
+        }
+        state[f] = now[f];
+    }
+
+    int skip = index - previous - 1;
+    bool escape = skip >= REWIND_SKIP_ESCAPE;
+    *out++ = (uint8_t)(width | (uint32_t)(escape ? REWIND_SKIP_ESCAPE : skip) << REWIND_SKIP_SHIFT);
+    if (escape)
+    {
+        uint16_t full = (uint16_t)index;
+        memcpy(out, &full, sizeof(full));
+        out += sizeof(full);
+    }
+
+    for (int f = 0; f < fields; ++f)
+    {
+        if (width == 0)
+        {
+            *out++ = (uint8_t)(int8_t)delta[f];
+        }
+        else if (width == 1)
+        {
+            int16_t narrow = (int16_t)delta[f];
+            memcpy(out, &narrow, sizeof(narrow));
+            out += sizeof(narrow);
+        }
+        else
+        {
+            memcpy(out, &delta[f], sizeof(delta[f]));
+            out += sizeof(delta[f]);
+        }
+    }
+    return out;
+}
+
+/* Reads the record after the one for *index and adds its deltas to that object's stored state */
+static const uint8_t* rewind_apply_record(const uint8_t* in, int32_t* states, int fields, int* index)
+{
+    uint32_t tag = *in++;
+    uint32_t width = tag & REWIND_WIDTH_MASK;
+    int skip = (int)(tag >> REWIND_SKIP_SHIFT);
+    if (skip == REWIND_SKIP_ESCAPE)
+    {
+        uint16_t full;
+        memcpy(&full, in, sizeof(full));
+        in += sizeof(full);
+        *index = (int)full;
+    }
+    else
+    {
+        *index += skip + 1;
+    }
+
+    int32_t* state = &states[fields * *index];
+    for (int f = 0; f < fields; ++f)
+    {
+        if (width == 0)
+        {
+            state[f] += (int8_t)*in++;
+        }
+        else if (width == 1)
+        {
+            int16_t delta;
+            memcpy(&delta, in, sizeof(delta));
+            in += sizeof(delta);
+            state[f] += delta;
+        }
+        else
+        {
+            int32_t delta;
+            memcpy(&delta, in, sizeof(delta));
+            in += sizeof(delta);
+            state[f] += delta;
+        }
+    }
+    return in;
+}
+
+/*
+ * Finds size contiguous bytes after the newest frame, wrapping to the start
+ * of the ring when the end is too short, and drops the oldest frames until
+ * they are free. Returns NULL if the frame is bigger than the whole ring.
+ */
+static uint8_t* rewind_alloc_frame(RewindBuffer* buffer, uint32_t size)
+{
+    if (size > buffer->size)
+    {
+        return NULL;
+    }
+
+    uint32_t offset = 0;
+    while (buffer->frame_count > 0)
+    {
+        int newest = (buffer->first_frame + buffer->frame_count - 1) % buffer->max_frames;
+        uint32_t start = buffer->frame_offset[buffer->first_frame];
+        uint32_t end = buffer->frame_offset[newest] + buffer->frame_size[newest];
+
+        if (buffer->frame_count < buffer->max_frames)
+        {
+            if (start < end)
+            {
+                // Live frames are one run: free space is after it and before it
+                if (buffer->size - end >= size)
+                {
+                    offset = end;
+                    break;
+                }
+                if (start >= size)
+                {
+                    offset = 0;
+                    break;
+                }
+            }
+            else if (start - end >= size)
+            {
+                // Live frames wrap around: free space is the gap between them
+                offset = end;
+                break;
+            }
+        }
+
+        buffer->first_frame = (buffer->first_frame + 1) % buffer->max_frames;
+        buffer->frame_count--;
+    }
+
+    int slot = (buffer->first_frame + buffer->frame_count) % buffer->max_frames;
+    buffer->frame_offset[slot] = offset;
+    buffer->frame_size[slot] = size;
+    buffer->frame_count++;
+    return buffer->data + offset;
+}
+
+/* ========================================================================== */
+/* RECORD / REWIND                                                            */
+/* ========================================================================== */
+
+/*
+ * Appends the current state as the newest frame; call once after every
+ * step. Only objects whose quantized state changed are written, so a scene
+ * mostly at rest costs a few bytes per frame. Adding or removing anything
+ * starts the history over from the current state.
+ */
+void rewind_record(RewindBuffer* buffer, const ParticleWorld* particles, const BodyWorld* bodies)
+{
+    if (!rewind_matches(buffer, particles, bodies))
+    {
+        rewind_rebase(buffer, particles, bodies);
+        return;
+    }
+
+    uint8_t* out = buffer->scratch + REWIND_HEADER_SIZE;
+    uint16_t counts[2] = { 0, 0 };
+
+    int previous = -1;
+    for (int i = 0; i < particles->count; ++i)
+    {
+        int32_t now[REWIND_PARTICLE_FIELDS];
+        int32_t* state = &buffer->particle_state[REWIND_PARTICLE_FIELDS * i];
+        rewind_quantize_particle(particles, i, now);
+        if (memcmp(now, state, sizeof(now)) != 0)
+        {
+            out = rewind_put_record(out, i, previous, state, now, REWIND_PARTICLE_FIELDS);
+            previous = i;
+            counts[0]++;
+        }
+    }
+
+    previous = -1;
+    for (int i = 0; i < bodies->count; ++i)
+    {
+        int32_t now[REWIND_BODY_FIELDS];
+        int32_t* state = &buffer->body_state[REWIND_BODY_FIELDS * i];
+        rewind_quantize_body(bodies, i, now);
+        if (memcmp(now, state, sizeof(now)) != 0)
+        {
+            out = rewind_put_record(out, i, previous, state, now, REWIND_BODY_FIELDS);
+            previous = i;
+            counts[1]++;
+        }
+    }
+
+    memcpy(buffer->scratch, counts, sizeof(counts));
+    uint32_t size = (uint32_t)(out - buffer->scratch);
+    uint8_t* frame = rewind_alloc_frame(buffer, size);
+    if (frame == NULL)
+    {
+        // Too much changed to keep even this one frame; the state is already stored as newest
+        LOG_WARNING("rewind frame of %u bytes exceeds the %u byte budget", (unsigned)size, (unsigned)buffer->size);
+        buffer->first_frame = 0;
+        buffer->frame_count = 0;
+        return;
+    }
+    memcpy(frame, buffer->scratch, size);
+}
+
+/*
+ * Puts the worlds back to the frame before the newest and drops the newest.
+ * Only the objects that frame changed are written; the rest already match
+ * to within the quantization. Restored objects are not interpolated, and
+ * restored bodies wake up. Returns false once the history is used up.
+ */
+bool rewind_step_back(RewindBuffer* buffer, ParticleWorld* particles, BodyWorld* bodies)
+{
+    if (buffer->frame_count == 0)
+    {
+        return false;
+    }
+    if (!rewind_matches(buffer, particles, bodies))
+    {
+        rewind_reset(buffer);
+        return false;
+    }
+
+    int newest = (buffer->first_frame + buffer->frame_count - 1) % buffer->max_frames;
+    const uint8_t* in = buffer->data + buffer->frame_offset[newest];
+    uint16_t counts[2];
+    memcpy(counts, in, sizeof(counts));
+    in += REWIND_HEADER_SIZE;
+
+    int i = -1;
+    for (int r = 0; r < counts[0]; ++r)
+    {
+        in = rewind_apply_record(in, buffer->particle_state, REWIND_PARTICLE_FIELDS, &i);
+        const int32_t* state = &buffer->particle_state[REWIND_PARTICLE_FIELDS * i];
+        particles->x[i] = rewind_dequantize(state[0], REWIND_POSITION_SCALE);
+        particles->y[i] = rewind_dequantize(state[1], REWIND_POSITION_SCALE);
+        particles->prev_x[i] = particles->x[i];
+        particles->prev_y[i] = particles->y[i];
+        particles->vx[i] = rewind_dequantize(state[2], REWIND_VELOCITY_SCALE);
+        particles->vy[i] = rewind_dequantize(state[3], REWIND_VELOCITY_SCALE);
+    }
+
+    i = -1;
+    for (int r = 0; r < counts[1]; ++r)
+    {
+        in = rewind_apply_record(in, buffer->body_state, REWIND_BODY_FIELDS, &i);
+        const int32_t* state = &buffer->body_state[REWIND_BODY_FIELDS * i];
+        body_world_set_state(bodies, bodies->index_to_handle[i],
+                             vec2_new(rewind_dequantize(state[0], REWIND_POSITION_SCALE),
+                                      rewind_dequantize(state[1], REWIND_POSITION_SCALE)),
+                             rewind_dequantize(state[2], REWIND_ANGLE_SCALE),
+                             vec2_new(rewind_dequantize(state[3], REWIND_VELOCITY_SCALE),
+                                      rewind_dequantize(state[4], REWIND_VELOCITY_SCALE)),
+                             rewind_dequantize(state[5], REWIND_SPIN_SCALE));
+    }
+
+    buffer->frame_count--;
+    return true;
+}
@@ -0,0 +1,183 @@
+#include "common.h"
+
+/*
+ * Batch kernels are written as plain indexed loops over restrict-qualified
+ * parameters, which is the shape GCC and Clang auto-vectorize (SSE/AVX on the
+ * host at -O3). The Cortex-M7 has no floating point SIMD, so on the device the
+ * hot accumulating kernels are unrolled by four instead: independent FPU ops
+ * can then dual-issue and the loop overhead is paid once per four elements.
+ */
+#if defined(__ARM_ARCH_7EM__) && !defined(PLAYSICS_SCALAR_KERNELS)
+#define VECTOR_UNROLL_ARM 1
+#endif
+
+/* ========================================================================== */
+/* VEC2 BATCH OPERATIONS                                                      */
+/* ========================================================================== */
+
+void vec2_add_n(float* restrict x, float* restrict y,
+                const float* restrict bx, const float* restrict by, int n)
+{
+    int i = 0;
+#ifdef VECTOR_UNROLL_ARM
+    for (; i + 4 <= n; i += 4)
+    {
+        x[i + 0] += bx[i + 0]; y[i + 0] += by[i + 0];
+        x[i + 1] += bx[i + 1]; y[i + 1] += by[i + 1];
+        x[i + 2] += bx[i + 2]; y[i + 2] += by[i + 2];
+        x[i + 3] += bx[i + 3]; y[i + 3] += by[i + 3];
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        x[i] += bx[i];
+        y[i] += by[i];
+    }
+}
+
+void vec2_scale_n(float* restrict x, float* restrict y, float scalar, int n)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        x[i] *= scalar;
+        y[i] *= scalar;
+    }
+}
+
+void vec2_scale_add_n(float* restrict x, float* restrict y,
+                      const float* restrict ax, const float* restrict ay, float scalar, int n)
+{
+    int i = 0;
+#ifdef VECTOR_UNROLL_ARM
+    for (; i + 4 <= n; i += 4)
+    {
+        x[i + 0] += ax[i + 0] * scalar; y[i + 0] += ay[i + 0] * scalar;
+        x[i + 1] += ax[i + 1] * scalar; y[i + 1] += ay[i + 1] * scalar;
+        x[i + 2] += ax[i + 2] * scalar; y[i + 2] += ay[i + 2] * scalar;
+        x[i + 3] += ax[i + 3] * scalar; y[i + 3] += ay[i + 3] * scalar;
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        x[i] += ax[i] * scalar;
+        y[i] += ay[i] * scalar;
+    }
+}
+
+void vec2_weighted_add_n(float* restrict x, float* restrict y,
+                         const float* restrict ax, const float* restrict ay,
+                         const float* restrict weight, float scalar, int n)
+{
+    int i = 0;
+#ifdef VECTOR_UNROLL_ARM
+    for (; i + 4 <= n; i += 4)
+    {
+        float w0 = weight[i + 0] * scalar;
+        float w1 = weight[i + 1] * scalar;
+        float w2 = weight[i + 2] * scalar;
+        float w3 = weight[i + 3] * scalar;
+        x[i + 0] += ax[i + 0] * w0; y[i + 0] += ay[i + 0] * w0;
+        x[i + 1] += ax[i + 1] * w1; y[i + 1] += ay[i + 1] * w1;
+        x[i + 2] += ax[i + 2] * w2; y[i + 2] += ay[i + 2] * w2;
+        x[i + 3] += ax[i + 3] * w3; y[i + 3] += ay[i + 3] * w3;
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        float w = weight[i] * scalar;
+        x[i] += ax[i] * w;
+        y[i] += ay[i] * w;
+    }
+}
+
+void vec2_length_n(float* restrict out, const float* restrict x, const float* restrict y, int n)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        out[i] = VECTOR_SQRTF(x[i] * x[i] + y[i] * y[i]);
+    }
+}
+
+void vec2_normalize_n(float* restrict x, float* restrict y, int n)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        // Arithmetic mask instead of a branch so the loop stays vectorizable:
+        // short vectors get inv = 0 and a harmless sqrtf(1) in their lane
+        float length_sq = x[i] * x[i] + y[i] * y[i];
+        float mask = (float)(length_sq >= VECTOR_EPSILON * VECTOR_EPSILON);
+        float inv = mask * VECTOR_RSQRTF(length_sq + (1.0f - mask));
+        x[i] *= inv;
+        y[i] *= inv;
+    }
+}
+
+/* ========================================================================== */
+/* VEC2 BATCH REFERENCE IMPLEMENTATIONS                                       */
+/* ========================================================================== */
+
+/* References stay scalar so benchmarks show what the batch kernels buy */
+#if defined(__GNUC__) && !defined(__clang__)
+#define VECTOR_SCALAR_REF __attribute__((optimize("no-tree-vectorize")))
+#else
+#define VECTOR_SCALAR_REF
+#endif
+
+VECTOR_SCALAR_REF void vec2_add_n_ref(float* x, float* y, const float* bx, const float* by, int n)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        Vector2 v = vec2_add(vec2_new(x[i], y[i]), vec2_new(bx[i], by[i]));
+        x[i] = v.x;
+        y[i] = v.y;
+    }
+}
+
+VECTOR_SCALAR_REF void vec2_scale_n_ref(float* x, float* y, float scalar, int n)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        Vector2 v = vec2_scale(vec2_new(x[i], y[i]), scalar);
+        x[i] = v.x;
+        y[i] = v.y;
+    }
+}
+
+VECTOR_SCALAR_REF void vec2_scale_add_n_ref(float* x, float* y, const float* ax, const float* ay, float scalar, int n)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        Vector2 v = vec2_add(vec2_new(x[i], y[i]), vec2_scale(vec2_new(ax[i], ay[i]), scalar));
+        x[i] = v.x;
+        y[i] = v.y;
+    }
+}
+
+VECTOR_SCALAR_REF void vec2_weighted_add_n_ref(float* x, float* y, const float* ax, const float* ay,
+                             const float* weight, float scalar, int n)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        Vector2 v = vec2_add(vec2_new(x[i], y[i]), vec2_scale(vec2_new(ax[i], ay[i]), weight[i] * scalar));
+        x[i] = v.x;
+        y[i] = v.y;
+    }
+}
+
+VECTOR_SCALAR_REF void vec2_length_n_ref(float* out, const float* x, const float* y, int n)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        out[i] = vec2_length(vec2_new(x[i], y[i]));
+    }
+}
+
+VECTOR_SCALAR_REF void vec2_normalize_n_ref(float* x, float* y, int n)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        Vector2 v = vec2_normalize(vec2_new(x[i], y[i]));
+        x[i] = v.x;
+        y[i] = v.y;
+    }
+}
@@ -0,0 +1,255 @@
+#include "common.h"
+#include "profiler.h"
+#include "raster.h"
+#include "logging.h"
+
+#ifdef PLAYSICS_PROFILER
+
+static Profiler profiler;
+
+/* Scopes shown as the overlay's stacked bar, with the dither each is filled with */
+static const char* const PROFILER_BAR_SCOPES[] = { "input", "update", "render" };
+static const uint8_t PROFILER_BAR_PATTERNS[][4] = {
+    { 0x00, 0x00, 0x00, 0x00 },
+    { 0xAA, 0x55, 0xAA, 0x55 },
+    { 0xEE, 0xBB, 0xEE, 0xBB },
+};
+
+static inline float profiler_now_ms(void)
+{
+    return pd->system->getElapsedTime() * 1000.0f;
+}
+
+/* Marks the start of a frame; update() must have just reset the elapsed time */
+void profiler_begin_frame(void)
+{
+    for (int i = 0; i < profiler.scope_count; ++i)
+    {
+        profiler.scopes[i].frame_ms = 0.0f;
+    }
+    profiler.depth = 0;
+}
+
+/* Commits this frame's scope totals to the history ring */
+void profiler_end_frame(void)
+{
+    if (profiler.depth != 0)
+    {
+        LOG_WARNING("%d profiler scopes still open at end of frame", profiler.depth);
+        profiler.depth = 0;
+    }
+
+    int slot = profiler.cursor;
+    for (int i = 0; i < profiler.scope_count; ++i)
+    {
+        profiler.scopes[i].history[slot] = profiler.scopes[i].frame_ms;
+    }
+    profiler.frame_history[slot] = profiler_now_ms();
+
+    profiler.cursor = (slot + 1) % PROFILER_HISTORY;
+    profiler.frames = MIN(profiler.frames + 1, PROFILER_HISTORY);
+}
+
+/* Index of a scope by name, or -1. Names are literals, so pointers usually match */
+int profiler_find(const char* name)
+{
+    for (int i = 0; i < profiler.scope_count; ++i)
+    {
+        if (profiler.scopes[i].name == name || strcmp(profiler.scopes[i].name, name) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* Opens a scope, registering it under the current one the first time it is seen */
+void profiler_begin(const char* name)
+{
+    if (profiler.depth == PROFILER_MAX_DEPTH)
+    {
+        LOG_WARNING("profiler scopes nested deeper than %d", PROFILER_MAX_DEPTH);
+        return;
+    }
+
+    int scope = profiler_find(name);
+    if (scope < 0)
+    {
+        if (profiler.scope_count == PROFILER_MAX_SCOPES)
+        {
+            LOG_WARNING("profiler scopes full (capacity: %d)", PROFILER_MAX_SCOPES);
+            return;
+        }
+
+        scope = profiler.scope_count++;
+        ProfileScope* created = &profiler.scopes[scope];
+        memset(created, 0, sizeof(ProfileScope));
+        created->name = name;
+        created->parent = profiler.depth > 0 ? profiler.stack[profiler.depth - 1] : -1;
+        created->depth = profiler.depth;
+    }
+
+    profiler.stack[profiler.depth++] = scope;
+    profiler.scopes[scope].opened = profiler_now_ms();
+}
+
+void profiler_end(void)
+{
+    if (profiler.depth == 0)
+    {
+        LOG_WARNING("profiler scope closed without being opened");
+        return;
+    }
+
+    ProfileScope* scope = &profiler.scopes[profiler.stack[--profiler.depth]];
+    scope->frame_ms += profiler_now_ms() - scope->opened;
+}
+
+/* A scope's time in the most recently completed frame */
+float profiler_last(int scope)
+{
+    if (scope < 0 || scope >= profiler.scope_count || profiler.frames == 0)
+    {
+        return 0.0f;
+    }
+    return profiler.scopes[scope].history[(profiler.cursor + PROFILER_HISTORY - 1) % PROFILER_HISTORY];
+}
+
+static int profiler_compare(const void* a, const void* b)
+{
+    float x = *(const float*)a;
+    float y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+static bool profiler_compute_stats(const float* history, ProfileStats* out)
+{
+    int count = profiler.frames;
+    if (count == 0)
+    {
+        return false;
+    }
+
+    // The ring is unordered in time, which statistics don't care about
+    float sorted[PROFILER_HISTORY];
+    memcpy(sorted, history, sizeof(float) * (size_t)count);
+    qsort(sorted, (size_t)count, sizeof(float), profiler_compare);
+
+    float sum = 0.0f;
+    for (int i = 0; i < count; ++i)
+    {
+        sum += sorted[i];
+    }
+
+    out->min = sorted[0];
+    out->max = sorted[count - 1];
+    out->mean = sum / (float)count;
+    out->p99 = sorted[MIN(count - 1, (count * 99) / 100)];
+    return true;
+}
+
+bool profiler_stats(int scope, ProfileStats* out)
+{
+    if (scope < 0 || scope >= profiler.scope_count)
+    {
+        return false;
+    }
+    return profiler_compute_stats(profiler.scopes[scope].history, out);
+}
+
+/* Statistics of the whole frame, from its start to profiler_end_frame */
+bool profiler_frame_stats(ProfileStats* out)
+{
+    return profiler_compute_stats(profiler.frame_history, out);
+}
+
+void profiler_set_overlay(bool enabled)
+{
+    profiler.overlay = enabled;
+}
+
+bool profiler_overlay_enabled(void)
+{
+    return profiler.overlay;
+}
+
+/*
+ * Draws last frame's input, update and render times as a stacked bar across
+ * the area, whose full width is one frame's budget, with a tick per 10 ms.
+ */
+void profiler_draw_overlay(RasterTarget* target, RasterRect area)
+{
+    raster_clear_rect(target, area);
+
+    const float budget_ms = 1000.0f / (float)FPS;
+    const float scale = (float)(area.right - area.left) / budget_ms;
+    float offset = 0.0f;
+
+    for (size_t i = 0; i < sizeof(PROFILER_BAR_SCOPES) / sizeof(PROFILER_BAR_SCOPES[0]); ++i)
+    {
+        float ms = profiler_last(profiler_find(PROFILER_BAR_SCOPES[i]));
+        RasterRect segment = {
+            area.left + (int)(offset * scale),
+            area.top + 1,
+            area.left + (int)((offset + ms) * scale),
+            area.bottom - 1,
+        };
+        raster_fill_rect(target, segment, PROFILER_BAR_PATTERNS[i]);
+        offset += ms;
+    }
+
+    for (float tick = 10.0f; tick < budget_ms; tick += 10.0f)
+    {
+        int x = area.left + (int)(tick * scale);
+        raster_draw_line(target, x, area.top, x, area.bottom - 1);
+    }
+}
+
+/*
+ * Writes the history ring, oldest frame first, as CSV: the frame time and
+ * then one column per scope. A relative path lands in the game's data folder.
+ */
+bool profiler_dump_csv(const char* path)
+{
+    SDFile* file = pd->file->open(path, kFileWrite);
+    if (file == NULL)
+    {
+        LOG_WARNING("couldn't open %s: %s", path, pd->file->geterr());
+        return false;
+    }
+
+    char line[512];
+    int length = snprintf(line, sizeof(line), "frame,frame_ms");
+    for (int i = 0; i < profiler.scope_count && length < (int)sizeof(line); ++i)
+    {
+        // Nested scopes are written as parent/child paths
+        const ProfileScope* scope = &profiler.scopes[i];
+        const char* parent = scope->parent >= 0 ? profiler.scopes[scope->parent].name : NULL;
+        length += snprintf(line + length, sizeof(line) - (size_t)length, parent != NULL ? ",%s/%s" : ",%s%s",
+                           parent != NULL ? parent : "", scope->name);
+    }
+    length = MIN(length, (int)sizeof(line) - 2);
+    line[length++] = '\n';
+    pd->file->write(file, line, (unsigned int)length);
+
+    int first = (profiler.cursor + PROFILER_HISTORY - profiler.frames) % PROFILER_HISTORY;
+    for (int f = 0; f < profiler.frames; ++f)
+    {
+        int slot = (first + f) % PROFILER_HISTORY;
+        length = snprintf(line, sizeof(line), "%d,%.3f", f, (double)profiler.frame_history[slot]);
+        for (int i = 0; i < profiler.scope_count && length < (int)sizeof(line); ++i)
+        {
+            length += snprintf(line + length, sizeof(line) - (size_t)length, ",%.3f",
+                               (double)profiler.scopes[i].history[slot]);
+        }
+        length = MIN(length, (int)sizeof(line) - 2);
+        line[length++] = '\n';
+        pd->file->write(file, line, (unsigned int)length);
+    }
+
+    pd->file->close(file);
+    pd->system->logToConsole("profiler: wrote %d frames to %s", profiler.frames, path);
+    return true;
+}
+
+#endif // PLAYSICS_PROFILER
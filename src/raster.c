@@ -0,0 +1,310 @@
+#include "common.h"
+#include "raster.h"
+
+/*
+ * The frame buffer is big-endian within each 32-bit word (pixel 0 is the top
+ * bit of byte 0). Masks are built in that order and swapped once per point so
+ * rows can be written a whole word at a time on little-endian targets.
+ */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define RASTER_WORD(mask) (mask)
+#elif defined(__GNUC__)
+#define RASTER_WORD(mask) __builtin_bswap32(mask)
+#else
+static inline uint32_t raster_bswap32(uint32_t v)
+{
+    return (v >> 24) | ((v >> 8) & 0xFF00u) | ((v << 8) & 0xFF0000u) | (v << 24);
+}
+#define RASTER_WORD(mask) raster_bswap32(mask)
+#endif
+
+/* rowbytes must be a multiple of 4 and pixels word aligned, as getFrame()'s buffer is */
+void raster_target_init(RasterTarget* target, uint8_t* pixels, int rowbytes, int width, int height)
+{
+    target->pixels = pixels;
+    target->rowbytes = rowbytes;
+    target->width = width;
+    target->height = height;
+    target->clip = (RasterRect){ 0, 0, width, height };
+    raster_target_begin(target);
+}
+
+/* Starts a new frame with no rows dirty */
+void raster_target_begin(RasterTarget* target)
+{
+    target->dirty_top = target->height;
+    target->dirty_bottom = -1;
+}
+
+bool raster_target_dirty(const RasterTarget* target)
+{
+    return target->dirty_top <= target->dirty_bottom;
+}
+
+/* Restricts drawing to clip, intersected with the buffer */
+void raster_target_set_clip(RasterTarget* target, RasterRect clip)
+{
+    target->clip.left = MAX(clip.left, 0);
+    target->clip.top = MAX(clip.top, 0);
+    target->clip.right = MIN(clip.right, target->width);
+    target->clip.bottom = MIN(clip.bottom, target->height);
+}
+
+static inline void raster_mark_rows(RasterTarget* target, int top, int bottom)
+{
+    target->dirty_top = MIN(target->dirty_top, top);
+    target->dirty_bottom = MAX(target->dirty_bottom, bottom);
+}
+
+/* Sets rows top..bottom (inclusive, clipped) to white */
+void raster_clear_rows(RasterTarget* target, int top, int bottom)
+{
+    top = MAX(top, 0);
+    bottom = MIN(bottom, target->height - 1);
+    if (top > bottom)
+    {
+        return;
+    }
+
+    memset(target->pixels + (size_t)top * (size_t)target->rowbytes, 0xFF,
+           (size_t)(bottom - top + 1) * (size_t)target->rowbytes);
+    raster_mark_rows(target, top, bottom);
+}
+
+/* Sets a rectangle (clipped to the buffer, not the clip rect) to white */
+void raster_clear_rect(RasterTarget* target, RasterRect rect)
+{
+    int left = MAX(rect.left, 0);
+    int top = MAX(rect.top, 0);
+    int right = MIN(rect.right, target->width);
+    int bottom = MIN(rect.bottom, target->height);
+    if (left >= right || top >= bottom)
+    {
+        return;
+    }
+
+    const size_t row_words = (size_t)target->rowbytes / sizeof(uint32_t);
+    int first = left >> 5;
+    int last = (right - 1) >> 5;
+    uint32_t first_mask = RASTER_WORD(0xFFFFFFFFu >> (left & 31));
+    uint32_t last_mask = RASTER_WORD(0xFFFFFFFFu << (31 - ((right - 1) & 31)));
+    if (first == last)
+    {
+        first_mask &= last_mask;
+    }
+
+    uint32_t* row = (uint32_t*)target->pixels + (size_t)top * row_words;
+    for (int y = top; y < bottom; ++y, row += row_words)
+    {
+        row[first] |= first_mask;
+        if (first != last)
+        {
+            for (int w = first + 1; w < last; ++w)
+            {
+                row[w] = 0xFFFFFFFFu;
+            }
+            row[last] |= last_mask;
+        }
+    }
+
+    raster_mark_rows(target, top, bottom - 1);
+}
+
+/*
+ * Fills a rectangle (clipped to the clip rect) with a 4-row repeating 8-pixel
+ * pattern; pattern bits follow the frame buffer, so set bits are white.
+ */
+void raster_fill_rect(RasterTarget* target, RasterRect rect, const uint8_t pattern[4])
+{
+    int left = MAX(rect.left, target->clip.left);
+    int top = MAX(rect.top, target->clip.top);
+    int right = MIN(rect.right, target->clip.right);
+    int bottom = MIN(rect.bottom, target->clip.bottom);
+    if (left >= right || top >= bottom)
+    {
+        return;
+    }
+
+    const size_t row_words = (size_t)target->rowbytes / sizeof(uint32_t);
+    int first = left >> 5;
+    int last = (right - 1) >> 5;
+    uint32_t first_mask = RASTER_WORD(0xFFFFFFFFu >> (left & 31));
+    uint32_t last_mask = RASTER_WORD(0xFFFFFFFFu << (31 - ((right - 1) & 31)));
+    if (first == last)
+    {
+        first_mask &= last_mask;
+    }
+
+    uint32_t* row = (uint32_t*)target->pixels + (size_t)top * row_words;
+    for (int y = top; y < bottom; ++y, row += row_words)
+    {
+        // Every byte of the word gets the same pattern byte, so no swap is needed
+        uint32_t fill = (uint32_t)pattern[y & 3] * 0x01010101u;
+        row[first] = (row[first] & ~first_mask) | (fill & first_mask);
+        for (int w = first + 1; w < last; ++w)
+        {
+            row[w] = fill;
+        }
+        if (last != first)
+        {
+            row[last] = (row[last] & ~last_mask) | (fill & last_mask);
+        }
+    }
+
+    target->dirty_top = MIN(target->dirty_top, top);
+    target->dirty_bottom = MAX(target->dirty_bottom, bottom - 1);
+}
+
+/*
+ * Draws one black size x size square with its top-left corner at (px, py).
+ * The clipped square becomes a one- or two-word mask that is ANDed into each
+ * of its rows, so it costs a few word writes instead of a graphics call.
+ */
+static inline void raster_fill_square(RasterTarget* target, size_t row_words, int px, int py, int size)
+{
+    int x0 = MAX(px, target->clip.left);
+    int x1 = MIN(px + size, target->clip.right);
+    int y0 = MAX(py, target->clip.top);
+    int y1 = MIN(py + size, target->clip.bottom);
+    if (x0 >= x1 || y0 >= y1)
+    {
+        return;
+    }
+
+    // Span of x0..x1 within the 64 pixels starting at x0's word
+    int length = x1 - x0;
+    uint64_t span = (((uint64_t)1 << length) - 1) << (64 - (x0 & 31) - length);
+    uint32_t first = ~RASTER_WORD((uint32_t)(span >> 32));
+    uint32_t second = ~RASTER_WORD((uint32_t)span);
+
+    uint32_t* row = (uint32_t*)target->pixels + (size_t)y0 * row_words + (size_t)(x0 >> 5);
+    if ((uint32_t)span == 0)
+    {
+        for (int y = y0; y < y1; ++y, row += row_words)
+        {
+            row[0] &= first;
+        }
+    }
+    else
+    {
+        for (int y = y0; y < y1; ++y, row += row_words)
+        {
+            row[0] &= first;
+            row[1] &= second;
+        }
+    }
+
+    target->dirty_top = MIN(target->dirty_top, y0);
+    target->dirty_bottom = MAX(target->dirty_bottom, y1 - 1);
+}
+
+/*
+ * Draws every point as a size x size square centred on its position,
+ * interpolated alpha of the way from prev to current.
+ */
+void raster_fill_points(RasterTarget* target, const float* prev_x, const float* prev_y,
+                        const float* x, const float* y, float alpha, int count, int size)
+{
+    size = MAX(1, MIN(size, RASTER_MAX_POINT_SIZE));
+    const int half = size / 2;
+    const size_t row_words = (size_t)target->rowbytes / sizeof(uint32_t);
+
+    for (int i = 0; i < count; ++i)
+    {
+        // floorf keeps points just left of / above the screen from rounding onto it
+        int px = (int)floorf(float_lerp(prev_x[i], x[i], alpha)) - half;
+        int py = (int)floorf(float_lerp(prev_y[i], y[i], alpha)) - half;
+        raster_fill_square(target, row_words, px, py, size);
+    }
+}
+
+/* Draws size x size squares at precomputed top-left pixels */
+void raster_fill_squares(RasterTarget* target, const int16_t* left, const int16_t* top, int count, int size)
+{
+    size = MAX(1, MIN(size, RASTER_MAX_POINT_SIZE));
+    const size_t row_words = (size_t)target->rowbytes / sizeof(uint32_t);
+
+    for (int i = 0; i < count; ++i)
+    {
+        raster_fill_square(target, row_words, left[i], top[i], size);
+    }
+}
+
+/* ========================================================================== */
+/* OUTLINES                                                                   */
+/* ========================================================================== */
+
+/* Single black pixel, clipped; outlines are debug-only, so per-pixel is fine */
+static inline void raster_plot(RasterTarget* target, int x, int y)
+{
+    if (x < target->clip.left || x >= target->clip.right || y < target->clip.top || y >= target->clip.bottom)
+    {
+        return;
+    }
+
+    target->pixels[(size_t)y * (size_t)target->rowbytes + (size_t)(x >> 3)] &= (uint8_t)~(0x80 >> (x & 7));
+    target->dirty_top = MIN(target->dirty_top, y);
+    target->dirty_bottom = MAX(target->dirty_bottom, y);
+}
+
+/* One-pixel Bresenham line, endpoints included */
+void raster_draw_line(RasterTarget* target, int x0, int y0, int x1, int y1)
+{
+    int dx = abs(x1 - x0);
+    int dy = -abs(y1 - y0);
+    int sx = x0 < x1 ? 1 : -1;
+    int sy = y0 < y1 ? 1 : -1;
+    int error = dx + dy;
+
+    for (;;)
+    {
+        raster_plot(target, x0, y0);
+        if (x0 == x1 && y0 == y1)
+        {
+            break;
+        }
+
+        int e2 = 2 * error;
+        if (e2 >= dy)
+        {
+            error += dy;
+            x0 += sx;
+        }
+        if (e2 <= dx)
+        {
+            error += dx;
+            y0 += sy;
+        }
+    }
+}
+
+/* Midpoint circle outline */
+void raster_draw_circle(RasterTarget* target, int cx, int cy, int radius)
+{
+    int x = radius;
+    int y = 0;
+    int error = 1 - radius;
+
+    while (x >= y)
+    {
+        raster_plot(target, cx + x, cy + y);
+        raster_plot(target, cx + y, cy + x);
+        raster_plot(target, cx - y, cy + x);
+        raster_plot(target, cx - x, cy + y);
+        raster_plot(target, cx - x, cy - y);
+        raster_plot(target, cx - y, cy - x);
+        raster_plot(target, cx + y, cy - x);
+        raster_plot(target, cx + x, cy - y);
+
+        y++;
+        if (error < 0)
+        {
+            error += 2 * y + 1;
+        }
+        else
+        {
+            x--;
+            error += 2 * (y - x) + 1;
+        }
+    }
+}
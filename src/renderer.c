@@ -2,6 +2,24 @@
 #include "renderer.h"
 #include "logging.h"
 #include "memory.h"
+#include "raster.h"
+#include "dirty.h"
+#include "shapes.h"
+#include "hud.h"
+#include "debug_draw.h"
+#include "profiler.h"
+
+#define RENDERER_PARTICLE_SIZE ((int)(2.0f * PARTICLE_RADIUS))
+
+/* Dither levels bodies are drawn with; static ones are darker */
+#define RENDERER_DYNAMIC_SHADE 5
+#define RENDERER_STATIC_SHADE  12
+
+/* Moving polygons are filled with a 50% checkerboard */
+static const LCDPattern RENDERER_POLYGON_PATTERN = {
+    0xAA, 0x55, 0xAA, 0x55, 0xAA, 0x55, 0xAA, 0x55,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
 
 Renderer* renderer_create(void)
 {
@@ -15,6 +33,57 @@ Renderer* renderer_create(void)
     renderer->initialized = false;
 	renderer->font = NULL;
 
+	// Both coordinate arrays share one block, freed through drawn_x
+	renderer->drawn_x = (int16_t*)pd_malloc(sizeof(int16_t) * 2 * MAX_PARTICLES);
+	if (renderer->drawn_x == NULL)
+	{
+		LOG_ERROR("renderer:create: Failed to allocate particle tracking");
+		pd_free(renderer);
+		return NULL;
+	}
+
+	renderer->body_rects = (RasterRect*)pd_malloc(sizeof(RasterRect) * MAX_BODIES);
+	renderer->body_keys = (uint32_t*)pd_malloc(sizeof(uint32_t) * MAX_BODIES);
+	renderer->body_asleep = (bool*)pd_malloc(sizeof(bool) * MAX_BODIES);
+	if (renderer->body_rects == NULL || renderer->body_keys == NULL || renderer->body_asleep == NULL)
+	{
+		LOG_ERROR("renderer:create: Failed to allocate body tracking");
+		pd_free(renderer->body_rects);
+		pd_free(renderer->body_keys);
+		pd_free(renderer->body_asleep);
+		pd_free(renderer->drawn_x);
+		pd_free(renderer);
+		return NULL;
+	}
+
+	renderer->shapes = shape_cache_create(SHAPE_CACHE_BUDGET);
+	if (renderer->shapes == NULL)
+	{
+		LOG_ERROR("renderer:create: Failed to create shape cache");
+		pd_free(renderer->body_rects);
+		pd_free(renderer->body_keys);
+		pd_free(renderer->body_asleep);
+		pd_free(renderer->drawn_x);
+		pd_free(renderer);
+		return NULL;
+	}
+
+	renderer->drawn_y = renderer->drawn_x + MAX_PARTICLES;
+	renderer->drawn_count = 0;
+	renderer->drawn_revision = 0;
+	renderer->body_count = 0;
+	renderer->body_revision = 0;
+
+	// Nothing is known about the frame yet, so the first draw repaints all of it
+	renderer->full_redraw = true;
+	dirty_region_clear(&renderer->dirty);
+	renderer->debug_bounds = (RasterRect){ 0, 0, 0, 0 };
+	renderer->profile_bounds = (RasterRect){ 0, 0, 0, 0 };
+
+	renderer->hud = NULL;
+	renderer->fps_frames = 0;
+	renderer->fps_start = 0;
+
 	return renderer;
 }
 
@@ -39,19 +108,349 @@ void renderer_init(Renderer* renderer)
         return;
     }
 
+    renderer->hud = hud_create(renderer->font);
+    if (renderer->hud == NULL)
+    {
+        LOG_ERROR("renderer:init: Failed to create HUD");
+        return;
+    }
+
+    int line = renderer->hud->line_height;
+    renderer->hud_title = hud_add(renderer->hud, 10, 10);
+    renderer->hud_fps = hud_add(renderer->hud, 10, 10 + line);
+    renderer->hud_particles = hud_add(renderer->hud, 10, 10 + 2 * line);
+    renderer->hud_profile = hud_add(renderer->hud, 10, 10 + 3 * line);
+    hud_set_text(renderer->hud, renderer->hud_title, "Hello, Playdate!");
+    renderer->fps_start = pd->system->getCurrentTimeMilliseconds();
+
 	renderer->initialized = true;
 }
 
-void renderer_draw(Renderer* renderer)
+/* Records which particles moved to a different pixel since they were last drawn */
+static void renderer_track_particles(Renderer* renderer, const ParticleWorld* particles, float alpha)
+{
+    const RasterRect screen = { 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT };
+    const int size = RENDERER_PARTICLE_SIZE;
+    const int half = size / 2;
+    int count = particles != NULL ? MIN(particles->count, MAX_PARTICLES) : 0;
+
+    // Adds and removes move dense indices, so per-index history is meaningless
+    if (particles != NULL && (particles->revision != renderer->drawn_revision || count != renderer->drawn_count))
+    {
+        renderer->full_redraw = true;
+    }
+
+    bool full = renderer->full_redraw;
+    for (int i = 0; i < count; ++i)
+    {
+        int16_t px = (int16_t)((int)floorf(float_lerp(particles->prev_x[i], particles->x[i], alpha)) - half);
+        int16_t py = (int16_t)((int)floorf(float_lerp(particles->prev_y[i], particles->y[i], alpha)) - half);
+        if (px == renderer->drawn_x[i] && py == renderer->drawn_y[i])
+        {
+            continue;
+        }
+
+        // Once the whole screen is dirty there is nothing left to merge
+        if (!full)
+        {
+            int ox = renderer->drawn_x[i];
+            int oy = renderer->drawn_y[i];
+            dirty_region_add(&renderer->dirty, (RasterRect){ ox, oy, ox + size, oy + size });
+            dirty_region_add(&renderer->dirty, (RasterRect){ px, py, px + size, py + size });
+
+            RasterRect first = renderer->dirty.rects[0];
+            full = renderer->dirty.count == 1 && first.left <= 0 && first.top <= 0 &&
+                   first.right >= screen.right && first.bottom >= screen.bottom;
+        }
+        renderer->drawn_x[i] = px;
+        renderer->drawn_y[i] = py;
+    }
+
+    if (full)
+    {
+        dirty_region_clear(&renderer->dirty);
+        dirty_region_add(&renderer->dirty, screen);
+    }
+
+    renderer->drawn_count = count;
+    renderer->drawn_revision = particles != NULL ? particles->revision : 0;
+    renderer->full_redraw = false;
+}
+
+/*
+ * Works out where body i is drawn this frame, between its last two poses.
+ * Circles and boxes are cached sprites, keyed by their cache entry; polygons
+ * are filled from their rounded outline, keyed by a hash of it. When draw is
+ * set the body is also drawn.
+ */
+static uint32_t renderer_body_sprite(Renderer* renderer, const BodyWorld* bodies, int i, float alpha,
+                                     bool draw, RasterRect* rect)
+{
+    const BodyPose* prev = &bodies->prev_pose[i];
+    const BodyPose* pose = &bodies->pose[i];
+    const BodyShape* shape = &bodies->shapes[i];
+    float x = float_lerp(prev->x, pose->x, alpha);
+    float y = float_lerp(prev->y, pose->y, alpha);
+    float angle = float_lerp(prev->angle, pose->angle, alpha);
+    bool dynamic = bodies->velocity[i].inv_mass > 0.0f;
+
+    if (shape->type != BODY_SHAPE_POLYGON)
+    {
+        ShapeKind kind = shape->type == BODY_SHAPE_CIRCLE ? SHAPE_CIRCLE : SHAPE_BOX;
+        int width = (int)(2.0f * shape->extent.x + 0.5f);
+        int height = (int)(2.0f * shape->extent.y + 0.5f);
+        int shade = dynamic ? RENDERER_DYNAMIC_SHADE : RENDERER_STATIC_SHADE;
+        const ShapeCacheEntry* entry = shape_cache_get(renderer->shapes, kind, width, height, shade, angle);
+        if (entry == NULL)
+        {
+            *rect = (RasterRect){ 0, 0, 0, 0 };
+            return 0;
+        }
+
+        *rect = shape_cache_rect(entry, x, y);
+        if (draw)
+        {
+            pd->graphics->drawBitmap(entry->bitmap, rect->left, rect->top, kBitmapUnflipped);
+        }
+        return entry->key;
+    }
+
+    float c;
+    float s;
+    VECTOR_SINCOSF(angle, &s, &c);
+
+    // FNV-1a over the outline
+    int coords[2 * BODY_MAX_VERTICES];
+    uint32_t key = 2166136261u;
+    *rect = (RasterRect){ INT16_MAX, INT16_MAX, INT16_MIN, INT16_MIN };
+    for (int v = 0; v < shape->count; ++v)
+    {
+        Vector2 p = shape->vertices[v];
+        int px = (int)floorf(c * p.x - s * p.y + x + 0.5f);
+        int py = (int)floorf(s * p.x + c * p.y + y + 0.5f);
+        coords[2 * v] = px;
+        coords[2 * v + 1] = py;
+        key = (key ^ (uint32_t)px) * 16777619u;
+        key = (key ^ (uint32_t)py) * 16777619u;
+
+        rect->left = MIN(rect->left, px);
+        rect->top = MIN(rect->top, py);
+        rect->right = MAX(rect->right, px + 1);
+        rect->bottom = MAX(rect->bottom, py + 1);
+    }
+
+    if (draw)
+    {
+        LCDColor color = dynamic ? (LCDColor)(uintptr_t)RENDERER_POLYGON_PATTERN : kColorBlack;
+        pd->graphics->fillPolygon(shape->count, coords, color, kPolygonFillNonZero);
+    }
+    return key;
+}
+
+/*
+ * Records which bodies moved or turned since they were last drawn. A body
+ * that was already asleep when last tracked cannot have, so it is skipped
+ * without working out its sprite.
+ */
+static void renderer_track_bodies(Renderer* renderer, const BodyWorld* bodies, float alpha)
+{
+    int count = bodies != NULL ? MIN(bodies->count, MAX_BODIES) : 0;
+
+    // As with particles, adds and removes invalidate per-index history
+    bool reset = bodies != NULL && (bodies->revision != renderer->body_revision || count != renderer->body_count);
+    if (reset)
+    {
+        renderer->full_redraw = true;
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+        bool asleep = !bodies->awake[i];
+        if (!reset && asleep && renderer->body_asleep[i])
+        {
+            continue;
+        }
+        renderer->body_asleep[i] = asleep;
+
+        RasterRect rect;
+        uint32_t key = renderer_body_sprite(renderer, bodies, i, alpha, false, &rect);
+        RasterRect old = renderer->body_rects[i];
+        if (!reset && key == renderer->body_keys[i] && rect.left == old.left && rect.top == old.top &&
+            rect.right == old.right && rect.bottom == old.bottom)
+        {
+            continue;
+        }
+
+        if (!reset)
+        {
+            dirty_region_add(&renderer->dirty, old);
+            dirty_region_add(&renderer->dirty, rect);
+        }
+        renderer->body_rects[i] = rect;
+        renderer->body_keys[i] = key;
+    }
+
+    renderer->body_count = count;
+    renderer->body_revision = bodies != NULL ? bodies->revision : 0;
+}
+
+/* Draws every body overlapping a dirty rectangle, clipped to it */
+static void renderer_draw_bodies(Renderer* renderer, const BodyWorld* bodies, RasterRect clip, float alpha)
+{
+    pd->graphics->setClipRect(clip.left, clip.top, clip.right - clip.left, clip.bottom - clip.top);
+    for (int i = 0; i < renderer->body_count; ++i)
+    {
+        if (raster_rect_overlaps(renderer->body_rects[i], clip))
+        {
+            RasterRect rect;
+            renderer_body_sprite(renderer, bodies, i, alpha, true, &rect);
+        }
+    }
+    pd->graphics->clearClipRect();
+}
+
+/* Refreshes the HUD readouts; their bitmaps are only re-rendered when the text differs */
+static void renderer_update_hud(Renderer* renderer, const ParticleWorld* particles, const BodyWorld* bodies)
+{
+    Hud* hud = renderer->hud;
+
+    // Average over a second so the counter doesn't flicker
+    renderer->fps_frames++;
+    unsigned int now = pd->system->getCurrentTimeMilliseconds();
+    unsigned int span = now - renderer->fps_start;
+    if (span >= 1000)
+    {
+        hud_printf(hud, renderer->hud_fps, "%d fps", (int)(renderer->fps_frames * 1000u / span));
+        renderer->fps_frames = 0;
+        renderer->fps_start = now;
+
+#ifdef PLAYSICS_PROFILER
+        ProfileStats frame;
+        if (profiler_overlay_enabled() && profiler_frame_stats(&frame))
+        {
+            hud_printf(hud, renderer->hud_profile, "%.1f / %.1f / %.1f ms p99 %.1f",
+                       (double)frame.min, (double)frame.mean, (double)frame.max, (double)frame.p99);
+        }
+#endif
+    }
+
+#ifdef PLAYSICS_PROFILER
+    if (!profiler_overlay_enabled())
+    {
+        hud_set_text(hud, renderer->hud_profile, "");
+    }
+#endif
+
+    hud_printf(hud, renderer->hud_particles, "%d particles, %d/%d bodies awake",
+               particles != NULL ? particles->count : 0, bodies != NULL ? bodies->active_count : 0,
+               bodies != NULL ? bodies->count : 0);
+    hud_collect_dirty(hud, &renderer->dirty);
+}
+
+/*
+ * Repaints only what changed: every particle or body that moved contributes
+ * its old and new box to the dirty region, and each dirty rectangle is erased and
+ * redrawn with everything clipped to it, then the HUD lines over it are
+ * blitted back. Only the rows of those rectangles are flagged for the LCD
+ * transfer. Returns false when nothing changed, so the display needn't be
+ * refreshed at all.
+ */
+bool renderer_draw(Renderer* renderer, const ParticleWorld* particles, const BodyWorld* bodies, float alpha)
 {
-    pd->graphics->clear(kColorWhite);
-    pd->graphics->drawText("Hello, Playdate!", 15, kASCIIEncoding, 10, 10);
+    shape_cache_begin_frame(renderer->shapes);
+    // Bodies first: a full repaint they request is applied by the particle pass
+    renderer_track_bodies(renderer, bodies, alpha);
+    renderer_track_particles(renderer, particles, alpha);
+    if (renderer->hud != NULL)
+    {
+        renderer_update_hud(renderer, particles, bodies);
+    }
+
+#ifdef PLAYSICS_DEBUG_DRAW
+    // The overlay is erased with last frame's bounds and redrawn within this frame's
+    RasterRect debug_bounds = debug_draw_bounds();
+    dirty_region_add(&renderer->dirty, renderer->debug_bounds);
+    dirty_region_add(&renderer->dirty, debug_bounds);
+    renderer->debug_bounds = debug_bounds;
+#endif
+
+#ifdef PLAYSICS_PROFILER
+    // The profiler bar changes every frame while it is shown
+    RasterRect profile_bounds = { 0, 0, 0, 0 };
+    if (profiler_overlay_enabled())
+    {
+        profile_bounds = (RasterRect){ 0, SCREEN_HEIGHT - 8, SCREEN_WIDTH, SCREEN_HEIGHT };
+    }
+    dirty_region_add(&renderer->dirty, renderer->profile_bounds);
+    dirty_region_add(&renderer->dirty, profile_bounds);
+    renderer->profile_bounds = profile_bounds;
+#endif
+
+    DirtyRegion* dirty = &renderer->dirty;
+    if (dirty->count == 0)
+    {
+        return false;
+    }
+
+    RasterTarget target;
+    raster_target_init(&target, pd->graphics->getFrame(), LCD_ROWSIZE, SCREEN_WIDTH, SCREEN_HEIGHT);
+
+    for (int i = 0; i < dirty->count; ++i)
+    {
+        RasterRect rect = dirty->rects[i];
+        raster_clear_rect(&target, rect);
+        raster_target_set_clip(&target, rect);
+        raster_fill_squares(&target, renderer->drawn_x, renderer->drawn_y, renderer->drawn_count,
+                            RENDERER_PARTICLE_SIZE);
+        if (bodies != NULL)
+        {
+            renderer_draw_bodies(renderer, bodies, rect, alpha);
+        }
+    }
+
+#ifdef PLAYSICS_DEBUG_DRAW
+    raster_target_set_clip(&target, (RasterRect){ 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT });
+    debug_draw_flush(&target);
+#endif
+
+#ifdef PLAYSICS_PROFILER
+    if (!raster_rect_empty(renderer->profile_bounds))
+    {
+        raster_target_set_clip(&target, (RasterRect){ 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT });
+        profiler_draw_overlay(&target, renderer->profile_bounds);
+    }
+#endif
+
+    for (int i = 0; i < dirty->count; ++i)
+    {
+        int top = MAX(dirty->rects[i].top, 0);
+        int bottom = MIN(dirty->rects[i].bottom, SCREEN_HEIGHT) - 1;
+        if (top <= bottom)
+        {
+            pd->graphics->markUpdatedRows(top, bottom);
+        }
+    }
+
+    if (renderer->hud != NULL)
+    {
+        hud_draw(renderer->hud, dirty);
+    }
+
+    dirty_region_clear(dirty);
+    return true;
 }
 
 void renderer_destroy(Renderer* renderer)
 {
     if (renderer != NULL)
     {
+        shape_cache_report(renderer->shapes);
+        shape_cache_destroy(renderer->shapes);
+        hud_destroy(renderer->hud);
+        pd_free(renderer->body_rects);
+        pd_free(renderer->body_keys);
+        pd_free(renderer->body_asleep);
+        pd_free(renderer->drawn_x);
         pd_free(renderer);
     }
 }
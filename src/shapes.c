@@ -0,0 +1,287 @@
+#include "common.h"
+#include "shapes.h"
+#include "logging.h"
+#include "memory.h"
+
+/*
+ * 4x4 Bayer matrix: a pixel is black when its threshold is below the shade,
+ * so shade 0 is white, 16 is black and every level in between is an evenly
+ * spread ordered dither.
+ */
+static const uint8_t SHAPE_BAYER[4][4] = {
+    {  0,  8,  2, 10 },
+    { 12,  4, 14,  6 },
+    {  3, 11,  1,  9 },
+    { 15,  7, 13,  5 },
+};
+
+/* Largest side length a key can hold */
+#define SHAPE_MAX_SIZE 511
+
+/* key = kind:2 | shade:5 | rotation:5 | width:9 | height:9 */
+static uint32_t shape_key(ShapeKind kind, int width, int height, int shade, int rotation)
+{
+    return ((uint32_t)kind << 28) | ((uint32_t)shade << 23) | ((uint32_t)rotation << 18) |
+           ((uint32_t)width << 9) | (uint32_t)height;
+}
+
+ShapeCache* shape_cache_create(size_t budget)
+{
+    ShapeCache* cache = (ShapeCache*)pd_malloc(sizeof(ShapeCache));
+    if (cache == NULL)
+    {
+        LOG_ERROR("shapes:create: Memory allocation failed");
+        return NULL;
+    }
+
+    cache->count = 0;
+    cache->bytes = 0;
+    cache->budget = budget;
+    cache->frame = 0;
+    cache->hits = 0;
+    cache->misses = 0;
+    cache->evictions = 0;
+
+    return cache;
+}
+
+void shape_cache_destroy(ShapeCache* cache)
+{
+    if (cache != NULL)
+    {
+        for (int i = 0; i < cache->count; ++i)
+        {
+            pd->graphics->freeBitmap(cache->entries[i].bitmap);
+        }
+        pd_free(cache);
+    }
+}
+
+/* Advances the clock entries are stamped with when used */
+void shape_cache_begin_frame(ShapeCache* cache)
+{
+    cache->frame++;
+}
+
+/* Coverage test for a pixel centre (u, v) in the shape's own frame */
+static bool shape_contains(ShapeKind kind, float half_width, float half_height, float u, float v)
+{
+    switch (kind)
+    {
+        case SHAPE_CIRCLE:
+            return u * u + v * v <= half_width * half_width;
+
+        case SHAPE_CAPSULE:
+        {
+            // A segment along the long axis, swept by a radius of half the short one
+            bool wide = half_width >= half_height;
+            float radius = wide ? half_height : half_width;
+            float extent = (wide ? half_width : half_height) - radius;
+            float along = float_clamp(wide ? u : v, -extent, extent);
+            float du = wide ? u - along : u;
+            float dv = wide ? v : v - along;
+            return du * du + dv * dv <= radius * radius;
+        }
+
+        case SHAPE_BOX:
+        default:
+            return fabsf(u) <= half_width && fabsf(v) <= half_height;
+    }
+}
+
+/*
+ * Rasterizes a shape into a new bitmap: a one-pixel black outline around a
+ * dithered fill, transparent outside. Only done on a cache miss, so it is
+ * written for clarity rather than speed.
+ */
+static LCDBitmap* shape_rasterize(ShapeKind kind, int width, int height, int shade, int rotation,
+                                  int* out_width, int* out_height, size_t* out_bytes)
+{
+    float angle = (float)rotation * (2.0f * FAST_PI / SHAPE_ROTATION_STEPS);
+    float c = cosf(angle);
+    float s = sinf(angle);
+    float half_width = 0.5f * (float)width;
+    float half_height = 0.5f * (float)height;
+
+    // Bounding box of the rotated shape plus a pixel of slack on each side
+    int bitmap_width = (int)ceilf(fabsf(c) * width + fabsf(s) * height) + 2;
+    int bitmap_height = (int)ceilf(fabsf(s) * width + fabsf(c) * height) + 2;
+
+    LCDBitmap* bitmap = pd->graphics->newBitmap(bitmap_width, bitmap_height, kColorClear);
+    if (bitmap == NULL)
+    {
+        LOG_ERROR("shapes:rasterize: Failed to create %dx%d bitmap", bitmap_width, bitmap_height);
+        return NULL;
+    }
+
+    int data_width;
+    int data_height;
+    int rowbytes;
+    uint8_t* mask = NULL;
+    uint8_t* data = NULL;
+    pd->graphics->getBitmapData(bitmap, &data_width, &data_height, &rowbytes, &mask, &data);
+    if (mask == NULL || data == NULL)
+    {
+        LOG_ERROR("shapes:rasterize: Bitmap has no mask");
+        pd->graphics->freeBitmap(bitmap);
+        return NULL;
+    }
+
+    const float cx = 0.5f * (float)bitmap_width;
+    const float cy = 0.5f * (float)bitmap_height;
+
+    for (int y = 0; y < bitmap_height; ++y)
+    {
+        for (int x = 0; x < bitmap_width; ++x)
+        {
+            // Sample pixel centres, and their four neighbours to find the outline
+            bool inside[5];
+            static const int OFFSETS[5][2] = { { 0, 0 }, { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+            for (int n = 0; n < 5; ++n)
+            {
+                float px = (float)(x + OFFSETS[n][0]) + 0.5f - cx;
+                float py = (float)(y + OFFSETS[n][1]) + 0.5f - cy;
+                inside[n] = shape_contains(kind, half_width, half_height, c * px + s * py, -s * px + c * py);
+            }
+
+            uint8_t bit = (uint8_t)(0x80 >> (x & 7));
+            size_t offset = (size_t)y * (size_t)rowbytes + (size_t)(x >> 3);
+            if (!inside[0])
+            {
+                mask[offset] &= (uint8_t)~bit;
+                continue;
+            }
+
+            bool edge = !inside[1] || !inside[2] || !inside[3] || !inside[4];
+            bool black = edge || SHAPE_BAYER[y & 3][x & 3] < shade;
+            mask[offset] |= bit;
+            data[offset] = black ? (uint8_t)(data[offset] & ~bit) : (uint8_t)(data[offset] | bit);
+        }
+    }
+
+    *out_width = bitmap_width;
+    *out_height = bitmap_height;
+    *out_bytes = (size_t)rowbytes * (size_t)bitmap_height * 2;
+    return bitmap;
+}
+
+static void shape_cache_evict(ShapeCache* cache, int index)
+{
+    ShapeCacheEntry* entry = &cache->entries[index];
+    pd->graphics->freeBitmap(entry->bitmap);
+    cache->bytes -= entry->bytes;
+    cache->evictions++;
+    *entry = cache->entries[--cache->count];
+}
+
+/* Evicts least recently used entries until an extra entry of size bytes fits */
+static void shape_cache_make_room(ShapeCache* cache, size_t bytes)
+{
+    while (cache->count > 0 && (cache->count == SHAPE_CACHE_MAX_ENTRIES || cache->bytes + bytes > cache->budget))
+    {
+        int oldest = 0;
+        for (int i = 1; i < cache->count; ++i)
+        {
+            if (cache->entries[i].last_used < cache->entries[oldest].last_used)
+            {
+                oldest = i;
+            }
+        }
+        shape_cache_evict(cache, oldest);
+    }
+}
+
+/*
+ * Returns the sprite for a shape, rasterizing it on first use. The angle is
+ * quantized to SHAPE_ROTATION_STEPS; boxes and capsules repeat every half
+ * turn and circles not at all, so they share entries accordingly. Returns
+ * NULL if the bitmap could not be created.
+ */
+const ShapeCacheEntry* shape_cache_get(ShapeCache* cache, ShapeKind kind, int width, int height,
+                                       int shade, float angle)
+{
+    width = MAX(1, MIN(width, SHAPE_MAX_SIZE));
+    height = MAX(1, MIN(height, SHAPE_MAX_SIZE));
+    shade = MAX(0, MIN(shade, SHAPE_SHADE_LEVELS - 1));
+
+    int rotation = 0;
+    if (kind == SHAPE_CIRCLE)
+    {
+        height = width;
+    }
+    else
+    {
+        int period = SHAPE_ROTATION_STEPS / 2;
+        int step = (int)floorf(angle * (SHAPE_ROTATION_STEPS / (2.0f * FAST_PI)) + 0.5f);
+        rotation = ((step % period) + period) % period;
+    }
+
+    uint32_t key = shape_key(kind, width, height, shade, rotation);
+    for (int i = 0; i < cache->count; ++i)
+    {
+        if (cache->entries[i].key == key)
+        {
+            cache->entries[i].last_used = cache->frame;
+            cache->hits++;
+            return &cache->entries[i];
+        }
+    }
+
+    cache->misses++;
+
+    int bitmap_width;
+    int bitmap_height;
+    size_t bytes;
+    LCDBitmap* bitmap = shape_rasterize(kind, width, height, shade, rotation, &bitmap_width, &bitmap_height, &bytes);
+    if (bitmap == NULL)
+    {
+        return NULL;
+    }
+
+    shape_cache_make_room(cache, bytes);
+    if (bytes > cache->budget)
+    {
+        LOG_WARNING("%dx%d sprite (%zu bytes) exceeds the cache budget", bitmap_width, bitmap_height, bytes);
+    }
+
+    ShapeCacheEntry* entry = &cache->entries[cache->count++];
+    entry->key = key;
+    entry->bitmap = bitmap;
+    entry->width = bitmap_width;
+    entry->height = bitmap_height;
+    entry->bytes = bytes;
+    entry->last_used = cache->frame;
+    cache->bytes += bytes;
+
+    return entry;
+}
+
+/* Pixels a sprite covers when centred on (x, y) */
+RasterRect shape_cache_rect(const ShapeCacheEntry* entry, float x, float y)
+{
+    int left = (int)floorf(x) - entry->width / 2;
+    int top = (int)floorf(y) - entry->height / 2;
+    return (RasterRect){ left, top, left + entry->width, top + entry->height };
+}
+
+/* Blits a shape centred on (x, y) and returns the pixels it covered */
+RasterRect shape_cache_draw(ShapeCache* cache, ShapeKind kind, int width, int height,
+                            int shade, float angle, float x, float y)
+{
+    const ShapeCacheEntry* entry = shape_cache_get(cache, kind, width, height, shade, angle);
+    if (entry == NULL)
+    {
+        return (RasterRect){ 0, 0, 0, 0 };
+    }
+
+    RasterRect rect = shape_cache_rect(entry, x, y);
+    pd->graphics->drawBitmap(entry->bitmap, rect.left, rect.top, kBitmapUnflipped);
+    return rect;
+}
+
+void shape_cache_report(const ShapeCache* cache)
+{
+    pd->system->logToConsole("shape cache: %d sprites, %zu of %zu bytes (%u hits, %u misses, %u evictions)",
+                             cache->count, cache->bytes, cache->budget,
+                             (unsigned)cache->hits, (unsigned)cache->misses, (unsigned)cache->evictions);
+}
@@ -0,0 +1,330 @@
+#include "common.h"
+#include "simulation.h"
+#include "logging.h"
+#include "memory.h"
+#include "input.h"
+#include "physics/particle.h"
+#include "physics/broadphase.h"
+#include "physics/pbd.h"
+#include "physics/force.h"
+#include "physics/body.h"
+#include "physics/rewind.h"
+#include "debug_draw.h"
+#include "profiler.h"
+
+/*
+ * The deterministic half of the engine: the worlds, the demo scene, and
+ * what one step and one frame's input do to them. Nothing here reads the
+ * clock, the buttons or the screen, so the same InputFrames run through
+ * simulation_input and simulation_step always end in the same state; that
+ * is what lets a recorded session replay headless on the host.
+ */
+
+/* Creates the worlds and the demo scene; the frame arena and timestep must already be set up */
+bool simulation_init(Engine* engine)
+{
+    engine->particles = particle_world_create(MAX_PARTICLES);
+    if (engine->particles == NULL)
+    {
+        LOG_ERROR("simulation:init: Failed to create particle world");
+        return false;
+    }
+
+#ifdef PLAYSICS_SWEEP_PRUNE
+    engine->sap = broadphase_sap_create(MAX_PARTICLES, MAX_PARTICLES * SWEEP_CHANGES_PER_PARTICLE);
+    engine->sap_pairs = broadphase_pair_set_create(MAX_PARTICLES * SWEEP_PAIRS_PER_PARTICLE);
+    if (engine->sap == NULL || engine->sap_pairs == NULL)
+    {
+        LOG_ERROR("simulation:init: Failed to create broadphase sweep");
+        return false;
+    }
+#else
+    engine->grid = broadphase_grid_create(BROADPHASE_CELL_SIZE, MAX_PARTICLES);
+    if (engine->grid == NULL)
+    {
+        LOG_ERROR("simulation:init: Failed to create broadphase grid");
+        return false;
+    }
+#endif
+
+    engine->solver = pbd_solver_create(MAX_PARTICLES, MAX_PBD_CONSTRAINTS, MAX_PBD_PINS);
+    if (engine->solver == NULL)
+    {
+        LOG_ERROR("simulation:init: Failed to create constraint solver");
+        return false;
+    }
+    pbd_set_bounds(engine->solver, VEC2_ZERO, vec2_new(SCREEN_WIDTH, SCREEN_HEIGHT), PARTICLE_RADIUS);
+
+    engine->forces = force_registry_create(MAX_PARTICLES, MAX_FORCE_FIELDS, MAX_FORCE_SPRINGS);
+    if (engine->forces == NULL)
+    {
+        LOG_ERROR("simulation:init: Failed to create force registry");
+        return false;
+    }
+    ForceField gravity = force_gravity(vec2_new(0.0f, GRAVITY));
+    force_add_field(engine->forces, &gravity);
+
+    engine->bodies = body_world_create(MAX_BODIES, MAX_BODY_CONTACTS);
+    if (engine->bodies == NULL)
+    {
+        LOG_ERROR("simulation:init: Failed to create body world");
+        return false;
+    }
+
+    engine->rewind = rewind_create(REWIND_BUDGET, REWIND_MAX_FRAMES, MAX_PARTICLES, MAX_BODIES);
+    if (engine->rewind == NULL)
+    {
+        LOG_ERROR("simulation:init: Failed to create rewind buffer");
+        return false;
+    }
+    engine->rewind_crank = 0.0f;
+    engine->rewinding = false;
+
+    // Demo scene: a cloth hung from its top corners, and a pyramid of boxes on a static floor
+    pbd_build_cloth(engine->solver, engine->particles, vec2_new(120.0f, 20.0f), 24, 16, 7.0f, 1.0f, 1.0f);
+
+    Body floor;
+    memset(&floor, 0, sizeof(floor));
+    floor.position = vec2_new(0.5f * SCREEN_WIDTH, SCREEN_HEIGHT - 4.0f);
+    floor.friction = 0.6f;
+    floor.shape = body_shape_aabb(SCREEN_WIDTH, 8.0f);
+    body_world_add(engine->bodies, &floor);
+    body_world_build_pyramid(engine->bodies, vec2_new(320.0f, SCREEN_HEIGHT - 8.0f), 12, 9.0f, 1.0f);
+    return true;
+}
+
+/* Applies one frame's input before that frame's steps run */
+void simulation_input(Engine* engine, const InputFrame* input)
+{
+    if (engine->particles == NULL || engine->bodies == NULL || engine->rewind == NULL)
+    {
+        return;
+    }
+
+    // Turning the crank backwards with REWIND_BUTTON held steps back through
+    // the history and holds the simulation still; it carries on from there
+    // once either stops. Without the button the crank is free for the game,
+    // like the Lua demo's attractor
+    float change = input_crank_change(input);
+    engine->rewinding = (input->buttons & REWIND_BUTTON) != 0 && change < 0.0f;
+    if (!engine->rewinding)
+    {
+        engine->rewind_crank = 0.0f;
+        return;
+    }
+
+    PROFILE_BEGIN("rewind");
+    engine->rewind_crank -= change;
+    while (engine->rewind_crank >= REWIND_CRANK_DEGREES)
+    {
+        engine->rewind_crank -= REWIND_CRANK_DEGREES;
+        if (!rewind_step_back(engine->rewind, engine->particles, engine->bodies))
+        {
+            engine->rewind_crank = 0.0f;
+            break;
+        }
+    }
+    PROFILE_END();
+}
+
+/*
+ * Finds this step's overlapping particle pairs with whichever broadphase
+ * was created. Grid pairs are written to the frame arena. The sweep only
+ * borrows the arena for the particles' bounds and reports which pairs
+ * changed, and the engine's pair set, which the collider iterates, takes in
+ * just those changes. Returns NULL if the arena ran out.
+ */
+static const BroadphasePair* simulation_find_pairs(Engine* engine, int* pair_count)
+{
+    const ParticleWorld* particles = engine->particles;
+    Arena* arena = engine->frame_arena;
+    *pair_count = 0;
+
+    if (engine->sap != NULL)
+    {
+        int count = particles->count;
+        float* min_x = ARENA_ALLOC(arena, float, count);
+        float* min_y = ARENA_ALLOC(arena, float, count);
+        float* max_x = ARENA_ALLOC(arena, float, count);
+        float* max_y = ARENA_ALLOC(arena, float, count);
+        if (min_x == NULL || min_y == NULL || max_x == NULL || max_y == NULL)
+        {
+            return NULL;
+        }
+        for (int i = 0; i < count; ++i)
+        {
+            min_x[i] = particles->x[i] - PARTICLE_RADIUS;
+            min_y[i] = particles->y[i] - PARTICLE_RADIUS;
+            max_x[i] = particles->x[i] + PARTICLE_RADIUS;
+            max_y[i] = particles->y[i] + PARTICLE_RADIUS;
+        }
+        broadphase_sap_update(engine->sap, min_x, min_y, max_x, max_y, count, particles->revision);
+        if (!broadphase_pair_set_apply(engine->sap_pairs, engine->sap))
+        {
+            // Start both over from a rebuild next step rather than keep a set with holes
+            broadphase_sap_clear(engine->sap);
+        }
+        *pair_count = engine->sap_pairs->count;
+        return engine->sap_pairs->pairs;
+    }
+
+    BroadphasePair* pairs = ARENA_ALLOC(arena, BroadphasePair, MAX_PARTICLE_PAIRS);
+    if (pairs == NULL)
+    {
+        return NULL;
+    }
+    *pair_count = broadphase_grid_build(engine->grid, particles->x, particles->y, particles->count, PARTICLE_RADIUS,
+                                        pairs, MAX_PARTICLE_PAIRS);
+#ifdef PLAYSICS_DEBUG_DRAW
+    if (engine->debug)
+    {
+        broadphase_grid_debug_draw(engine->grid);
+    }
+#endif
+    return pairs;
+}
+
+/* Advances every world by one fixed step; does nothing while the crank is rewinding */
+void simulation_step(Engine* engine)
+{
+    if (engine->particles == NULL || (engine->grid == NULL && engine->sap == NULL) || engine->solver == NULL || engine->forces == NULL ||
+        engine->bodies == NULL || engine->rewind == NULL || engine->frame_arena == NULL || engine->rewinding)
+    {
+        return;
+    }
+
+    // The overlay always shows the most recent step
+    DEBUG_DRAW_BEGIN();
+
+    ParticleWorld* particles = engine->particles;
+    PROFILE_BEGIN("forces");
+    force_registry_apply(engine->forces, particles);
+    PROFILE_END();
+
+    PROFILE_BEGIN("integrate");
+    particle_world_integrate(particles, engine->timestep.step);
+    PROFILE_END();
+
+    // Pairs only live for this step
+    ArenaScope scratch = arena_scope_begin(engine->frame_arena);
+    PROFILE_BEGIN("broadphase");
+    int pair_count;
+    const BroadphasePair* pairs = simulation_find_pairs(engine, &pair_count);
+    PROFILE_END();
+    if (pairs != NULL)
+    {
+        PROFILE_BEGIN("collide");
+        particle_world_collide(particles, pairs, pair_count, PARTICLE_RADIUS);
+        PROFILE_END();
+    }
+    arena_scope_end(scratch);
+
+    // Constraints run last so their positions and derived velocities win
+    PROFILE_BEGIN("solve");
+    pbd_solver_solve(engine->solver, particles, engine->timestep.step);
+    PROFILE_END();
+
+    PROFILE_BEGIN("bodies");
+    body_world_step(engine->bodies, engine->timestep.step);
+    PROFILE_END();
+
+    PROFILE_BEGIN("record");
+    rewind_record(engine->rewind, engine->particles, engine->bodies);
+    PROFILE_END();
+}
+
+/* FNV-1a over raw bytes, continuing from hash */
+static uint32_t simulation_hash_bytes(uint32_t hash, const void* data, size_t size)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/*
+ * Bitwise fingerprint of the primary state of both worlds: counts,
+ * particle positions and velocities, body poses and velocities. Two runs
+ * agree on it only if every float came out identical.
+ */
+uint32_t simulation_hash(const Engine* engine)
+{
+    uint32_t hash = 2166136261u;
+    const ParticleWorld* particles = engine->particles;
+    if (particles != NULL)
+    {
+        size_t size = sizeof(float) * (size_t)particles->count;
+        hash = simulation_hash_bytes(hash, &particles->count, sizeof(particles->count));
+        hash = simulation_hash_bytes(hash, particles->x, size);
+        hash = simulation_hash_bytes(hash, particles->y, size);
+        hash = simulation_hash_bytes(hash, particles->vx, size);
+        hash = simulation_hash_bytes(hash, particles->vy, size);
+    }
+
+    const BodyWorld* bodies = engine->bodies;
+    if (bodies != NULL)
+    {
+        hash = simulation_hash_bytes(hash, &bodies->count, sizeof(bodies->count));
+        for (int i = 0; i < bodies->count; ++i)
+        {
+            const BodyPose* pose = &bodies->pose[i];
+            const BodyVelocity* velocity = &bodies->velocity[i];
+            hash = simulation_hash_bytes(hash, &pose->x, sizeof(float));
+            hash = simulation_hash_bytes(hash, &pose->y, sizeof(float));
+            hash = simulation_hash_bytes(hash, &pose->angle, sizeof(float));
+            hash = simulation_hash_bytes(hash, &velocity->vx, sizeof(float));
+            hash = simulation_hash_bytes(hash, &velocity->vy, sizeof(float));
+            hash = simulation_hash_bytes(hash, &velocity->w, sizeof(float));
+        }
+    }
+    return hash;
+}
+
+void simulation_destroy(Engine* engine)
+{
+    if (engine->rewind != NULL)
+    {
+        rewind_destroy(engine->rewind);
+        engine->rewind = NULL;
+    }
+
+    if (engine->bodies != NULL)
+    {
+        body_world_destroy(engine->bodies);
+        engine->bodies = NULL;
+    }
+
+    if (engine->forces != NULL)
+    {
+        force_registry_destroy(engine->forces);
+        engine->forces = NULL;
+    }
+
+    if (engine->solver != NULL)
+    {
+        pbd_solver_destroy(engine->solver);
+        engine->solver = NULL;
+    }
+
+    if (engine->sap != NULL)
+    {
+        broadphase_sap_destroy(engine->sap);
+        engine->sap = NULL;
+    }
+    broadphase_pair_set_destroy(engine->sap_pairs);
+    engine->sap_pairs = NULL;
+
+    if (engine->grid != NULL)
+    {
+        broadphase_grid_destroy(engine->grid);
+        engine->grid = NULL;
+    }
+
+    if (engine->particles != NULL)
+    {
+        particle_world_destroy(engine->particles);
+        engine->particles = NULL;
+    }
+}
@@ -0,0 +1,194 @@
+#include "common.h"
+#include "snapshot.h"
+#include "logging.h"
+#include "physics/particle.h"
+#include "physics/body.h"
+
+/*
+ * Binary world snapshot: a header, then each live-range array of the
+ * particle and body worlds written whole, in native byte order. Nothing is
+ * packed object by object, so save and load are a couple of dozen large
+ * file calls. Only primary state is stored; trig, bounds, islands, contacts
+ * and the handle free lists are rebuilt on load, and PBD constraints are
+ * left as they are, so a snapshot is meant to be loaded into the scene it
+ * was saved from.
+ */
+
+#define SNAPSHOT_MAGIC   0x504E5350u // "PSNP"
+#define SNAPSHOT_VERSION 1u
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    int32_t particle_count;
+    int32_t body_count;
+} SnapshotHeader;
+
+/* One array of a snapshot: where it lives and how many bytes of it are live */
+typedef struct
+{
+    void* data;
+    size_t size;
+} SnapshotSection;
+
+#define SNAPSHOT_MAX_SECTIONS 16
+
+static int snapshot_sections(SnapshotSection* sections, const ParticleWorld* particles, const BodyWorld* bodies,
+                             int particle_count, int body_count)
+{
+    size_t p = (size_t)particle_count;
+    size_t b = (size_t)body_count;
+    int n = 0;
+
+    sections[n++] = (SnapshotSection){ particles->index_to_handle, sizeof(ParticleHandle) * p };
+    sections[n++] = (SnapshotSection){ particles->x, sizeof(float) * p };
+    sections[n++] = (SnapshotSection){ particles->y, sizeof(float) * p };
+    sections[n++] = (SnapshotSection){ particles->vx, sizeof(float) * p };
+    sections[n++] = (SnapshotSection){ particles->vy, sizeof(float) * p };
+    sections[n++] = (SnapshotSection){ particles->inv_mass, sizeof(float) * p };
+
+    sections[n++] = (SnapshotSection){ bodies->index_to_handle, sizeof(BodyHandle) * b };
+    sections[n++] = (SnapshotSection){ bodies->velocity, sizeof(BodyVelocity) * b };
+    sections[n++] = (SnapshotSection){ bodies->pose, sizeof(BodyPose) * b };
+    sections[n++] = (SnapshotSection){ bodies->density, sizeof(float) * b };
+    sections[n++] = (SnapshotSection){ bodies->friction, sizeof(float) * b };
+    sections[n++] = (SnapshotSection){ bodies->restitution, sizeof(float) * b };
+    sections[n++] = (SnapshotSection){ bodies->shapes, sizeof(BodyShape) * b };
+    return n;
+}
+
+/* An inverse mass or inertia as the worlds make them: finite, and zero for immovable */
+static bool snapshot_inverse_valid(float value)
+{
+    return isfinite(value) && value >= 0.0f;
+}
+
+/*
+ * Checks what the loaded arrays feed into the solvers unchecked: every
+ * position, velocity and material must be finite (a NaN position ends up
+ * converted to a grid cell index), inverse masses must be as the worlds make
+ * them, and body shapes valid, since their vertex count indexes fixed arrays.
+ */
+static bool snapshot_validate(const ParticleWorld* particles, const BodyWorld* bodies, int particle_count,
+                              int body_count)
+{
+    for (int i = 0; i < particle_count; ++i)
+    {
+        if (!isfinite(particles->x[i]) || !isfinite(particles->y[i]) ||
+            !isfinite(particles->vx[i]) || !isfinite(particles->vy[i]) ||
+            !snapshot_inverse_valid(particles->inv_mass[i]))
+        {
+            return false;
+        }
+    }
+    for (int i = 0; i < body_count; ++i)
+    {
+        const BodyPose* pose = &bodies->pose[i];
+        const BodyVelocity* velocity = &bodies->velocity[i];
+        if (!isfinite(pose->x) || !isfinite(pose->y) || !isfinite(pose->angle) ||
+            !isfinite(velocity->vx) || !isfinite(velocity->vy) || !isfinite(velocity->w) ||
+            !snapshot_inverse_valid(velocity->inv_mass) || !snapshot_inverse_valid(velocity->inv_inertia) ||
+            !isfinite(bodies->density[i]) || !isfinite(bodies->friction[i]) || !isfinite(bodies->restitution[i]) ||
+            !body_shape_valid(&bodies->shapes[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool snapshot_save(const char* path, const ParticleWorld* particles, const BodyWorld* bodies)
+{
+    unsigned int start = pd->system->getCurrentTimeMilliseconds();
+
+    SDFile* file = pd->file->open(path, kFileWrite);
+    if (file == NULL)
+    {
+        LOG_WARNING("couldn't open %s: %s", path, pd->file->geterr());
+        return false;
+    }
+
+    SnapshotHeader header = { SNAPSHOT_MAGIC, SNAPSHOT_VERSION, particles->count, bodies->count };
+    SnapshotSection sections[SNAPSHOT_MAX_SECTIONS];
+    int count = snapshot_sections(sections, particles, bodies, particles->count, bodies->count);
+
+    bool ok = pd->file->write(file, &header, sizeof(header)) == (int)sizeof(header);
+    for (int i = 0; i < count && ok; ++i)
+    {
+        ok = pd->file->write(file, sections[i].data, (unsigned int)sections[i].size) == (int)sections[i].size;
+    }
+    pd->file->close(file);
+
+    if (!ok)
+    {
+        LOG_WARNING("couldn't write %s: %s", path, pd->file->geterr());
+        return false;
+    }
+    pd->system->logToConsole("snapshot: saved %d particles, %d bodies to %s in %u ms", particles->count,
+                             bodies->count, path, pd->system->getCurrentTimeMilliseconds() - start);
+    return true;
+}
+
+/*
+ * Replaces both worlds with a saved snapshot. A file that does not fit the
+ * worlds' capacities is refused before anything changes; one that turns out
+ * truncated, or holds a non-finite value, handle table, inverse mass or body
+ * shape the worlds could not have made, leaves both worlds empty.
+ */
+bool snapshot_load(const char* path, ParticleWorld* particles, BodyWorld* bodies)
+{
+    unsigned int start = pd->system->getCurrentTimeMilliseconds();
+
+    SDFile* file = pd->file->open(path, kFileReadData);
+    if (file == NULL)
+    {
+        LOG_WARNING("couldn't open %s: %s", path, pd->file->geterr());
+        return false;
+    }
+
+    SnapshotHeader header;
+    if (pd->file->read(file, &header, sizeof(header)) != (int)sizeof(header) || header.magic != SNAPSHOT_MAGIC ||
+        header.version != SNAPSHOT_VERSION || header.particle_count < 0 || header.body_count < 0 ||
+        header.particle_count > particles->capacity || header.body_count > bodies->capacity)
+    {
+        LOG_WARNING("%s is not a snapshot these worlds can hold", path);
+        pd->file->close(file);
+        return false;
+    }
+
+    SnapshotSection sections[SNAPSHOT_MAX_SECTIONS];
+    int count = snapshot_sections(sections, particles, bodies, header.particle_count, header.body_count);
+
+    bool ok = true;
+    for (int i = 0; i < count && ok; ++i)
+    {
+        ok = pd->file->read(file, sections[i].data, (unsigned int)sections[i].size) == (int)sections[i].size;
+    }
+    pd->file->close(file);
+
+    if (!ok)
+    {
+        LOG_WARNING("%s is truncated", path);
+        particle_world_clear(particles);
+        body_world_clear(bodies);
+        return false;
+    }
+    if (!snapshot_validate(particles, bodies, header.particle_count, header.body_count))
+    {
+        LOG_WARNING("%s is corrupt", path);
+        particle_world_clear(particles);
+        body_world_clear(bodies);
+        return false;
+    }
+    if (!particle_world_reindex(particles, header.particle_count) || !body_world_reindex(bodies, header.body_count))
+    {
+        particle_world_clear(particles);
+        body_world_clear(bodies);
+        return false;
+    }
+
+    pd->system->logToConsole("snapshot: loaded %d particles, %d bodies from %s in %u ms", particles->count,
+                             bodies->count, path, pd->system->getCurrentTimeMilliseconds() - start);
+    return true;
+}
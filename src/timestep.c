@@ -0,0 +1,34 @@
+#include "common.h"
+#include "timestep.h"
+
+void timestep_init(Timestep* timestep, float step, int max_substeps)
+{
+    timestep->step = step;
+    timestep->accumulator = 0.0f;
+    timestep->alpha = 0.0f;
+    timestep->max_substeps = max_substeps;
+}
+
+/*
+ * Banks the real time elapsed since the last frame and returns how many fixed
+ * steps to run. When the simulation can't keep up, the backlog beyond
+ * max_substeps is dropped instead of carried over, so a slow frame can't
+ * snowball into ever more catch-up work (the "spiral of death").
+ */
+int timestep_advance(Timestep* timestep, float elapsed)
+{
+    // Long stalls (pause menu, loading) shouldn't be simulated at all
+    timestep->accumulator += float_clamp(elapsed, 0.0f, MAX_FRAME_TIME);
+
+    int steps = (int)(timestep->accumulator / timestep->step);
+    if (steps > timestep->max_substeps)
+    {
+        steps = timestep->max_substeps;
+        timestep->accumulator = (float)steps * timestep->step;
+    }
+
+    timestep->accumulator -= (float)steps * timestep->step;
+    timestep->alpha = float_clamp(timestep->accumulator / timestep->step, 0.0f, 1.0f);
+
+    return steps;
+}
@@ -0,0 +1,761 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <time.h>
+
+#include "common.h"
+#include "memory.h"
+#include "raster.h"
+#include "physics/particle.h"
+#include "physics/broadphase.h"
+#include "physics/pbd.h"
+#include "physics/force.h"
+#include "physics/body.h"
+#include "physics/rewind.h"
+#include "physics/fastmath.h"
+
+/*
+ * Host-side benchmarks for the engine's hot paths. Numbers are only
+ * comparable run to run on the same machine; they are meant to catch
+ * regressions before anything is flashed to a device.
+ */
+
+static const int BENCH_SIZES[] = { 1000, 10000, 100000 };
+#define BENCH_SIZE_COUNT ((int)(sizeof(BENCH_SIZES) / sizeof(BENCH_SIZES[0])))
+
+/* Roughly how many particle updates each measurement should cover */
+#define BENCH_WORK 20000000
+
+/* ========================================================================== */
+/* HELPERS                                                                    */
+/* ========================================================================== */
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint32_t bench_rng = 0x12345678u;
+
+static float bench_random(float min, float max)
+{
+    // xorshift32: deterministic across runs and platforms
+    bench_rng ^= bench_rng << 13;
+    bench_rng ^= bench_rng >> 17;
+    bench_rng ^= bench_rng << 5;
+    return min + (max - min) * (float)(bench_rng >> 8) / 16777216.0f;
+}
+
+static int bench_iterations(int n)
+{
+    return MAX(10, BENCH_WORK / n);
+}
+
+/* Particle radius that keeps the screen equally crowded at every size */
+static float bench_radius(int n)
+{
+    return 0.35f * sqrtf((float)(SCREEN_WIDTH * SCREEN_HEIGHT) / (float)n);
+}
+
+static void bench_fill_world(ParticleWorld* world, int n)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        Particle particle = {
+            .position = { bench_random(0.0f, SCREEN_WIDTH), bench_random(0.0f, SCREEN_HEIGHT) },
+            .velocity = { bench_random(-20.0f, 20.0f), bench_random(-20.0f, 20.0f) },
+            .acceleration = { 0.0f, 98.0f },
+            .mass = bench_random(0.5f, 2.0f),
+        };
+        particle_world_add(world, &particle);
+    }
+}
+
+/* ========================================================================== */
+/* BENCHMARKS                                                                 */
+/* ========================================================================== */
+
+/* Times one batch kernel against its scalar reference on identical inputs */
+typedef void (*BenchKernel)(float* x, float* y, const float* ax, const float* ay, const float* w, int n);
+
+static void bench_kernel(const char* name, BenchKernel batch, BenchKernel reference, int n)
+{
+    float* data = (float*)pd_malloc(sizeof(float) * (size_t)n * 7);
+    float* x = data;
+    float* y = data + n;
+    float* ref_x = data + n * 2;
+    float* ref_y = data + n * 3;
+    float* ax = data + n * 4;
+    float* ay = data + n * 5;
+    float* w = data + n * 6;
+
+    for (int i = 0; i < n; ++i)
+    {
+        x[i] = ref_x[i] = bench_random(-100.0f, 100.0f);
+        y[i] = ref_y[i] = bench_random(-100.0f, 100.0f);
+        ax[i] = bench_random(-1.0f, 1.0f);
+        ay[i] = bench_random(-1.0f, 1.0f);
+        w[i] = bench_random(0.0f, 2.0f);
+    }
+
+    batch(x, y, ax, ay, w, n);
+    reference(ref_x, ref_y, ax, ay, w, n);
+    float max_error = 0.0f;
+    for (int i = 0; i < n; ++i)
+    {
+        max_error = MAX(max_error, fabsf(x[i] - ref_x[i]));
+        max_error = MAX(max_error, fabsf(y[i] - ref_y[i]));
+    }
+
+    int rounds = bench_iterations(n);
+    double start = bench_now();
+    for (int r = 0; r < rounds; ++r)
+    {
+        batch(x, y, ax, ay, w, n);
+    }
+    double batch_time = bench_now() - start;
+
+    start = bench_now();
+    for (int r = 0; r < rounds; ++r)
+    {
+        reference(ref_x, ref_y, ax, ay, w, n);
+    }
+    double reference_time = bench_now() - start;
+
+    double elements = (double)n * rounds;
+    printf("%-18s %7d elements  batch %6.2f  ref %6.2f ns/element  max error %g\n",
+           name, n, batch_time * 1e9 / elements, reference_time * 1e9 / elements, max_error);
+
+    pd_free(data);
+}
+
+/* Adapters giving every kernel the BenchKernel shape */
+static void bench_add(float* x, float* y, const float* ax, const float* ay, const float* w, int n) { vec2_add_n(x, y, ax, ay, n); }
+static void bench_add_ref(float* x, float* y, const float* ax, const float* ay, const float* w, int n) { vec2_add_n_ref(x, y, ax, ay, n); }
+static void bench_axpy(float* x, float* y, const float* ax, const float* ay, const float* w, int n) { vec2_scale_add_n(x, y, ax, ay, 0.5f, n); }
+static void bench_axpy_ref(float* x, float* y, const float* ax, const float* ay, const float* w, int n) { vec2_scale_add_n_ref(x, y, ax, ay, 0.5f, n); }
+static void bench_weighted(float* x, float* y, const float* ax, const float* ay, const float* w, int n) { vec2_weighted_add_n(x, y, ax, ay, w, 0.5f, n); }
+static void bench_weighted_ref(float* x, float* y, const float* ax, const float* ay, const float* w, int n) { vec2_weighted_add_n_ref(x, y, ax, ay, w, 0.5f, n); }
+static void bench_length(float* x, float* y, const float* ax, const float* ay, const float* w, int n) { vec2_length_n(x, ax, ay, n); }
+static void bench_length_ref(float* x, float* y, const float* ax, const float* ay, const float* w, int n) { vec2_length_n_ref(x, ax, ay, n); }
+static void bench_normalize(float* x, float* y, const float* ax, const float* ay, const float* w, int n) { vec2_normalize_n(x, y, n); }
+static void bench_normalize_ref(float* x, float* y, const float* ax, const float* ay, const float* w, int n) { vec2_normalize_n_ref(x, y, n); }
+
+static void bench_kernels(int n)
+{
+    bench_kernel("vec2_add_n", bench_add, bench_add_ref, n);
+    bench_kernel("vec2_scale_add_n", bench_axpy, bench_axpy_ref, n);
+    bench_kernel("vec2_weighted_add_n", bench_weighted, bench_weighted_ref, n);
+    bench_kernel("vec2_length_n", bench_length, bench_length_ref, n);
+    bench_kernel("vec2_normalize_n", bench_normalize, bench_normalize_ref, n);
+}
+
+/* Sink for benchmark results so the loops can't be optimized away */
+static volatile float bench_sink;
+
+static void bench_fastmath(void)
+{
+    const int samples = 1000000;
+    float* inputs = (float*)pd_malloc(sizeof(float) * (size_t)samples * 2);
+    float* inputs_y = inputs + samples;
+
+    // rsqrt over a log-uniform range, relative error
+    double rsqrt_error = 0.0;
+    for (int i = 0; i < samples; ++i)
+    {
+        inputs[i] = powf(10.0f, bench_random(-4.0f, 6.0f));
+        double exact = 1.0 / sqrt((double)inputs[i]);
+        rsqrt_error = fmax(rsqrt_error, fabs(fast_rsqrt(inputs[i]) - exact) / exact);
+    }
+    double start = bench_now();
+    float sum = 0.0f;
+    for (int i = 0; i < samples; ++i) sum += 1.0f / sqrtf(inputs[i]);
+    double libm_time = bench_now() - start;
+    start = bench_now();
+    for (int i = 0; i < samples; ++i) sum += fast_rsqrt(inputs[i]);
+    double fast_time = bench_now() - start;
+    printf("rsqrt       libm %6.2f  fast %6.2f ns/call  max rel error %.2e\n",
+           libm_time * 1e9 / samples, fast_time * 1e9 / samples, rsqrt_error);
+
+    // sin/cos over several turns either side of zero, absolute error
+    double sincos_error = 0.0;
+    for (int i = 0; i < samples; ++i)
+    {
+        inputs[i] = bench_random(-100.0f, 100.0f);
+        float s, c;
+        fast_sincos(inputs[i], &s, &c);
+        sincos_error = fmax(sincos_error, fabs(s - sin((double)inputs[i])));
+        sincos_error = fmax(sincos_error, fabs(c - cos((double)inputs[i])));
+    }
+    start = bench_now();
+    for (int i = 0; i < samples; ++i) sum += sinf(inputs[i]) + cosf(inputs[i]);
+    libm_time = bench_now() - start;
+    start = bench_now();
+    for (int i = 0; i < samples; ++i)
+    {
+        float s, c;
+        fast_sincos(inputs[i], &s, &c);
+        sum += s + c;
+    }
+    fast_time = bench_now() - start;
+    printf("sincos      libm %6.2f  fast %6.2f ns/call  max abs error %.2e\n",
+           libm_time * 1e9 / samples, fast_time * 1e9 / samples, sincos_error);
+
+    // atan2 over all quadrants, absolute error
+    double atan2_error = 0.0;
+    for (int i = 0; i < samples; ++i)
+    {
+        inputs[i] = bench_random(-100.0f, 100.0f);
+        inputs_y[i] = bench_random(-100.0f, 100.0f);
+        double exact = atan2((double)inputs_y[i], (double)inputs[i]);
+        atan2_error = fmax(atan2_error, fabs(fast_atan2(inputs_y[i], inputs[i]) - exact));
+    }
+    start = bench_now();
+    for (int i = 0; i < samples; ++i) sum += atan2f(inputs_y[i], inputs[i]);
+    libm_time = bench_now() - start;
+    start = bench_now();
+    for (int i = 0; i < samples; ++i) sum += fast_atan2(inputs_y[i], inputs[i]);
+    fast_time = bench_now() - start;
+    printf("atan2       libm %6.2f  fast %6.2f ns/call  max abs error %.2e\n",
+           libm_time * 1e9 / samples, fast_time * 1e9 / samples, atan2_error);
+
+    bench_sink = sum;
+    pd_free(inputs);
+}
+
+static void bench_integrate(int n)
+{
+    ParticleWorld* world = particle_world_create(n);
+    bench_fill_world(world, n);
+
+    int steps = bench_iterations(n);
+    double start = bench_now();
+    for (int i = 0; i < steps; ++i)
+    {
+        particle_world_integrate(world, (float)LOGIC_RATE);
+    }
+    double elapsed = bench_now() - start;
+
+    printf("integrate   %7d particles  %8.2f ns/particle/step  hash %08x\n",
+           n, elapsed * 1e9 / ((double)steps * n), (unsigned)particle_world_hash(world));
+
+    particle_world_destroy(world);
+}
+
+/*
+ * Force generators: gravity, drag and wind, plus a number of attractors and
+ * a spring between each pair of neighbouring particles. The cost should grow
+ * by one linear pass per attractor and stay flat in the uniform fields.
+ */
+static void bench_forces(int n, int attractors)
+{
+    ParticleWorld* world = particle_world_create(n);
+    bench_fill_world(world, n);
+
+    ForceField fields[] = {
+        force_gravity(vec2_new(0.0f, GRAVITY)),
+        force_drag(0.02f, 0.001f),
+        force_wind(vec2_new(30.0f, 0.0f), 0.05f),
+    };
+    int field_count = (int)(sizeof(fields) / sizeof(fields[0]));
+    ForceRegistry* registry = force_registry_create(n, field_count + attractors, n / 2);
+    for (int i = 0; i < field_count; ++i)
+    {
+        force_add_field(registry, &fields[i]);
+    }
+    for (int i = 0; i < attractors; ++i)
+    {
+        ForceField attractor = force_attractor(vec2_new(bench_random(0.0f, SCREEN_WIDTH), bench_random(0.0f, SCREEN_HEIGHT)),
+                                               80.0f, 200.0f, (ForceFalloff)(i % 3));
+        force_add_field(registry, &attractor);
+    }
+    for (int i = 0; i + 1 < n; i += 2)
+    {
+        force_add_spring(registry, world, world->index_to_handle[i], world->index_to_handle[i + 1], 50.0f, 0.5f);
+    }
+
+    int steps = bench_iterations(n);
+    double start = bench_now();
+    for (int i = 0; i < steps; ++i)
+    {
+        force_registry_apply(registry, world);
+    }
+    double elapsed = bench_now() - start;
+
+    printf("forces      %7d particles  %2d attractors %7d springs  %8.2f ns/particle/step\n",
+           n, attractors, registry->spring_count, elapsed * 1e9 / ((double)steps * n));
+
+    force_registry_destroy(registry);
+    particle_world_destroy(world);
+}
+
+/* Same workload through the Q16.16 integrator; its hash must match on every target */
+static void bench_integrate_fixed(int n)
+{
+    ParticleWorld* world = particle_world_create(n);
+    bench_fill_world(world, n);
+
+    int steps = bench_iterations(n);
+    double start = bench_now();
+    for (int i = 0; i < steps; ++i)
+    {
+        particle_world_integrate_fixed(world, (float)LOGIC_RATE);
+    }
+    double elapsed = bench_now() - start;
+
+    printf("fixed       %7d particles  %8.2f ns/particle/step  hash %08x\n",
+           n, elapsed * 1e9 / ((double)steps * n), (unsigned)particle_world_hash(world));
+
+    particle_world_destroy(world);
+}
+
+static void bench_broadphase(int n)
+{
+    ParticleWorld* world = particle_world_create(n);
+    bench_fill_world(world, n);
+
+    float radius = bench_radius(n);
+    BroadphaseGrid* grid = broadphase_grid_create(4.0f * radius, n);
+    int max_pairs = n * 8;
+    BroadphasePair* pairs = (BroadphasePair*)pd_malloc(sizeof(BroadphasePair) * (size_t)max_pairs);
+
+    int builds = MAX(10, bench_iterations(n) / 8);
+    long long total_pairs = 0;
+    double start = bench_now();
+    for (int i = 0; i < builds; ++i)
+    {
+        total_pairs += broadphase_grid_build(grid, world->x, world->y, world->count, radius, pairs, max_pairs);
+    }
+    double elapsed = bench_now() - start;
+
+    printf("broadphase  %7d particles  %8.3f ms/build  %7lld pairs  %8.2f Mpairs/s%s\n",
+           n, elapsed * 1e3 / builds, total_pairs / builds, (double)total_pairs / elapsed * 1e-6,
+           grid->overflowed ? "  (overflowed)" : "");
+
+    pd_free(pairs);
+    broadphase_grid_destroy(grid);
+    particle_world_destroy(world);
+}
+
+/* Scenes for bench_sweep */
+typedef enum
+{
+    BENCH_SCATTERED,
+    BENCH_STACKED,
+    BENCH_MIXED
+} BenchScene;
+
+/* Every BENCH_MIXED_EVERY-th box in the mixed scene is BENCH_MIXED_SCALE times the size */
+#define BENCH_MIXED_EVERY 16
+#define BENCH_MIXED_SCALE 8.0f
+
+/*
+ * Grid rebuild against the incremental sweep on the same moving boxes.
+ * Scattered boxes drift across the whole screen. Stacked boxes sit in
+ * columns a few pixels apart and only jitter, which is the sweep's best
+ * case for motion. Mixed drifts like scattered, but one box in
+ * BENCH_MIXED_EVERY is BENCH_MIXED_SCALE times the size; the grid takes a
+ * single radius, so it has to use the largest. The grid tests circles and
+ * the sweep boxes, so the counts differ. The sweep's time covers building
+ * its bounds and applying its changes to a pair set, as the engine does.
+ */
+static void bench_sweep(int n, BenchScene scene)
+{
+    static const char* const names[] = { "scattered", "stacked", "mixed" };
+    float* x = (float*)pd_malloc(sizeof(float) * (size_t)n);
+    float* y = (float*)pd_malloc(sizeof(float) * (size_t)n);
+    float* vx = (float*)pd_malloc(sizeof(float) * (size_t)n);
+    float* vy = (float*)pd_malloc(sizeof(float) * (size_t)n);
+    float* radii = (float*)pd_malloc(sizeof(float) * (size_t)n);
+    float* bounds = (float*)pd_malloc(sizeof(float) * 4 * (size_t)n);
+    float* min_x = bounds;
+    float* min_y = bounds + n;
+    float* max_x = bounds + 2 * n;
+    float* max_y = bounds + 3 * n;
+
+    float radius = 0.8f * bench_radius(n);
+    float largest = scene == BENCH_MIXED ? BENCH_MIXED_SCALE * radius : radius;
+    int columns = (int)(SCREEN_WIDTH / (2.0f * radius));
+    for (int i = 0; i < n; ++i)
+    {
+        radii[i] = scene == BENCH_MIXED && i % BENCH_MIXED_EVERY == 0 ? largest : radius;
+        if (scene == BENCH_STACKED)
+        {
+            x[i] = radius + (float)(i % columns) * 2.0f * radius;
+            y[i] = SCREEN_HEIGHT - radius - (float)(i / columns) * 2.0f * radius;
+            vx[i] = 0.0f;
+            vy[i] = 0.0f;
+        }
+        else
+        {
+            x[i] = bench_random(0.0f, SCREEN_WIDTH);
+            y[i] = bench_random(0.0f, SCREEN_HEIGHT);
+            vx[i] = bench_random(-1.0f, 1.0f);
+            vy[i] = bench_random(-1.0f, 1.0f);
+        }
+    }
+
+    // Circles of the largest radius find about that many more neighbours each
+    int max_pairs = (int)((float)n * 8.0f * (largest / radius) * (largest / radius));
+    BroadphaseGrid* grid = broadphase_grid_create(4.0f * largest, n);
+    BroadphasePair* pairs = (BroadphasePair*)pd_malloc(sizeof(BroadphasePair) * (size_t)max_pairs);
+    // Same starting room as the engine's, so growing is part of the measurement
+    BroadphaseSap* sap = broadphase_sap_create(n, n * SWEEP_CHANGES_PER_PARTICLE);
+    BroadphasePairSet* set = broadphase_pair_set_create(n * SWEEP_PAIRS_PER_PARTICLE);
+    int start_room = set->capacity;
+
+    int steps = 200;
+    double grid_time = 0.0;
+    double sap_time = 0.0;
+    long long grid_pairs = 0;
+    long long sap_pairs = 0;
+    long long changes = 0;
+    bool overflowed = false;
+    for (int step = 0; step < steps; ++step)
+    {
+        // Motion is not timed: drifting boxes bounce off the screen edges, stacked ones jitter in place
+        for (int i = 0; i < n; ++i)
+        {
+            if (scene == BENCH_STACKED)
+            {
+                vx[i] = bench_random(-0.02f, 0.02f) * radius;
+                vy[i] = bench_random(-0.02f, 0.02f) * radius;
+            }
+            x[i] += vx[i];
+            y[i] += vy[i];
+            if (x[i] < 0.0f || x[i] > SCREEN_WIDTH)
+            {
+                vx[i] = -vx[i];
+            }
+            if (y[i] < 0.0f || y[i] > SCREEN_HEIGHT)
+            {
+                vy[i] = -vy[i];
+            }
+        }
+
+        double start = bench_now();
+        grid_pairs += broadphase_grid_build(grid, x, y, n, largest, pairs, max_pairs);
+        grid_time += bench_now() - start;
+
+        start = bench_now();
+        for (int i = 0; i < n; ++i)
+        {
+            min_x[i] = x[i] - radii[i];
+            min_y[i] = y[i] - radii[i];
+            max_x[i] = x[i] + radii[i];
+            max_y[i] = y[i] + radii[i];
+        }
+        broadphase_sap_update(sap, min_x, min_y, max_x, max_y, n, 0);
+        overflowed |= !broadphase_pair_set_apply(set, sap);
+        sap_time += bench_now() - start;
+        sap_pairs += set->count;
+        // The first update lists every pair; count what changes after it
+        changes += step > 0 ? sap->added_count + sap->removed_count : 0;
+        overflowed |= grid->overflowed;
+    }
+
+    printf("sweep       %7d %-9s  grid %8.3f ms/step  sweep %8.3f ms/step  %6lld circle|%-6lld box pairs  "
+           "%6lld changes/step  room %d -> %d%s\n",
+           n, names[scene], grid_time * 1e3 / steps, sap_time * 1e3 / steps, grid_pairs / steps, sap_pairs / steps,
+           changes / (steps - 1), start_room, set->capacity, overflowed ? "  (overflowed)" : "");
+
+    broadphase_pair_set_destroy(set);
+    broadphase_sap_destroy(sap);
+    pd_free(pairs);
+    broadphase_grid_destroy(grid);
+    pd_free(bounds);
+    pd_free(radii);
+    pd_free(vy);
+    pd_free(vx);
+    pd_free(y);
+    pd_free(x);
+}
+
+/* Rasterizes a whole particle world into an off-screen Playdate-layout frame */
+static void bench_raster(int n)
+{
+    ParticleWorld* world = particle_world_create(n);
+    bench_fill_world(world, n);
+
+    enum { ROW_BYTES = 52 };
+    uint8_t* pixels = (uint8_t*)pd_malloc(ROW_BYTES * SCREEN_HEIGHT);
+    RasterTarget target;
+    raster_target_init(&target, pixels, ROW_BYTES, SCREEN_WIDTH, SCREEN_HEIGHT);
+
+    int frames = MAX(10, bench_iterations(n) / 4);
+    double start = bench_now();
+    for (int i = 0; i < frames; ++i)
+    {
+        raster_target_begin(&target);
+        raster_clear_rows(&target, 0, SCREEN_HEIGHT - 1);
+        raster_fill_points(&target, world->prev_x, world->prev_y, world->x, world->y, 0.5f, world->count, 4);
+    }
+    double elapsed = bench_now() - start;
+
+    printf("raster      %7d particles  %8.3f ms/frame  %6.2f ns/particle\n",
+           n, elapsed * 1e3 / frames, elapsed * 1e9 / ((double)frames * n));
+
+    pd_free(pixels);
+    particle_world_destroy(world);
+}
+
+/* Full constraint step on a hanging cloth: gravity, integrate, solve */
+static void bench_pbd_cloth(int columns, int rows)
+{
+    int n = columns * rows;
+    ParticleWorld* world = particle_world_create(n);
+    PbdSolver* solver = pbd_solver_create(n, n * 2, 2);
+    pbd_build_cloth(solver, world, vec2_new(20.0f, 10.0f), columns, rows, 4.0f, 1.0f, 1.0f);
+    pbd_set_bounds(solver, VEC2_ZERO, vec2_new(SCREEN_WIDTH, SCREEN_HEIGHT), 1.0f);
+    ForceRegistry* forces = force_registry_create(n, 1, 0);
+    ForceField gravity = force_gravity(vec2_new(0.0f, GRAVITY));
+    force_add_field(forces, &gravity);
+
+    const float dt = (float)LOGIC_RATE;
+    int steps = 300;
+    double start = bench_now();
+    for (int i = 0; i < steps; ++i)
+    {
+        force_registry_apply(forces, world);
+        particle_world_integrate(world, dt);
+        pbd_solver_solve(solver, world, dt);
+    }
+    double elapsed = bench_now() - start;
+
+    printf("pbd cloth   %7d nodes  %6d constraints  %3d batches  %d iterations  %8.3f ms/step\n",
+           n, solver->distance_count, solver->batch_count, solver->iterations, elapsed * 1e3 / steps);
+
+    force_registry_destroy(forces);
+    pbd_solver_destroy(solver);
+    particle_world_destroy(world);
+}
+
+/*
+ * Box pyramid on a static floor, settling from rest. Reports the mean step
+ * cost, the most contacts in any step and how far the box that moved most
+ * has drifted from where it was built: a stable stack only settles by a
+ * fraction of a box, one that slides or topples moves by whole boxes. Once
+ * it has slept, nothing is still awake and steps cost next to nothing.
+ */
+static void bench_body_pyramid(int rows)
+{
+    BodyWorld* world = body_world_create(MAX_BODIES, MAX_BODY_CONTACTS);
+
+    Body floor;
+    memset(&floor, 0, sizeof(floor));
+    floor.position = vec2_new(0.5f * SCREEN_WIDTH, SCREEN_HEIGHT - 4.0f);
+    floor.friction = 0.6f;
+    floor.shape = body_shape_aabb(SCREEN_WIDTH, 8.0f);
+    body_world_add(world, &floor);
+    int boxes = body_world_build_pyramid(world, vec2_new(0.5f * SCREEN_WIDTH, SCREEN_HEIGHT - 8.0f), rows, 10.0f, 1.0f);
+
+    Vector2* built = (Vector2*)pd_malloc(sizeof(Vector2) * (size_t)world->count);
+    for (int i = 0; i < world->count; ++i)
+    {
+        built[i] = vec2_new(world->pose[i].x, world->pose[i].y);
+    }
+
+    const float dt = (float)LOGIC_RATE;
+    int steps = 600;
+    int peak_contacts = 0;
+    double start = bench_now();
+    for (int i = 0; i < steps; ++i)
+    {
+        body_world_step(world, dt);
+        peak_contacts = MAX(peak_contacts, world->manifold_count);
+    }
+    double elapsed = bench_now() - start;
+
+    float drift = 0.0f;
+    for (int i = 0; i < world->count; ++i)
+    {
+        drift = MAX(drift, vec2_distance(vec2_new(world->pose[i].x, world->pose[i].y), built[i]));
+    }
+    pd_free(built);
+
+    const ContactCache* cache = world->cache;
+    printf("bodies      %7d boxes  %6d contacts  %d iterations  %8.3f ms/step  drift %.2f px  %.0f%% reused  %d awake\n",
+           boxes, peak_contacts, world->iterations, elapsed * 1e3 / steps, (double)drift,
+           100.0 * cache->reused / MAX(cache->lookups, 1u), world->active_count);
+
+    body_world_destroy(world);
+}
+
+/*
+ * The demo scene (a swinging cloth and a settling pyramid) recorded into
+ * the rewind ring every step, then rewound all the way. Reports what a
+ * frame costs to record and to step back, its mean size, and how many
+ * seconds of history the budget holds at that size.
+ */
+static void bench_rewind(void)
+{
+    ParticleWorld* particles = particle_world_create(MAX_PARTICLES);
+    PbdSolver* solver = pbd_solver_create(MAX_PARTICLES, MAX_PBD_CONSTRAINTS, MAX_PBD_PINS);
+    BodyWorld* bodies = body_world_create(MAX_BODIES, MAX_BODY_CONTACTS);
+    RewindBuffer* history = rewind_create(REWIND_BUDGET, REWIND_MAX_FRAMES, MAX_PARTICLES, MAX_BODIES);
+    ForceRegistry* forces = force_registry_create(MAX_PARTICLES, 1, 0);
+    ForceField gravity = force_gravity(vec2_new(0.0f, GRAVITY));
+    force_add_field(forces, &gravity);
+
+    pbd_build_cloth(solver, particles, vec2_new(120.0f, 20.0f), 24, 16, 7.0f, 1.0f, 1.0f);
+    pbd_set_bounds(solver, VEC2_ZERO, vec2_new(SCREEN_WIDTH, SCREEN_HEIGHT), PARTICLE_RADIUS);
+    Body floor;
+    memset(&floor, 0, sizeof(floor));
+    floor.position = vec2_new(0.5f * SCREEN_WIDTH, SCREEN_HEIGHT - 4.0f);
+    floor.friction = 0.6f;
+    floor.shape = body_shape_aabb(SCREEN_WIDTH, 8.0f);
+    body_world_add(bodies, &floor);
+    body_world_build_pyramid(bodies, vec2_new(320.0f, SCREEN_HEIGHT - 8.0f), 12, 9.0f, 1.0f);
+
+    const float dt = (float)LOGIC_RATE;
+    int steps = REWIND_MAX_FRAMES;
+    double record_time = 0.0;
+    double bytes = 0.0;
+    for (int i = 0; i < steps; ++i)
+    {
+        force_registry_apply(forces, particles);
+        particle_world_integrate(particles, dt);
+        pbd_solver_solve(solver, particles, dt);
+        body_world_step(bodies, dt);
+
+        double start = bench_now();
+        rewind_record(history, particles, bodies);
+        record_time += bench_now() - start;
+
+        if (history->frame_count > 0)
+        {
+            int newest = (history->first_frame + history->frame_count - 1) % history->max_frames;
+            bytes += history->frame_size[newest];
+        }
+    }
+
+    int frames = history->frame_count;
+    double start = bench_now();
+    while (rewind_step_back(history, particles, bodies))
+    {
+    }
+    double rewind_time = bench_now() - start;
+
+    double frame_bytes = bytes / MAX(steps - 1, 1);
+    printf("rewind      %7d objects  %8.3f ms/record  %8.3f ms/step back  %7.0f bytes/frame  %.1f s held\n",
+           particles->count + bodies->count, record_time * 1e3 / steps, rewind_time * 1e3 / MAX(frames, 1),
+           frame_bytes, REWIND_BUDGET / MAX(frame_bytes, 1.0) * LOGIC_RATE);
+
+    force_registry_destroy(forces);
+    rewind_destroy(history);
+    body_world_destroy(bodies);
+    pbd_solver_destroy(solver);
+    particle_world_destroy(particles);
+}
+
+static void bench_allocators(int n)
+{
+    void** items = (void**)pd_malloc(sizeof(void*) * (size_t)n);
+    int rounds = MAX(1, bench_iterations(n) / 16);
+
+    // Pool: warmed up first so the measurement is the free-list fast path
+    Pool* pool = pool_create(48, 1024, 0);
+    pool_reserve(pool, n);
+    double start = bench_now();
+    for (int r = 0; r < rounds; ++r)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            items[i] = pool_alloc(pool);
+        }
+        for (int i = 0; i < n; ++i)
+        {
+            pool_free(pool, items[i]);
+        }
+    }
+    double pool_time = bench_now() - start;
+    pool_destroy(pool);
+
+    // General heap through pd_realloc
+    start = bench_now();
+    for (int r = 0; r < rounds; ++r)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            items[i] = pd_malloc(48);
+        }
+        for (int i = 0; i < n; ++i)
+        {
+            pd_free(items[i]);
+        }
+    }
+    double heap_time = bench_now() - start;
+
+    // Frame arena: n allocations then one reset
+    Arena* arena = arena_create((size_t)n * 48);
+    start = bench_now();
+    for (int r = 0; r < rounds; ++r)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            items[i] = arena_alloc(arena, 48, 8);
+        }
+        arena_reset(arena);
+    }
+    double arena_time = bench_now() - start;
+    arena_destroy(arena);
+
+    // One op is an allocation plus its release
+    double ops = (double)n * rounds;
+    printf("allocators  %7d objects    pool %8.1f  heap %8.1f  arena %8.1f  Mops/s\n",
+           n, ops / pool_time * 1e-6, ops / heap_time * 1e-6, ops / arena_time * 1e-6);
+
+    pd_free(items);
+}
+
+int main(void)
+{
+    bench_fastmath();
+
+    for (int i = 0; i < BENCH_SIZE_COUNT; ++i)
+    {
+        bench_integrate(BENCH_SIZES[i]);
+        bench_integrate_fixed(BENCH_SIZES[i]);
+    }
+    for (int i = 0; i < BENCH_SIZE_COUNT; ++i)
+    {
+        bench_forces(BENCH_SIZES[i], 0);
+        bench_forces(BENCH_SIZES[i], 4);
+        bench_forces(BENCH_SIZES[i], 16);
+    }
+    for (int i = 0; i < BENCH_SIZE_COUNT; ++i)
+    {
+        bench_kernels(BENCH_SIZES[i]);
+    }
+    for (int i = 0; i < BENCH_SIZE_COUNT; ++i)
+    {
+        bench_broadphase(BENCH_SIZES[i]);
+    }
+    // The sweep packs pair keys into 32 bits, so it tops out at 65536 items
+    bench_sweep(1000, BENCH_SCATTERED);
+    bench_sweep(1000, BENCH_STACKED);
+    bench_sweep(1000, BENCH_MIXED);
+    bench_sweep(MAX_PARTICLES, BENCH_SCATTERED);
+    bench_sweep(MAX_PARTICLES, BENCH_STACKED);
+    bench_sweep(MAX_PARTICLES, BENCH_MIXED);
+    bench_sweep(10000, BENCH_SCATTERED);
+    bench_sweep(10000, BENCH_STACKED);
+    bench_sweep(10000, BENCH_MIXED);
+    for (int i = 0; i < BENCH_SIZE_COUNT; ++i)
+    {
+        bench_raster(BENCH_SIZES[i]);
+    }
+    bench_pbd_cloth(16, 16);
+    bench_pbd_cloth(32, 24);
+    bench_pbd_cloth(64, 48);
+    bench_body_pyramid(10);
+    bench_body_pyramid(20);
+    bench_rewind();
+    for (int i = 0; i < BENCH_SIZE_COUNT; ++i)
+    {
+        bench_allocators(BENCH_SIZES[i]);
+    }
+
+    return 0;
+}
@@ -0,0 +1,164 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <time.h>
+
+#include "common.h"
+#include "memory.h"
+#include "timestep.h"
+#include "input.h"
+#include "simulation.h"
+#include "profiler.h"
+
+/*
+ * Headless replay of a session recorded on the device or simulator with
+ * PLAYSICS_RECORD_INPUT. Every frame's input goes through the same
+ * simulation_input/simulation_step calls as in the game, with no frame
+ * pacing and no rendering, so the run doubles as a reproducible
+ * performance trace of real play and as a determinism check: a finished
+ * recording carries the state hash the session ended with, and a replay
+ * that ends anywhere else exits non-zero. The hash is bitwise, so it is
+ * only checked when input_session_mismatch finds nothing in the recorded
+ * build that would round differently from this one; other sessions replay
+ * for timing.
+ *
+ *   playsics_replay input.rec [steps.csv]
+ *
+ * The optional CSV gets one line per step with its frame and time.
+ */
+
+static double replay_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int replay_compare(const void* a, const void* b)
+{
+    float x = *(const float*)a;
+    float y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+static bool replay_write_csv(const char* path, const InputSession* session, const float* step_ms)
+{
+    FILE* file = fopen(path, "w");
+    if (file == NULL)
+    {
+        fprintf(stderr, "couldn't open %s\n", path);
+        return false;
+    }
+
+    fprintf(file, "step,frame,ms\n");
+    int step = 0;
+    for (int frame = 0; frame < session->frame_count; ++frame)
+    {
+        for (int i = 0; i < session->frames[frame].steps; ++i, ++step)
+        {
+            fprintf(file, "%d,%d,%.4f\n", step, frame, step_ms[step]);
+        }
+    }
+    return fclose(file) == 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <input.rec> [steps.csv]\n", argv[0]);
+        return 2;
+    }
+
+    InputSession* session = input_session_load(argv[1]);
+    if (session == NULL)
+    {
+        return 2;
+    }
+
+    int step_count = 0;
+    for (int i = 0; i < session->frame_count; ++i)
+    {
+        step_count += session->frames[i].steps;
+    }
+
+    // Set up the way engine_init does, minus everything that draws
+    Engine engine;
+    memset(&engine, 0, sizeof(engine));
+    timestep_init(&engine.timestep, session->step, MAX_SUBSTEPS);
+    engine.frame_arena = arena_create(FRAME_ARENA_SIZE);
+    float* step_ms = (float*)malloc(sizeof(float) * (size_t)MAX(step_count, 1));
+    if (engine.frame_arena == NULL || step_ms == NULL || !simulation_init(&engine))
+    {
+        fprintf(stderr, "couldn't set up the simulation\n");
+        return 2;
+    }
+
+    double start = replay_now();
+    int step = 0;
+    for (int frame = 0; frame < session->frame_count; ++frame)
+    {
+        const InputFrame* input = &session->frames[frame];
+        pd->system->resetElapsedTime();
+        PROFILE_FRAME_BEGIN();
+        arena_reset(engine.frame_arena);
+
+        simulation_input(&engine, input);
+        for (int i = 0; i < input->steps; ++i)
+        {
+            double step_start = replay_now();
+            simulation_step(&engine);
+            step_ms[step++] = (float)((replay_now() - step_start) * 1e3);
+        }
+        PROFILE_FRAME_END();
+    }
+    double elapsed = replay_now() - start;
+    uint32_t hash = simulation_hash(&engine);
+
+    printf("replayed %d frames, %d steps (%.1f s of play) in %.3f s\n", session->frame_count, step_count,
+           (double)step_count * session->step, elapsed);
+
+    if (step_count > 0)
+    {
+        if (argc > 2 && !replay_write_csv(argv[2], session, step_ms))
+        {
+            return 2;
+        }
+
+        double sum = 0.0;
+        for (int i = 0; i < step_count; ++i)
+        {
+            sum += step_ms[i];
+        }
+        qsort(step_ms, (size_t)step_count, sizeof(float), replay_compare);
+        printf("step        %8.3f ms min  %8.3f ms mean  %8.3f ms median  %8.3f ms p99  %8.3f ms max\n",
+               step_ms[0], sum / step_count, step_ms[step_count / 2], step_ms[MIN(step_count - 1, (step_count * 99) / 100)],
+               step_ms[step_count - 1]);
+    }
+
+    int result = 0;
+    const char* mismatch;
+    if (!session->finished)
+    {
+        printf("state hash  %08x (recording unfinished, nothing to check against)\n", (unsigned)hash);
+    }
+    else if ((mismatch = input_session_mismatch(session)) != NULL)
+    {
+        printf("state hash  %08x (%s: %s, not comparable with this build)\n", (unsigned)hash, mismatch,
+               session->compiler);
+    }
+    else if (hash == session->state_hash)
+    {
+        printf("state hash  %08x matches the recording\n", (unsigned)hash);
+    }
+    else
+    {
+        printf("state hash  %08x DIFFERS from the recording's %08x\n", (unsigned)hash, (unsigned)session->state_hash);
+        result = 1;
+    }
+
+    free(step_ms);
+    simulation_destroy(&engine);
+    arena_destroy(engine.frame_arena);
+    input_session_destroy(session);
+    return result;
+}
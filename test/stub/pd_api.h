@@ -0,0 +1,69 @@
+#ifndef PD_API_STUB_H
+#define PD_API_STUB_H
+
+/*
+ * Minimal stand-in for the Playdate SDK's pd_api.h, used by the host build.
+ * Only the types and calls that the engine code built on the host touches
+ * are declared here; their signatures match the real SDK so the same sources
+ * build unchanged against either header.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdarg.h>
+
+typedef struct LCDFont LCDFont;
+typedef struct LCDBitmap LCDBitmap;
+
+typedef enum
+{
+    kButtonLeft = (1 << 0),
+    kButtonRight = (1 << 1),
+    kButtonUp = (1 << 2),
+    kButtonDown = (1 << 3),
+    kButtonB = (1 << 4),
+    kButtonA = (1 << 5),
+} PDButtons;
+
+struct playdate_sys
+{
+    void* (*realloc)(void* ptr, size_t size);
+    void (*logToConsole)(const char* fmt, ...);
+    void (*error)(const char* fmt, ...);
+    unsigned int (*getCurrentTimeMilliseconds)(void);
+    void (*getButtonState)(PDButtons* current, PDButtons* pushed, PDButtons* released);
+    float (*getCrankChange)(void);
+    int (*isCrankDocked)(void);
+    float (*getElapsedTime)(void);
+    void (*resetElapsedTime)(void);
+};
+
+typedef void SDFile;
+
+typedef enum
+{
+    kFileRead = (1 << 0),
+    kFileReadData = (1 << 1),
+    kFileWrite = (1 << 2),
+    kFileAppend = (2 << 2),
+} FileOptions;
+
+struct playdate_file
+{
+    const char* (*geterr)(void);
+    SDFile* (*open)(const char* name, FileOptions mode);
+    int (*close)(SDFile* file);
+    int (*read)(SDFile* file, void* buf, unsigned int len);
+    int (*write)(SDFile* file, const void* buf, unsigned int len);
+    int (*flush)(SDFile* file);
+    int (*tell)(SDFile* file);
+    int (*seek)(SDFile* file, int pos, int whence);
+};
+
+typedef struct PlaydateAPI
+{
+    const struct playdate_sys* system;
+    const struct playdate_file* file;
+} PlaydateAPI;
+
+#endif /* PD_API_STUB_H */
@@ -0,0 +1,180 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "pd_api.h"
+
+/* ========================================================================== */
+/* SYSTEM                                                                     */
+/* ========================================================================== */
+
+static double stub_clock_start = 0.0;
+
+static double stub_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* Same contract as the SDK: size 0 frees, NULL ptr allocates */
+static void* stub_realloc(void* ptr, size_t size)
+{
+    if (size == 0)
+    {
+        free(ptr);
+        return NULL;
+    }
+    return realloc(ptr, size);
+}
+
+static void stub_log_to_console(const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+    putchar('\n');
+}
+
+static void stub_error(const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fputc('\n', stderr);
+}
+
+static unsigned int stub_get_current_time_milliseconds(void)
+{
+    return (unsigned int)(stub_now() * 1000.0);
+}
+
+/* No buttons are ever held and the crank stays docked */
+static void stub_get_button_state(PDButtons* current, PDButtons* pushed, PDButtons* released)
+{
+    *current = 0;
+    *pushed = 0;
+    *released = 0;
+}
+
+static float stub_get_crank_change(void)
+{
+    return 0.0f;
+}
+
+static int stub_is_crank_docked(void)
+{
+    return 1;
+}
+
+static float stub_get_elapsed_time(void)
+{
+    return (float)(stub_now() - stub_clock_start);
+}
+
+static void stub_reset_elapsed_time(void)
+{
+    stub_clock_start = stub_now();
+}
+
+static const struct playdate_sys stub_system = {
+    .realloc = stub_realloc,
+    .logToConsole = stub_log_to_console,
+    .error = stub_error,
+    .getCurrentTimeMilliseconds = stub_get_current_time_milliseconds,
+    .getButtonState = stub_get_button_state,
+    .getCrankChange = stub_get_crank_change,
+    .isCrankDocked = stub_is_crank_docked,
+    .getElapsedTime = stub_get_elapsed_time,
+    .resetElapsedTime = stub_reset_elapsed_time,
+};
+
+/* ========================================================================== */
+/* FILE                                                                       */
+/* ========================================================================== */
+
+/* Paths are relative to the working directory rather than the game's data folder */
+static const char* stub_file_error = NULL;
+
+static const char* stub_geterr(void)
+{
+    return stub_file_error;
+}
+
+static SDFile* stub_open(const char* name, FileOptions mode)
+{
+    const char* fmode = (mode & kFileAppend) ? "ab" : (mode & kFileWrite) ? "wb" : "rb";
+    FILE* file = fopen(name, fmode);
+    if (file == NULL)
+    {
+        stub_file_error = strerror(errno);
+    }
+    return file;
+}
+
+static int stub_close(SDFile* file)
+{
+    return fclose((FILE*)file) == 0 ? 0 : -1;
+}
+
+static int stub_read(SDFile* file, void* buf, unsigned int len)
+{
+    size_t count = fread(buf, 1, len, (FILE*)file);
+    if (count < len && ferror((FILE*)file))
+    {
+        stub_file_error = strerror(errno);
+        return -1;
+    }
+    return (int)count;
+}
+
+static int stub_write(SDFile* file, const void* buf, unsigned int len)
+{
+    size_t count = fwrite(buf, 1, len, (FILE*)file);
+    if (count < len)
+    {
+        stub_file_error = strerror(errno);
+        return -1;
+    }
+    return (int)count;
+}
+
+static int stub_flush(SDFile* file)
+{
+    return fflush((FILE*)file) == 0 ? 0 : -1;
+}
+
+static int stub_tell(SDFile* file)
+{
+    return (int)ftell((FILE*)file);
+}
+
+static int stub_seek(SDFile* file, int pos, int whence)
+{
+    return fseek((FILE*)file, pos, whence) == 0 ? 0 : -1;
+}
+
+static const struct playdate_file stub_file = {
+    .geterr = stub_geterr,
+    .open = stub_open,
+    .close = stub_close,
+    .read = stub_read,
+    .write = stub_write,
+    .flush = stub_flush,
+    .tell = stub_tell,
+    .seek = stub_seek,
+};
+
+static PlaydateAPI stub_api = {
+    .system = &stub_system,
+    .file = &stub_file,
+};
+
+/* Playdate API instance, normally set by eventHandler in main.c */
+PlaydateAPI* pd = &stub_api;